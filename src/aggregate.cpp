@@ -1,16 +1,28 @@
 #include "aggregate.hpp"
+#include "catalog.hpp"
 #include "common.hpp"
+#include "expr.hpp"
 #include "iter.hpp"
 #include "op.hpp"
+#include "os.hpp"
+#include "page.hpp"
+#include "parallel.hpp"
+#include "row.hpp"
+#include "scheduler.hpp"
 #include "sort.hpp"
+#include "temp.hpp"
+#include "type.hpp"
 #include "value.hpp"
 
 #include <algorithm>
 #include <cstddef>
 #include <memory>
 #include <optional>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <variant>
+#include <vector>
 
 void Aggregator::Init()
 {
@@ -119,6 +131,218 @@ ColumnValue Aggregator::Get(Function function)
     UNREACHABLE();
 }
 
+// other value is combined with value, NULL means that no values were aggregated
+template <typename Combine>
+static void MergeColumnValue(ColumnValue& value, const ColumnValue& other, Combine combine)
+{
+    if (other.index() == 0)
+    {
+        return;
+    }
+    if (value.index() == 0)
+    {
+        value = other;
+        return;
+    }
+    value = std::visit(
+        Overload{
+            [](const ColumnValueNull&) -> ColumnValue { UNREACHABLE(); },
+            [](const ColumnValueBoolean&) -> ColumnValue { UNREACHABLE(); },
+            [&value, &combine]<typename T>(const T& other_value) -> ColumnValue
+            { return combine(std::get<T>(value), other_value); },
+        },
+        other);
+}
+
+void Aggregator::Merge(const Aggregator& other)
+{
+    MergeColumnValue(min_, other.min_,
+                     []<typename T>(const T& a, const T& b) -> ColumnValue
+                     {
+                         if constexpr (std::is_same_v<T, ColumnValueVarchar>)
+                         {
+                             return CompareStrings(b, a) < 0 ? b : a;
+                         }
+                         else
+                         {
+                             return std::min(a, b);
+                         }
+                     });
+    MergeColumnValue(max_, other.max_,
+                     []<typename T>(const T& a, const T& b) -> ColumnValue
+                     {
+                         if constexpr (std::is_same_v<T, ColumnValueVarchar>)
+                         {
+                             return CompareStrings(b, a) > 0 ? b : a;
+                         }
+                         else
+                         {
+                             return std::max(a, b);
+                         }
+                     });
+    MergeColumnValue(sum_, other.sum_,
+                     []<typename T>(const T& a, const T& b) -> ColumnValue
+                     {
+                         if constexpr (std::is_same_v<T, ColumnValueVarchar>)
+                         {
+                             UNREACHABLE();
+                         }
+                         else
+                         {
+                             return a + b;
+                         }
+                     });
+    count_ += other.count_;
+}
+
+std::size_t Aggregator::GetStateSize(Function function)
+{
+    return function == Function::kAvg ? 2 : 1;
+}
+
+void Aggregator::Save(Function function, Value& value) const
+{
+    switch (function)
+    {
+    case Function::kAvg:
+        value.push_back(sum_);
+        value.emplace_back(count_);
+        return;
+    case Function::kMax:
+        value.push_back(max_);
+        return;
+    case Function::kMin:
+        value.push_back(min_);
+        return;
+    case Function::kSum:
+        value.push_back(sum_);
+        return;
+    case Function::kCount:
+        value.emplace_back(count_);
+        return;
+    }
+    UNREACHABLE();
+}
+
+void Aggregator::Load(Function function, const Value& value, std::size_t offset)
+{
+    Init();
+    switch (function)
+    {
+    case Function::kAvg:
+        sum_   = value.at(offset);
+        count_ = std::get<ColumnValueInteger>(value.at(offset + 1));
+        return;
+    case Function::kMax:
+        max_ = value.at(offset);
+        return;
+    case Function::kMin:
+        min_ = value.at(offset);
+        return;
+    case Function::kSum:
+        sum_ = value.at(offset);
+        return;
+    case Function::kCount:
+        count_ = std::get<ColumnValueInteger>(value.at(offset));
+        return;
+    }
+    UNREACHABLE();
+}
+
+static AggregateGroup CreateGroup(const Aggregates& aggregates)
+{
+    AggregateGroup group{.aggregators = std::vector<Aggregator>(aggregates.exprs.size()),
+                         .count       = 0};
+    for (Aggregator& aggregator : group.aggregators)
+    {
+        aggregator.Init();
+    }
+    return group;
+}
+
+static std::size_t GetGroupMemorySize(const Aggregates& aggregates, const Value& key)
+{
+    return ValueMemorySize(key) + sizeof(AggregateGroup) +
+           (aggregates.exprs.size() * sizeof(Aggregator));
+}
+
+static Value GetKey(const Aggregates& aggregates, const Value& value)
+{
+    Value key;
+    key.reserve(aggregates.group_by.size());
+    for (const ColumnId column_id : aggregates.group_by)
+    {
+        key.push_back(value.at(column_id.Get()));
+    }
+    return key;
+}
+
+static void FeedAggregators(const Aggregates& aggregates, std::vector<Aggregator>& aggregators,
+                            const Value& value)
+{
+    for (std::size_t i = 0; i < aggregates.exprs.size(); i++)
+    {
+        if (aggregates.exprs[i].arg)
+        {
+            const ColumnValue column_value = aggregates.exprs[i].arg->Eval(&value);
+            aggregators[i].Feed(column_value);
+        }
+    }
+}
+
+// appends aggregated values to group key
+static Value GetResult(const Aggregates& aggregates, std::vector<Aggregator>& aggregators,
+                       ColumnValueInteger count, Value key)
+{
+    Value result = std::move(key);
+    for (std::size_t i = 0; i < aggregates.exprs.size(); i++)
+    {
+        if (aggregates.exprs[i].arg)
+        {
+            result.push_back(aggregators[i].Get(aggregates.exprs[i].function));
+        }
+        else
+        {
+            result.emplace_back(count);
+        }
+    }
+    return result;
+}
+
+// partial state: keys, states of aggregators with argument, row count
+static Value GetPartialState(const Aggregates& aggregates, const Value& key,
+                             const AggregateGroup& group)
+{
+    Value state = key;
+    for (std::size_t i = 0; i < aggregates.exprs.size(); i++)
+    {
+        if (aggregates.exprs[i].arg)
+        {
+            group.aggregators[i].Save(aggregates.exprs[i].function, state);
+        }
+    }
+    state.emplace_back(group.count);
+    return state;
+}
+
+static void MergePartialState(const Aggregates& aggregates, const Value& state,
+                              AggregateGroup& group)
+{
+    std::size_t offset = aggregates.group_by.size();
+    Aggregator  partial;
+    for (std::size_t i = 0; i < aggregates.exprs.size(); i++)
+    {
+        if (aggregates.exprs[i].arg)
+        {
+            const Function function = aggregates.exprs[i].function;
+            partial.Load(function, state, offset);
+            group.aggregators[i].Merge(partial);
+            offset += Aggregator::GetStateSize(function);
+        }
+    }
+    group.count += std::get<ColumnValueInteger>(state.at(offset));
+}
+
 static Iter CreateIter(Iter&& parent, const Aggregates& aggregates)
 {
     if (!aggregates.group_by.empty())
@@ -141,7 +365,14 @@ IterAggregate::IterAggregate(Iter&& parent, Aggregates&& aggregates)
 
 void IterAggregate::Open()
 {
-    done_ = false;
+    // state of previous execution is dropped, since plan may be opened again
+    current_key_.reset();
+    for (Aggregator& aggregator : aggregators_)
+    {
+        aggregator.Init();
+    }
+    count_ = 0;
+    done_  = false;
     parent_->Open();
 }
 
@@ -192,19 +423,7 @@ std::optional<std::optional<Value>> IterAggregate::Feed(const Aggregates::GroupB
     if (should_return_value)
     {
         ASSERT(current_key_);
-        Value result_value = std::move(*current_key_);
-        for (std::size_t i = 0; i < aggregates_.exprs.size(); i++)
-        {
-            if (aggregates_.exprs[i].arg)
-            {
-                result_value.push_back(aggregators_[i].Get(aggregates_.exprs[i].function));
-            }
-            else
-            {
-                result_value.emplace_back(count_);
-            }
-        }
-        result = {result_value};
+        result = {GetResult(aggregates_, aggregators_, count_, std::move(*current_key_))};
     }
 
     if (should_init)
@@ -223,14 +442,7 @@ std::optional<std::optional<Value>> IterAggregate::Feed(const Aggregates::GroupB
     if (should_feed)
     {
         ASSERT(value);
-        for (std::size_t i = 0; i < aggregates_.exprs.size(); i++)
-        {
-            if (aggregates_.exprs[i].arg)
-            {
-                const ColumnValue column_value = aggregates_.exprs[i].arg->Eval(&*value);
-                aggregators_[i].Feed(column_value);
-            }
-        }
+        FeedAggregators(aggregates_, aggregators_, *value);
         count_++;
     }
 
@@ -273,29 +485,469 @@ std::optional<Value> IterAggregate::Next()
             {
                 break;
             }
-            for (std::size_t i = 0; i < aggregates_.exprs.size(); i++)
+            FeedAggregators(aggregates_, aggregators_, *value);
+            count_++;
+        }
+        done_ = true;
+        return GetResult(aggregates_, aggregators_, count_, Value{});
+    }
+}
+
+std::string IterAggregate::GetName() const
+{
+    return "Aggregate";
+}
+
+std::vector<Iter*> IterAggregate::GetInputs()
+{
+    return {&parent_};
+}
+
+IterAggregateHash::IterAggregateHash(Iter&& parent, Aggregates&& aggregates, bool merge,
+                                     unsigned int level)
+    : IterBase{parent->type}, parent_{std::move(parent)}, aggregates_{std::move(aggregates)},
+      merge_{merge}, level_{level}
+{
+    ASSERT(!aggregates_.group_by.empty());
+}
+
+void IterAggregateHash::Open()
+{
+    parent_->Open();
+    Start();
+}
+
+void IterAggregateHash::Restart()
+{
+    if (!spilled_)
+    {
+        // all groups are still in hash table
+        group_ = table_.begin();
+        return;
+    }
+    parent_->Restart();
+    Start();
+}
+
+void IterAggregateHash::Close()
+{
+    parent_->Close();
+    table_.clear();
+    partitions_.clear();
+    partition_.reset();
+}
+
+std::optional<Value> IterAggregateHash::Next()
+{
+    while (group_ == table_.end())
+    {
+        if (!NextPartition())
+        {
+            return std::nullopt;
+        }
+    }
+    auto& [key, group] = *group_++;
+    return GetResult(aggregates_, group.aggregators, group.count, key);
+}
+
+std::string IterAggregateHash::GetName() const
+{
+    return merge_ ? "Hash Aggregate (merge)" : "Hash Aggregate";
+}
+
+std::vector<Iter*> IterAggregateHash::GetInputs()
+{
+    return {&parent_};
+}
+
+void IterAggregateHash::Start()
+{
+    partitions_.clear();
+    partition_.reset();
+    spilled_ = false;
+    Build(nullptr);
+}
+
+bool IterAggregateHash::NextPartition()
+{
+    if (partitions_.empty())
+    {
+        // groups of last partition are kept for Restart if input was not spilled
+        return false;
+    }
+    partition_.reset();
+    partition_.emplace(std::move(partitions_.back()));
+    partitions_.pop_back();
+    Build(&*partition_);
+    return true;
+}
+
+// reads rows from parent or from partition, rows of groups which don't fit in memory are spilled
+void IterAggregateHash::Build(const Partition* partition)
+{
+    table_.clear();
+
+    const Type&        type  = parent_->type;
+    const page::Offset align = type.GetAlign();
+    const unsigned int level = partition ? partition->level : level_;
+
+    temp::Input input;
+    if (partition)
+    {
+        input.Init(partition->file, page::Id{}, partition->page_count);
+    }
+
+    std::vector<Partition>    partitions;
+    std::vector<temp::Output> outputs;
+    std::size_t               table_size = 0;
+
+    for (;;)
+    {
+        std::optional<Value> value;
+        if (partition)
+        {
+            page::Offset    size = 0;
+            const U8* const row  = input.Next(size);
+            if (row != nullptr)
             {
-                if (aggregates_.exprs[i].arg)
+                value = row::Read(type, row);
+            }
+        }
+        else
+        {
+            value = parent_->Next();
+        }
+        if (!value)
+        {
+            break;
+        }
+
+        Value key  = GetKey(aggregates_, *value);
+        auto  iter = table_.find(key);
+        if (iter == table_.end())
+        {
+            if (!outputs.empty())
+            {
+                outputs[temp::GetPartition(key, level)].Append(*value, align);
+                continue;
+            }
+            table_size += GetGroupMemorySize(aggregates_, key);
+            iter = table_.emplace(std::move(key), CreateGroup(aggregates_)).first;
+            if (table_size > temp::kWorkMemory && level < temp::kPartitionLevelMax)
+            {
+                // groups in table are completed in memory, rows of new groups are spilled
+                spilled_ = true;
+                partitions.resize(temp::kPartitionCount);
+                outputs.reserve(temp::kPartitionCount);
+                for (Partition& spilled : partitions)
                 {
-                    const ColumnValue column_value = aggregates_.exprs[i].arg->Eval(&*value);
-                    aggregators_[i].Feed(column_value);
+                    spilled.level = level + 1;
+                    outputs.emplace_back(spilled.file);
                 }
             }
-            count_++;
         }
-        Value result;
-        for (std::size_t i = 0; i < aggregates_.exprs.size(); i++)
+        if (merge_)
+        {
+            MergePartialState(aggregates_, *value, iter->second);
+        }
+        else
+        {
+            FeedAggregators(aggregates_, iter->second.aggregators, *value);
+            iter->second.count++;
+        }
+    }
+
+    for (unsigned int i = 0; i < outputs.size(); i++)
+    {
+        partitions[i].page_count = outputs[i].EndSection().second;
+        if (partitions[i].page_count > 0)
+        {
+            partitions_.push_back(std::move(partitions[i]));
+        }
+    }
+
+    group_ = table_.begin();
+}
+
+static Type CreatePartialType(const Type& table_type, const Aggregates& aggregates)
+{
+    Type type;
+    for (const ColumnId column_id : aggregates.group_by)
+    {
+        type.Push(table_type.At(column_id.Get()));
+    }
+    for (const Aggregates::Aggregate& aggregate : aggregates.exprs)
+    {
+        if (!aggregate.arg)
+        {
+            continue;
+        }
+        switch (aggregate.function)
+        {
+        case Function::kAvg:
+            type.Push(aggregate.arg->type.value_or(ColumnType::kInteger)); // sum
+            type.Push(ColumnType::kInteger);                               // count
+            break;
+        case Function::kMax:
+        case Function::kMin:
+        case Function::kSum:
+            type.Push(aggregate.arg->type.value_or(ColumnType::kInteger));
+            break;
+        case Function::kCount:
+            type.Push(ColumnType::kInteger);
+            break;
+        }
+    }
+    type.Push(ColumnType::kInteger); // row count
+    return type;
+}
+
+// partial states are grouped by keys, aggregators read their states
+static Aggregates CreateMergeAggregates(const Aggregates& aggregates)
+{
+    Aggregates  merge;
+    std::size_t offset = aggregates.group_by.size();
+    for (ColumnId column_id{}; column_id < aggregates.group_by.size(); column_id++)
+    {
+        merge.group_by.push_back(column_id);
+    }
+    for (const Aggregates::Aggregate& aggregate : aggregates.exprs)
+    {
+        ExprPtr arg;
+        if (aggregate.arg)
         {
-            if (aggregates_.exprs[i].arg)
+            arg = std::make_unique<Expr>(Expr::DataColumn{ColumnId(offset)}, aggregate.arg->type);
+            offset += Aggregator::GetStateSize(aggregate.function);
+        }
+        merge.exprs.push_back({.function = aggregate.function, .arg = std::move(arg)});
+    }
+    return merge;
+}
+
+IterAggregateParallel::IterAggregateParallel(catalog::FileIds file_ids, const Type& table_type,
+                                             std::vector<ColumnId>&& columns, ExprPtr&& filter,
+                                             Aggregates&& aggregates, unsigned int worker_count)
+    : IterBase{table_type}, file_ids_{file_ids}, table_type_{table_type},
+      partial_type_{CreatePartialType(table_type, aggregates)}, columns_{std::move(columns)},
+      filter_{std::move(filter)}, aggregates_{std::move(aggregates)}, worker_count_{worker_count}
+{
+    ASSERT(!aggregates_.group_by.empty());
+    ASSERT(worker_count_ > 0);
+}
+
+void IterAggregateParallel::Open()
+{
+    morsels_.emplace(file_ids_);
+    workers_.clear();
+    for (unsigned int i = 0; i < worker_count_; i++)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+
+    {
+        scheduler::TaskGroup tasks;
+        for (const std::unique_ptr<Worker>& worker : workers_)
+        {
+            tasks.Submit([this, &worker = *worker, &tasks] { Run(worker, tasks); });
+        }
+        tasks.Wait();
+    }
+
+    // if some worker spilled, groups are merged in partitions
+    const bool spilled = std::ranges::any_of(workers_, [](const std::unique_ptr<Worker>& worker)
+                                             { return !worker->partitions.empty(); });
+    partition_count_ = spilled ? temp::kPartitionCount : 1;
+
+    Type partial_type = partial_type_;
+    auto reader       = std::make_unique<Reader>(workers_, aggregates_, std::move(partial_type));
+    reader_           = reader.get();
+    merge_            = std::make_unique<IterAggregateHash>(
+        std::move(reader), CreateMergeAggregates(aggregates_), true, spilled ? 1 : 0);
+    partition_ = 0;
+    StartPartition();
+}
+
+void IterAggregateParallel::Restart()
+{
+    merge_->Close();
+    partition_ = 0;
+    StartPartition();
+}
+
+void IterAggregateParallel::Close()
+{
+    merge_.reset();
+    reader_ = nullptr;
+    workers_.clear();
+    morsels_.reset();
+}
+
+std::optional<Value> IterAggregateParallel::Next()
+{
+    for (;;)
+    {
+        std::optional<Value> value = merge_->Next();
+        if (value)
+        {
+            return value;
+        }
+        merge_->Close();
+        if (++partition_ == partition_count_)
+        {
+            return std::nullopt;
+        }
+        StartPartition();
+    }
+}
+
+std::string IterAggregateParallel::GetName() const
+{
+    return "Parallel Hash Aggregate " + catalog::GetFileName(file_ids_.dat) + " (" +
+           std::to_string(worker_count_) + " workers)";
+}
+
+void IterAggregateParallel::StartPartition()
+{
+    reader_->SetPartition(partition_count_ > 1 ? std::optional{partition_} : std::nullopt);
+    merge_->Open();
+}
+
+// runs in worker thread, must not use buffer or catalog
+void IterAggregateParallel::Run(Worker& worker, const scheduler::TaskGroup& tasks)
+{
+    const std::size_t table_size_max = temp::kWorkMemory / worker_count_;
+    std::size_t       table_size     = 0;
+    parallel::Reader  reader{morsels_->GetFileName(), table_type_, columns_};
+    page::Id          begin;
+    page::Id          end;
+    while (!tasks.IsCancelled() && morsels_->Next(begin, end))
+    {
+        reader.Seek(begin, end);
+        for (;;)
+        {
+            const std::optional<Value> value = reader.Next();
+            if (!value)
             {
-                result.push_back(aggregators_[i].Get(aggregates_.exprs[i].function));
+                break;
             }
-            else
+            if (filter_ && std::get<ColumnValueBoolean>(filter_->Eval(&*value)) != Bool::kTrue)
             {
-                result.emplace_back(count_);
+                continue;
             }
+            Value key  = GetKey(aggregates_, *value);
+            auto  iter = worker.table.find(key);
+            if (iter == worker.table.end())
+            {
+                if (table_size > table_size_max)
+                {
+                    Spill(worker);
+                    table_size = 0;
+                }
+                table_size += GetGroupMemorySize(aggregates_, key);
+                iter = worker.table.emplace(std::move(key), CreateGroup(aggregates_)).first;
+            }
+            FeedAggregators(aggregates_, iter->second.aggregators, *value);
+            iter->second.count++;
         }
-        done_ = true;
-        return result;
     }
+    for (unsigned int i = 0; i < worker.outputs.size(); i++)
+    {
+        worker.partitions[i].page_count = worker.outputs[i].EndSection().second;
+    }
+    worker.outputs.clear();
+}
+
+void IterAggregateParallel::Spill(Worker& worker) const
+{
+    if (worker.partitions.empty())
+    {
+        worker.partitions.resize(temp::kPartitionCount);
+        worker.outputs.reserve(temp::kPartitionCount);
+        for (const Partition& partition : worker.partitions)
+        {
+            worker.outputs.emplace_back(partition.file);
+        }
+    }
+    const page::Offset align = partial_type_.GetAlign();
+    for (const auto& [key, group] : worker.table)
+    {
+        const Value state = GetPartialState(aggregates_, key, group);
+        worker.outputs[temp::GetPartition(key, 0)].Append(state, align);
+    }
+    worker.table.clear();
+}
+
+IterAggregateParallel::Reader::Reader(const std::vector<std::unique_ptr<Worker>>& workers,
+                                      const Aggregates& aggregates, Type&& type)
+    : IterBase{std::move(type)}, workers_{&workers}, aggregates_{&aggregates}
+{
+}
+
+void IterAggregateParallel::Reader::Open()
+{
+    worker_index_ = 0;
+    reading_file_ = false;
+    if (!workers_->empty())
+    {
+        group_ = workers_->front()->table.cbegin();
+    }
+}
+
+void IterAggregateParallel::Reader::Restart()
+{
+    Open();
+}
+
+void IterAggregateParallel::Reader::Close()
+{
+}
+
+void IterAggregateParallel::Reader::SetPartition(std::optional<unsigned int> partition)
+{
+    partition_ = partition;
+}
+
+std::optional<Value> IterAggregateParallel::Reader::Next()
+{
+    while (worker_index_ < workers_->size())
+    {
+        const Worker& worker = *(*workers_)[worker_index_];
+        if (!reading_file_)
+        {
+            while (group_ != worker.table.cend())
+            {
+                const auto& [key, group] = *group_++;
+                if (!partition_ || temp::GetPartition(key, 0) == *partition_)
+                {
+                    return GetPartialState(*aggregates_, key, group);
+                }
+            }
+            if (partition_ && !worker.partitions.empty())
+            {
+                const Partition& partition = worker.partitions[*partition_];
+                input_.Init(partition.file, page::Id{}, partition.page_count);
+                reading_file_ = true;
+            }
+        }
+        if (reading_file_)
+        {
+            page::Offset    size = 0;
+            const U8* const row  = input_.Next(size);
+            if (row != nullptr)
+            {
+                return row::Read(type, row);
+            }
+            reading_file_ = false;
+        }
+        if (++worker_index_ < workers_->size())
+        {
+            group_ = (*workers_)[worker_index_]->table.cbegin();
+        }
+    }
+    return std::nullopt;
+}
+
+std::string IterAggregateParallel::Reader::GetName() const
+{
+    return "Partial Groups";
 }
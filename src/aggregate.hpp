@@ -1,10 +1,22 @@
 #pragma once
 
+#include "catalog.hpp"
+#include "expr.hpp"
 #include "iter.hpp"
 #include "op.hpp"
+#include "os.hpp"
+#include "page.hpp"
+#include "parallel.hpp"
+#include "scheduler.hpp"
+#include "temp.hpp"
+#include "type.hpp"
 #include "value.hpp"
 
+#include <cstddef>
+#include <memory>
 #include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 class Aggregator
@@ -12,8 +24,14 @@ class Aggregator
 public:
     void        Init();
     void        Feed(const ColumnValue& value);
+    void        Merge(const Aggregator& other); // as if values fed to other were fed here
     ColumnValue Get(Function function);
 
+    // partial state stored in columns, only what function needs (AVG is sum and count)
+    static std::size_t GetStateSize(Function function);
+    void               Save(Function function, Value& value) const;
+    void               Load(Function function, const Value& value, std::size_t offset);
+
 private:
     ColumnValue        min_;
     ColumnValue        max_;
@@ -33,6 +51,16 @@ struct Aggregates
     GroupBy                group_by;
 };
 
+// aggregated values of one group, count is used by COUNT(*)
+struct AggregateGroup
+{
+    std::vector<Aggregator> aggregators;
+    ColumnValueInteger      count;
+};
+
+using AggregateTable = std::unordered_map<Value, AggregateGroup, ValueHasher, ValueEqualTo>;
+
+// input is sorted by group by columns, so groups are emitted in order of their keys
 class IterAggregate : public IterBase
 {
 public:
@@ -43,6 +71,8 @@ public:
     void                 Restart() override;
     void                 Close() override;
     std::optional<Value> Next() override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
 
 private:
     std::optional<std::optional<Value>> Feed(const Aggregates::GroupBy&  group_by,
@@ -56,3 +86,130 @@ private:
     ColumnValueInteger      count_ = 0;
     bool                    done_  = false;
 };
+
+// Groups are stored in hash table by key. If the table does not fit in work memory, rows of new
+// groups are partitioned by key hash to temporary files, and the partitions are aggregated one
+// by one after the groups in memory are emitted.
+class IterAggregateHash : public IterBase
+{
+public:
+    // if merge is set, input rows are partial states of groups (see IterAggregateParallel),
+    // level is set if input is already a partition
+    IterAggregateHash(Iter&& parent, Aggregates&& aggregates, bool merge = false,
+                      unsigned int level = 0);
+    ~IterAggregateHash() override = default;
+
+    void                 Open() override;
+    void                 Restart() override;
+    void                 Close() override;
+    std::optional<Value> Next() override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
+
+private:
+    using Group = AggregateGroup;
+    using Table = AggregateTable;
+
+    struct Partition
+    {
+        os::TempFile file;
+        page::Id     page_count;
+        unsigned int level;
+    };
+
+    void Start();
+    bool NextPartition();
+    void Build(const Partition* partition);
+
+    Iter               parent_;
+    const Aggregates   aggregates_;
+    const bool         merge_;
+    const unsigned int level_;
+
+    Table                    table_;
+    Table::iterator          group_;
+    std::vector<Partition>   partitions_;
+    std::optional<Partition> partition_; // currently aggregated partition
+    bool                     spilled_ = false;
+};
+
+// Rows of table are aggregated by tasks of scheduler, which claim pages in morsels. Each task has
+// its own hash table of partial states of groups, which is partitioned by key hash to its own
+// temporary files whenever it exceeds task's share of work memory. Partial states are then
+// merged partition by partition.
+class IterAggregateParallel : public IterBase
+{
+public:
+    IterAggregateParallel(catalog::FileIds file_ids, const Type& table_type,
+                          std::vector<ColumnId>&& columns, ExprPtr&& filter,
+                          Aggregates&& aggregates, unsigned int worker_count);
+    ~IterAggregateParallel() override = default;
+
+    void                 Open() override;
+    void                 Restart() override;
+    void                 Close() override;
+    std::optional<Value> Next() override;
+    std::string          GetName() const override;
+
+private:
+    using Group = AggregateGroup;
+    using Table = AggregateTable;
+
+    struct Partition
+    {
+        os::TempFile file;
+        page::Id     page_count{};
+    };
+
+    struct Worker
+    {
+        Table                     table;
+        std::vector<Partition>    partitions; // empty if table was never spilled
+        std::vector<temp::Output> outputs;
+    };
+
+    // reads partial states of one partition from all workers (keys, aggregators, row count)
+    class Reader : public IterBase
+    {
+    public:
+        Reader(const std::vector<std::unique_ptr<Worker>>& workers, const Aggregates& aggregates,
+               Type&& type);
+        ~Reader() override = default;
+
+        void                 Open() override;
+        void                 Restart() override;
+        void                 Close() override;
+        std::optional<Value> Next() override;
+        std::string          GetName() const override;
+
+        void SetPartition(std::optional<unsigned int> partition);
+
+    private:
+        const std::vector<std::unique_ptr<Worker>>* workers_;
+        const Aggregates*                           aggregates_;
+        std::optional<unsigned int>                 partition_; // all if not set
+
+        std::size_t           worker_index_ = 0;
+        Table::const_iterator group_;
+        bool                  reading_file_ = false;
+        temp::Input           input_;
+    };
+
+    void Run(Worker& worker, const scheduler::TaskGroup& tasks);
+    void Spill(Worker& worker) const;
+    void StartPartition();
+
+    const catalog::FileIds      file_ids_;
+    const Type                  table_type_, partial_type_; // table columns read
+    const std::vector<ColumnId> columns_;                   // of table which are read, all if empty
+    const ExprPtr               filter_;
+    const Aggregates            aggregates_;
+    const unsigned int          worker_count_;
+
+    std::optional<parallel::Morsels>     morsels_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    Iter         merge_;            // IterAggregateHash over reader
+    Reader*      reader_ = nullptr; // owned by merge_
+    unsigned int partition_count_ = 0, partition_ = 0;
+};
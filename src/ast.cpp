@@ -23,6 +23,7 @@ std::string AstExpr::ToString() const
     return std::visit(
         Overload{
             [](const DataConstant& expr) { return ColumnValueToString(expr.value, true); },
+            [](const DataParameter& expr) { return "$" + std::to_string(expr.index + 1); },
             [](const DataColumn& expr) { return expr.ToString(); },
             [](const DataCast& expr) {
                 return "CAST(" + expr.expr->ToString() + " AS " +
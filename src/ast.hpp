@@ -21,6 +21,10 @@ struct AstExpr
     {
         ColumnValue value;
     };
+    struct DataParameter
+    {
+        unsigned int index; // $1 has index zero
+    };
     struct DataColumn
     {
         std::optional<SourceText> table;
@@ -61,8 +65,8 @@ struct AstExpr
         AstExprPtr arg;
     };
 
-    using Data = std::variant<DataConstant, DataColumn, DataCast, DataOp1, DataOp2, DataBetween,
-                              DataIn, DataFunction>;
+    using Data = std::variant<DataConstant, DataParameter, DataColumn, DataCast, DataOp1, DataOp2,
+                              DataBetween, DataIn, DataFunction>;
 
     Data       data;
     SourceText text;
@@ -170,6 +174,13 @@ struct AstCreateTable
     catalog::NamedColumns columns;
 };
 
+struct AstCreateIndex
+{
+    SourceText name;
+    SourceText table;
+    SourceText column;
+};
+
 struct AstDropTable
 {
     SourceText name;
@@ -177,8 +188,14 @@ struct AstDropTable
 
 struct AstInsertValue
 {
-    SourceText              table;
-    std::vector<AstExprPtr> exprs;
+    SourceText                           table;
+    std::vector<std::vector<AstExprPtr>> rows;
+};
+
+struct AstInsertQuery
+{
+    SourceText table;
+    AstQuery   query;
 };
 
 struct AstUpdate
@@ -194,5 +211,42 @@ struct AstDelete
     AstExprPtr condition_opt;
 };
 
+struct AstAnalyze
+{
+    std::optional<SourceText> table; // all tables if not given
+};
+
+struct AstExplain
+{
+    AstQuery query;
+    bool     analyze; // query is executed
+};
+
+struct AstPrepare
+{
+    SourceText name;
+    SourceText statement; // INSERT, SELECT or DELETE
+};
+
+struct AstExecute
+{
+    SourceText              name;
+    std::vector<AstExprPtr> args;
+};
+
+struct AstDeallocate
+{
+    SourceText name;
+};
+
+struct AstCopy
+{
+    SourceText                table;
+    std::string               file_name;
+    std::optional<SourceText> format; // CSV if not given
+};
+
 using AstStatement =
-    std::variant<AstCreateTable, AstDropTable, AstInsertValue, AstQuery, AstUpdate, AstDelete>;
+    std::variant<AstCreateTable, AstCreateIndex, AstDropTable, AstInsertValue, AstInsertQuery,
+                 AstQuery, AstUpdate, AstDelete, AstAnalyze, AstExplain, AstPrepare, AstExecute,
+                 AstDeallocate, AstCopy>;
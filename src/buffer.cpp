@@ -13,6 +13,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 
@@ -54,6 +55,8 @@ static std::unordered_map<Id, FrameId, IdHash> ids_used;
 static std::list<FrameId>                                        free_list;
 static std::unordered_map<FrameId, std::list<FrameId>::iterator> free_list_iters;
 
+static Stats stats;
+
 static std::unordered_map<catalog::FileId, std::string> file_name_cache; // TODO: limit cache
 static const std::string& GetFileName(catalog::FileId file_id, bool assert_cached)
 {
@@ -75,7 +78,7 @@ static void InputFrame(FrameId frame, Id id, bool append)
     ASSERT(frame_info.dirty == false);
     ASSERT(!frame_info.id);
 
-    const os::File file{GetFileName(id.file_id, false)};
+    const os::File file{GetFileName(id.file_id, true)};
 
     if (append)
     {
@@ -91,6 +94,20 @@ static void InputFrame(FrameId frame, Id id, bool append)
     ids_used[id] = frame;
 }
 
+static void WriteFrame(FrameId frame)
+{
+    ASSERT(frame < kFrameCount);
+    FrameInfo& frame_info = (*frame_infos)[frame.Get()];
+    ASSERT(frame_info.id);
+    if (frame_info.dirty)
+    {
+        const os::File    file{GetFileName(frame_info.id->file_id, true)};
+        const void* const dst = frames.GetFrame(frame);
+        file.Write(frame_info.id->page_id, dst);
+        frame_info.dirty = false;
+    }
+}
+
 static void OuputFrame(FrameId frame)
 {
     ASSERT(frame < kFrameCount);
@@ -99,13 +116,7 @@ static void OuputFrame(FrameId frame)
     if (frame_info.id)
     {
         const Id id = *frame_info.id;
-        if (frame_info.dirty)
-        {
-            const os::File    file{GetFileName(id.file_id, true)};
-            const void* const dst = frames.GetFrame(frame);
-            file.Write(id.page_id, dst);
-            frame_info.dirty = false;
-        }
+        WriteFrame(frame);
         frame_info.id = std::nullopt;
         ASSERT(ids_used.contains(id));
         ids_used.erase(id);
@@ -182,22 +193,39 @@ void Flush(catalog::FileId file_id)
     file_name_cache.erase(file_id);
 }
 
+void WriteBack(catalog::FileId file_id)
+{
+    for (FrameId frame{}; frame < kFrameCount; frame++)
+    {
+        const FrameInfo& info = (*frame_infos)[frame.Get()];
+        if (info.id && info.id->file_id == file_id)
+        {
+            WriteFrame(frame);
+        }
+    }
+}
+
 void* Request(catalog::FileId file_id, page::Id page_id, bool append, FrameId& frame_out)
 {
     const Id   id   = {.file_id = file_id, .page_id = page_id};
     const auto iter = ids_used.find(id);
     if (iter == ids_used.end())
     {
+        // file name lookup may request other pages, so it must be done before frame is chosen
+        std::ignore = GetFileName(file_id, false);
         ASSERT(!free_list.empty());
         frame_out = free_list.front();
         OuputFrame(frame_out);
         InputFrame(frame_out, id, append);
         // TODO: optimize: in/out both access ids_used, do once
+        stats.misses += append ? 0 : 1;
     }
     else
     {
         frame_out = iter->second;
+        stats.hits++;
     }
+    stats.pins++;
     PinFrame(frame_out);
     return frames.GetFrame(frame_out);
 }
@@ -210,6 +238,11 @@ void Release(FrameId frame, bool dirty)
     UnpinFrame(frame, dirty);
 }
 
+Stats GetStats()
+{
+    return stats;
+}
+
 // TODO: move to tests folder
 /*void test()
 {
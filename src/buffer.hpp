@@ -19,10 +19,21 @@ using FrameId = StrongId<FrameTag, U32>;
 void Init();
 void Destroy();
 void Flush(catalog::FileId file_id);
+void WriteBack(catalog::FileId file_id); // file can then be read directly, pages stay cached
 
 void* Request(catalog::FileId file_id, page::Id page_id, bool append, FrameId& frame_out);
 void  Release(FrameId frame, bool dirty);
 
+// requests of pages since start, never reset
+struct Stats
+{
+    U64 pins   = 0;
+    U64 hits   = 0; // page was in buffer
+    U64 misses = 0; // page was read from file, appended pages are neither hits nor misses
+};
+
+[[nodiscard]] Stats GetStats();
+
 template <typename Page> class Pin
 {
 public:
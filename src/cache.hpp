@@ -49,6 +49,13 @@ public:
         }
         // Cache miss
         auto value = loader_(key);
+        // Loader may have cached the same key itself
+        if (auto it = cache_.find(key); it != cache_.end())
+        {
+            it->second->second = std::move(value);
+            pairs_.splice(pairs_.begin(), pairs_, it->second);
+            return it->second->second;
+        }
         if (GetSize() < capacity_)
         {
             // Create new node
@@ -4,18 +4,24 @@
 #include "error.hpp"
 #include "execute.hpp"
 #include "fst.hpp"
+#include "index.hpp"
 #include "os.hpp"
 #include "type.hpp"
 #include "value.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <optional>
+#include <tuple>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
-// TODO: cache catalog data
-
 namespace catalog
 {
 
@@ -93,14 +99,46 @@ static const Table kTableColumns = {
         },
 };
 
-static std::string ReadFile(FileId file_id)
+static const Table kTableIndexes = {
+    .id       = TableId{4},
+    .name     = "SYS_INDEXES",
+    .file_ids = {.fst = FileId{8}, .dat = FileId{9}},
+    .columns =
+        {
+            {"NAME", ColumnType::kVarchar},
+            {"TABLE_ID", ColumnType::kInteger},
+            {"COLUMN_ID", ColumnType::kInteger},
+            {"FILE_ID", ColumnType::kInteger},
+        },
+};
+
+static const Table kTableStatistics = {
+    .id       = TableId{5},
+    .name     = "SYS_STATISTICS",
+    .file_ids = {.fst = FileId{10}, .dat = FileId{11}},
+    .columns =
+        {
+            {"TABLE_ID", ColumnType::kInteger},
+            {"COLUMN_ID", ColumnType::kInteger},
+            {"ROW_COUNT", ColumnType::kInteger},
+            {"PAGE_COUNT", ColumnType::kInteger},
+            {"NULL_FRACTION", ColumnType::kReal},
+            {"DISTINCT_COUNT", ColumnType::kInteger},
+            {"AVERAGE_SIZE", ColumnType::kReal}, // of values in rows
+            {"MIN_VALUE", ColumnType::kVarchar},
+            {"MAX_VALUE", ColumnType::kVarchar},
+            {"HISTOGRAM", ColumnType::kVarchar}, // bounds separated by commas
+        },
+};
+
+bool IsSystemTable(TableId table_id)
 {
-    const std::string statement =
-        "SELECT NAME FROM " + kTableFiles.name + " WHERE ID = " + file_id.ToString();
-    std::vector<Value> values = ExecuteIinternalStatement(statement);
-    ASSERT(values.size() == 1);
-    auto& name = std::get<ColumnValueVarchar>(values.front().at(0));
-    return name;
+    return table_id <= kTableStatistics.id;
+}
+
+[[nodiscard]] static std::string GetIndexFileName(const std::string& name)
+{
+    return name + ".IDX";
 }
 
 static void WriteFile(FileId file_id, std::string name)
@@ -109,34 +147,33 @@ static void WriteFile(FileId file_id, std::string name)
         ColumnValueInteger{file_id.Get()},
         ColumnValueVarchar{std::move(name)},
     };
-    const std::string statement =
-        "INSERT INTO " + kTableFiles.name + " VALUES " + ValueToList(value);
-    ASSERT(ExecuteIinternalStatement(statement).empty());
+    const std::string statement = "INSERT INTO " + kTableFiles.name + " VALUES ($1, $2)";
+    ASSERT(ExecuteIinternalStatement(statement, value).empty());
 }
 
-static std::optional<TableId> ReadTable(const std::string& name)
+// Catalog tables are also kept in memory, so that metadata is read without queries. Changes are
+// made to a copy, which replaces the snapshot once catalog tables are written.
+struct Snapshot
 {
-    const std::string statement =
-        "SELECT ID FROM " + kTableTables.name + " WHERE NAME = \'" + name + "\'";
-    std::vector<Value> values = ExecuteIinternalStatement(statement);
-    if (values.empty())
-    {
-        return std::nullopt;
-    }
-    ASSERT(values.size() == 1);
-    const auto id = std::get<ColumnValueInteger>(values.front().at(0));
-    return static_cast<TableId>(id);
+    unsigned int                                    version = 0; // incremented by each change
+    std::unordered_map<FileId, std::string>         files;
+    std::unordered_map<TableId, Table>              tables; // which are not system tables
+    std::unordered_map<std::string, TableId>        table_ids;
+    std::unordered_map<TableId, std::vector<Index>> indexes; // in order of creation
+    std::unordered_map<TableId, statistics::Table>  statistics;
+};
+
+static Snapshot snapshot;
+
+static void Publish(Snapshot next)
+{
+    next.version = snapshot.version + 1;
+    snapshot     = std::move(next);
 }
 
-static FileIds ReadTable(TableId table_id)
+unsigned int GetVersion()
 {
-    const std::string statement = "SELECT FILE_FST_ID, FILE_DAT_ID FROM " + kTableTables.name +
-                                  " WHERE ID = " + table_id.ToString();
-    std::vector<Value> values = ExecuteIinternalStatement(statement);
-    ASSERT(values.size() == 1);
-    const auto file_fst = std::get<ColumnValueInteger>(values.front().at(0));
-    const auto file_dat = std::get<ColumnValueInteger>(values.front().at(1));
-    return {.fst = static_cast<FileId>(file_fst), .dat = static_cast<FileId>(file_dat)};
+    return snapshot.version;
 }
 
 static void WriteTable(TableId table_id, std::string name, FileIds file_ids)
@@ -147,16 +184,16 @@ static void WriteTable(TableId table_id, std::string name, FileIds file_ids)
         ColumnValueInteger{file_ids.fst.Get()},
         ColumnValueInteger{file_ids.dat.Get()},
     };
-    const std::string statement =
-        "INSERT INTO " + kTableTables.name + " VALUES " + ValueToList(value);
-    ASSERT(ExecuteIinternalStatement(statement).empty());
+    const std::string statement = "INSERT INTO " + kTableTables.name + " VALUES ($1, $2, $3, $4)";
+    ASSERT(ExecuteIinternalStatement(statement, value).empty());
 }
 
 static NamedColumns ReadColumns(TableId table_id)
 {
-    const std::string statement = "SELECT NAME, TYPE FROM " + kTableColumns.name +
-                                  " WHERE TABLE_ID = " + table_id.ToString() + " ORDER BY ID";
-    std::vector<Value> values = ExecuteIinternalStatement(statement);
+    const std::string statement =
+        "SELECT NAME, TYPE FROM " + kTableColumns.name + " WHERE TABLE_ID = $1 ORDER BY ID";
+    std::vector<Value> values =
+        ExecuteIinternalStatement(statement, {ColumnValueInteger{table_id.Get()}});
     ASSERT(!values.empty());
     NamedColumns columns;
     for (Value& value : values)
@@ -180,11 +217,42 @@ static void WriteColumns(TableId table_id, NamedColumns columns)
             ColumnValueVarchar{ColumnTypeToCatalogString(column_type)},
         };
         const std::string statement =
-            "INSERT INTO " + kTableColumns.name + " VALUES " + ValueToList(value);
-        ASSERT(ExecuteIinternalStatement(statement).empty());
+            "INSERT INTO " + kTableColumns.name + " VALUES ($1, $2, $3, $4)";
+        ASSERT(ExecuteIinternalStatement(statement, value).empty());
     }
 }
 
+static std::vector<Index> ReadIndexes()
+{
+    const std::string statement =
+        "SELECT NAME, TABLE_ID, COLUMN_ID, FILE_ID FROM " + kTableIndexes.name;
+    std::vector<Value> values = ExecuteIinternalStatement(statement);
+    std::vector<Index> indexes;
+    for (Value& value : values)
+    {
+        indexes.push_back({
+            .name      = std::move(std::get<ColumnValueVarchar>(value.at(0))),
+            .table_id  = static_cast<TableId>(std::get<ColumnValueInteger>(value.at(1))),
+            .column_id = static_cast<ColumnId>(std::get<ColumnValueInteger>(value.at(2))),
+            .file_id   = static_cast<FileId>(std::get<ColumnValueInteger>(value.at(3))),
+        });
+    }
+    return indexes;
+}
+
+static void WriteIndex(const Index& index)
+{
+    const Value value = {
+        ColumnValueVarchar{index.name},
+        ColumnValueInteger{index.table_id.Get()},
+        ColumnValueInteger{index.column_id.Get()},
+        ColumnValueInteger{index.file_id.Get()},
+    };
+    const std::string statement =
+        "INSERT INTO " + kTableIndexes.name + " VALUES ($1, $2, $3, $4)";
+    ASSERT(ExecuteIinternalStatement(statement, value).empty());
+}
+
 std::string GetFileName(FileId file_id)
 {
     // if (file_id == TABLE_STATS.file_ids.fst) return TABLE_STATS.GetFstFileName();
@@ -213,7 +281,25 @@ std::string GetFileName(FileId file_id)
     {
         return kTableColumns.GetDataFileName();
     }
-    return ReadFile(file_id);
+    if (file_id == kTableIndexes.file_ids.fst)
+    {
+        return kTableIndexes.GetFstFileName();
+    }
+    if (file_id == kTableIndexes.file_ids.dat)
+    {
+        return kTableIndexes.GetDataFileName();
+    }
+    if (file_id == kTableStatistics.file_ids.fst)
+    {
+        return kTableStatistics.GetFstFileName();
+    }
+    if (file_id == kTableStatistics.file_ids.dat)
+    {
+        return kTableStatistics.GetDataFileName();
+    }
+    const auto iter = snapshot.files.find(file_id);
+    ASSERT(iter != snapshot.files.end());
+    return iter->second;
 }
 
 std::optional<std::pair<TableId, Type>> FindTable(const std::string& name)
@@ -247,12 +333,37 @@ std::optional<std::pair<TableId, NamedColumns>> FindTableNamed(const std::string
     {
         return std::make_pair(kTableColumns.id, kTableColumns.columns);
     }
-    const std::optional<TableId> table_id = ReadTable(name);
-    if (!table_id)
+    if (name == kTableIndexes.name)
+    {
+        return std::make_pair(kTableIndexes.id, kTableIndexes.columns);
+    }
+    if (name == kTableStatistics.name)
+    {
+        return std::make_pair(kTableStatistics.id, kTableStatistics.columns);
+    }
+    const auto iter = snapshot.table_ids.find(name);
+    if (iter == snapshot.table_ids.end())
     {
         return std::nullopt;
     }
-    return std::make_pair(*table_id, ReadColumns(*table_id));
+    return std::make_pair(iter->second, snapshot.tables.at(iter->second).columns);
+}
+
+std::vector<std::string> GetTableNames()
+{
+    std::vector<const Table*> tables;
+    for (const auto& [table_id, table] : snapshot.tables)
+    {
+        tables.push_back(&table);
+    }
+    std::ranges::sort(tables, [](const Table* table_l, const Table* table_r)
+                      { return table_l->id < table_r->id; });
+    std::vector<std::string> names;
+    for (const Table* table : tables)
+    {
+        names.push_back(table->name);
+    }
+    return names;
 }
 
 std::pair<TableId, Type> GetTable(const SourceText& name)
@@ -290,7 +401,17 @@ FileIds GetTableFileIds(TableId table_id)
     {
         return kTableColumns.file_ids;
     }
-    return ReadTable(table_id);
+    if (table_id == kTableIndexes.id)
+    {
+        return kTableIndexes.file_ids;
+    }
+    if (table_id == kTableStatistics.id)
+    {
+        return kTableStatistics.file_ids;
+    }
+    const auto iter = snapshot.tables.find(table_id);
+    ASSERT(iter != snapshot.tables.end());
+    return iter->second.file_ids;
 }
 
 static void CreateTableFiles(const Table& table)
@@ -316,6 +437,48 @@ static void RegisterTable(const Table& table)
     WriteColumns(table.id, table.columns);
 }
 
+// defined with other functions of statistics
+[[nodiscard]] static std::optional<statistics::Table> ReadStatistics(TableId    table_id,
+                                                                     const Type& type);
+
+static void LoadSnapshot()
+{
+    Snapshot next;
+    for (Value& value : ExecuteIinternalStatement("SELECT ID, NAME FROM " + kTableFiles.name))
+    {
+        next.files.emplace(static_cast<FileId>(std::get<ColumnValueInteger>(value.at(0))),
+                           std::move(std::get<ColumnValueVarchar>(value.at(1))));
+    }
+
+    const std::string statement = "SELECT ID, NAME, FILE_FST_ID, FILE_DAT_ID FROM " +
+                                  kTableTables.name + " WHERE ID > $1";
+    for (Value& value :
+         ExecuteIinternalStatement(statement, {ColumnValueInteger{kTableStatistics.id.Get()}}))
+    {
+        const auto table_id = static_cast<TableId>(std::get<ColumnValueInteger>(value.at(0)));
+        const auto file_fst = static_cast<FileId>(std::get<ColumnValueInteger>(value.at(2)));
+        const auto file_dat = static_cast<FileId>(std::get<ColumnValueInteger>(value.at(3)));
+        Table      table    = {
+                    .id       = table_id,
+                    .name     = std::move(std::get<ColumnValueVarchar>(value.at(1))),
+                    .file_ids = {.fst = file_fst, .dat = file_dat},
+                    .columns  = ReadColumns(table_id),
+        };
+        if (auto statistics = ReadStatistics(table_id, GetTypeFromNamedColumns(table.columns)))
+        {
+            next.statistics.emplace(table_id, std::move(*statistics));
+        }
+        next.table_ids.emplace(table.name, table_id);
+        next.tables.emplace(table_id, std::move(table));
+    }
+
+    for (Index& index : ReadIndexes())
+    {
+        next.indexes[index.table_id].push_back(std::move(index));
+    }
+    Publish(std::move(next));
+}
+
 void Init()
 {
     // TODO: update statement needed
@@ -326,19 +489,33 @@ void Init()
     CreateTableFiles(kTableFiles);
     CreateTableFiles(kTableTables);
     CreateTableFiles(kTableColumns);
+    CreateTableFiles(kTableIndexes);
+    CreateTableFiles(kTableStatistics);
 
     // RegisterTable(TABLE_STATS);
     RegisterTable(kTableFiles);
     RegisterTable(kTableTables);
     RegisterTable(kTableColumns);
+    RegisterTable(kTableIndexes);
+    RegisterTable(kTableStatistics);
+
+    LoadSnapshot();
+}
+
+static FileId GenerateFileId()
+{
+    // TODO: update statement needed
+    static auto file_id_todo = FileId{12};
+    return file_id_todo++;
 }
 
 static std::pair<TableId, FileIds> GenerateTableIds()
 {
     // TODO: update statement needed
-    static auto table_id_todo = TableId{4};
-    static auto file_id_todo  = FileId{8};
-    return std::make_pair(table_id_todo++, FileIds{.fst = file_id_todo++, .dat = file_id_todo++});
+    static auto   table_id_todo = TableId{6};
+    const FileId file_fst      = GenerateFileId();
+    const FileId file_dat      = GenerateFileId();
+    return std::make_pair(table_id_todo++, FileIds{.fst = file_fst, .dat = file_dat});
 }
 
 void CreateTable(std::string name, NamedColumns columns)
@@ -350,13 +527,19 @@ void CreateTable(std::string name, NamedColumns columns)
                 .file_ids = file_ids,
                 .columns  = std::move(columns),
     };
+    Snapshot next = snapshot;
+    next.files.emplace(table.file_ids.fst, table.GetFstFileName());
+    next.files.emplace(table.file_ids.dat, table.GetDataFileName());
+    next.table_ids.emplace(table.name, table.id);
+    next.tables.emplace(table.id, table);
     RegisterTable(table);
+    Publish(std::move(next));
     CreateTableFiles(table);
 }
 
 void TruncateTable(TableId table_id)
 {
-    // TODO: clean indexes, metadata, etc
+    // TODO: clean metadata, etc
     // Buffer flush? not sure
 
     // TODO: multiple lookups
@@ -368,6 +551,13 @@ void TruncateTable(TableId table_id)
     // fst file
     os::FileTruncate(GetFileName(file_fst));
     fst::Init(file_fst);
+
+    // index files
+    for (const Index& index : GetTableIndexes(table_id))
+    {
+        os::FileTruncate(GetIndexFileName(index.name));
+        btree::Init(index.file_id);
+    }
 }
 
 void DropTable(TableId table_id)
@@ -375,28 +565,49 @@ void DropTable(TableId table_id)
     ASSERT(table_id != kTableFiles.id);
     ASSERT(table_id != kTableTables.id);
     ASSERT(table_id != kTableColumns.id);
+    ASSERT(table_id != kTableIndexes.id);
+    ASSERT(table_id != kTableStatistics.id);
 
-    // TODO: clean indexes, metadata, etc
+    // TODO: clean metadata, etc
 
     const auto [file_fst, file_dat] = GetTableFileIds(table_id);
     const auto file_fst_name        = GetFileName(file_fst);
     const auto file_dat_name        = GetFileName(file_dat);
+    const auto indexes              = GetTableIndexes(table_id);
 
     std::vector<Value> result;
 
-    const auto statement_columns =
-        "DELETE FROM " + kTableColumns.name + " WHERE TABLE_ID = " + table_id.ToString();
-    result = ExecuteIinternalStatement(statement_columns);
+    for (const Index& index : indexes)
+    {
+        const auto statement_file = "DELETE FROM " + kTableFiles.name + " WHERE ID = $1";
+        result =
+            ExecuteIinternalStatement(statement_file, {ColumnValueInteger{index.file_id.Get()}});
+        ASSERT(result.empty());
+
+        buffer::Flush(index.file_id);
+        os::FileRemove(GetIndexFileName(index.name));
+    }
+
+    const auto statement_statistics =
+        "DELETE FROM " + kTableStatistics.name + " WHERE TABLE_ID = $1";
+    result = ExecuteIinternalStatement(statement_statistics, {ColumnValueInteger{table_id.Get()}});
+    ASSERT(result.empty());
+
+    const auto statement_indexes = "DELETE FROM " + kTableIndexes.name + " WHERE TABLE_ID = $1";
+    result = ExecuteIinternalStatement(statement_indexes, {ColumnValueInteger{table_id.Get()}});
     ASSERT(result.empty());
 
-    const auto statement_table =
-        "DELETE FROM " + kTableTables.name + " WHERE ID = " + table_id.ToString();
-    result = ExecuteIinternalStatement(statement_table);
+    const auto statement_columns = "DELETE FROM " + kTableColumns.name + " WHERE TABLE_ID = $1";
+    result = ExecuteIinternalStatement(statement_columns, {ColumnValueInteger{table_id.Get()}});
     ASSERT(result.empty());
 
-    const auto statement_files = "DELETE FROM " + kTableFiles.name + " WHERE ID IN (" +
-                                 file_fst.ToString() + ", " + file_dat.ToString() + ")";
-    result = ExecuteIinternalStatement(statement_files);
+    const auto statement_table = "DELETE FROM " + kTableTables.name + " WHERE ID = $1";
+    result = ExecuteIinternalStatement(statement_table, {ColumnValueInteger{table_id.Get()}});
+    ASSERT(result.empty());
+
+    const auto statement_files = "DELETE FROM " + kTableFiles.name + " WHERE ID IN ($1, $2)";
+    result = ExecuteIinternalStatement(
+        statement_files, {ColumnValueInteger{file_fst.Get()}, ColumnValueInteger{file_dat.Get()}});
     ASSERT(result.empty());
 
     buffer::Flush(file_fst);
@@ -404,6 +615,265 @@ void DropTable(TableId table_id)
 
     os::FileRemove(file_fst_name);
     os::FileRemove(file_dat_name);
+
+    Snapshot next = snapshot;
+    for (const Index& index : indexes)
+    {
+        next.files.erase(index.file_id);
+    }
+    next.files.erase(file_fst);
+    next.files.erase(file_dat);
+    next.table_ids.erase(next.tables.at(table_id).name);
+    next.tables.erase(table_id);
+    next.indexes.erase(table_id);
+    next.statistics.erase(table_id);
+    Publish(std::move(next));
+}
+
+std::optional<Index> FindIndex(const std::string& name)
+{
+    for (const auto& [table_id, indexes] : snapshot.indexes)
+    {
+        for (const Index& index : indexes)
+        {
+            if (index.name == name)
+            {
+                return index;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<Index> GetTableIndexes(TableId table_id)
+{
+    // also avoids recursion when system tables are modified
+    if (IsSystemTable(table_id))
+    {
+        return {};
+    }
+    const auto iter = snapshot.indexes.find(table_id);
+    if (iter == snapshot.indexes.end())
+    {
+        return {};
+    }
+    return iter->second;
+}
+
+FileId CreateIndex(std::string name, TableId table_id, ColumnId column_id)
+{
+    ASSERT(!IsSystemTable(table_id));
+    const Index index = {
+        .name      = std::move(name),
+        .table_id  = table_id,
+        .column_id = column_id,
+        .file_id   = GenerateFileId(),
+    };
+    Snapshot next = snapshot;
+    next.files.emplace(index.file_id, GetIndexFileName(index.name));
+    next.indexes[table_id].push_back(index);
+    WriteFile(index.file_id, GetIndexFileName(index.name));
+    WriteIndex(index);
+    Publish(std::move(next));
+
+    os::FileCreate(GetIndexFileName(index.name));
+    btree::Init(index.file_id);
+    return index.file_id;
+}
+
+constexpr std::size_t kStatisticsStringSizeMax    = 16; // of values of strings
+constexpr std::size_t kStatisticsHistogramSizeMax = 96;
+constexpr char        kStatisticsSeparator        = ',';
+
+[[nodiscard]] static std::string StatisticsValueToString(const ColumnValue& value)
+{
+    if (const auto* real = std::get_if<ColumnValueReal>(&value))
+    {
+        static constexpr int kDigits = 10;
+        std::array<char, 32> buffer{};
+        std::ignore = std::snprintf(buffer.data(), buffer.size(), "%.*g", kDigits, *real);
+        return buffer.data();
+    }
+    if (const auto* string = std::get_if<ColumnValueVarchar>(&value))
+    {
+        // characters which cannot be in statement or in histogram are left out
+        std::string result;
+        for (const char c : *string)
+        {
+            if (result.size() == kStatisticsStringSizeMax)
+            {
+                break;
+            }
+            if (std::isprint(static_cast<unsigned char>(c)) != 0 && c != '\'' &&
+                c != kStatisticsSeparator)
+            {
+                result.push_back(c);
+            }
+        }
+        return result;
+    }
+    return ColumnValueToString(value, false);
+}
+
+[[nodiscard]] static ColumnValue StatisticsValueFromString(const std::string& string,
+                                                           ColumnType         type)
+{
+    switch (type)
+    {
+    case ColumnType::kBoolean:
+        return string == ColumnValueToString(Bool::kTrue, false) ? Bool::kTrue : Bool::kFalse;
+    case ColumnType::kInteger:
+        return ColumnValueInteger{std::stoll(string)};
+    case ColumnType::kReal:
+        return ColumnValueReal{std::stod(string)};
+    case ColumnType::kVarchar:
+        return string;
+    }
+    UNREACHABLE();
+}
+
+[[nodiscard]] static ColumnValue StatisticsHistogramToValue(std::vector<ColumnValue> bounds)
+{
+    while (!bounds.empty())
+    {
+        std::string string;
+        for (const ColumnValue& bound : bounds)
+        {
+            if (!string.empty())
+            {
+                string.push_back(kStatisticsSeparator);
+            }
+            string += StatisticsValueToString(bound);
+        }
+        if (string.size() <= kStatisticsHistogramSizeMax)
+        {
+            return string;
+        }
+        // pairs of buckets are merged, they still hold the same number of rows
+        std::vector<ColumnValue> merged;
+        for (std::size_t i = 1; i < bounds.size(); i += 2)
+        {
+            merged.push_back(std::move(bounds[i]));
+        }
+        bounds = std::move(merged);
+    }
+    return ColumnValueNull{};
+}
+
+[[nodiscard]] static std::vector<ColumnValue>
+StatisticsHistogramFromValue(const std::string& string, ColumnType type)
+{
+    std::vector<ColumnValue> bounds;
+    std::size_t              begin = 0;
+    for (;;)
+    {
+        const std::size_t end = string.find(kStatisticsSeparator, begin);
+        bounds.push_back(StatisticsValueFromString(string.substr(begin, end - begin), type));
+        if (end == std::string::npos)
+        {
+            return bounds;
+        }
+        begin = end + 1;
+    }
+}
+
+static std::optional<statistics::Table> ReadStatistics(TableId table_id, const Type& type)
+{
+    const std::string statement = "SELECT ROW_COUNT, PAGE_COUNT, NULL_FRACTION, DISTINCT_COUNT, "
+                                  "AVERAGE_SIZE, MIN_VALUE, MAX_VALUE, HISTOGRAM FROM " +
+                                  kTableStatistics.name + " WHERE TABLE_ID = $1 ORDER BY COLUMN_ID";
+    std::vector<Value> values =
+        ExecuteIinternalStatement(statement, {ColumnValueInteger{table_id.Get()}});
+    if (values.empty())
+    {
+        return std::nullopt;
+    }
+    ASSERT(values.size() == type.Size());
+    statistics::Table table{
+        .row_count  = static_cast<U64>(std::get<ColumnValueInteger>(values.front().at(0))),
+        .page_count = static_cast<U64>(std::get<ColumnValueInteger>(values.front().at(1))),
+        .columns    = {},
+    };
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        const Value&     value       = values[i];
+        const ColumnType column_type = type.At(i);
+        statistics::Column column{
+            .null_fraction  = std::get<ColumnValueReal>(value.at(2)),
+            .distinct_count = static_cast<double>(std::get<ColumnValueInteger>(value.at(3))),
+            .average_size   = std::get<ColumnValueReal>(value.at(4)),
+            .min            = ColumnValueNull{},
+            .max            = ColumnValueNull{},
+            .bounds         = {},
+        };
+        if (const auto* min = std::get_if<ColumnValueVarchar>(&value.at(5)))
+        {
+            column.min = StatisticsValueFromString(*min, column_type);
+            column.max = StatisticsValueFromString(std::get<ColumnValueVarchar>(value.at(6)),
+                                                   column_type);
+        }
+        if (const auto* histogram = std::get_if<ColumnValueVarchar>(&value.at(7)))
+        {
+            column.bounds = StatisticsHistogramFromValue(*histogram, column_type);
+        }
+        table.columns.push_back(std::move(column));
+    }
+    return table;
+}
+
+std::optional<statistics::Table> FindStatistics(TableId table_id)
+{
+    const auto iter = snapshot.statistics.find(table_id);
+    if (iter == snapshot.statistics.end())
+    {
+        return std::nullopt;
+    }
+    return iter->second;
+}
+
+void SetStatistics(TableId table_id, const statistics::Table& table)
+{
+    ASSERT(!IsSystemTable(table_id));
+    const std::string statement_delete =
+        "DELETE FROM " + kTableStatistics.name + " WHERE TABLE_ID = $1";
+    ASSERT(ExecuteIinternalStatement(statement_delete, {ColumnValueInteger{table_id.Get()}})
+               .empty());
+
+    for (ColumnId column_id{}; column_id < table.columns.size(); column_id++)
+    {
+        const statistics::Column& column   = table.columns[column_id.Get()];
+        const auto                to_value = [](const ColumnValue& value) -> ColumnValue
+        {
+            if (value.index() == 0)
+            {
+                return ColumnValueNull{};
+            }
+            return StatisticsValueToString(value);
+        };
+        const Value value = {
+            ColumnValueInteger{table_id.Get()},
+            ColumnValueInteger{column_id.Get()},
+            static_cast<ColumnValueInteger>(table.row_count),
+            static_cast<ColumnValueInteger>(table.page_count),
+            ColumnValueReal{column.null_fraction},
+            ColumnValueInteger{std::llround(column.distinct_count)},
+            ColumnValueReal{column.average_size},
+            to_value(column.min),
+            to_value(column.max),
+            StatisticsHistogramToValue(column.bounds),
+        };
+        const std::string statement = "INSERT INTO " + kTableStatistics.name +
+                                      " VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10)";
+        ASSERT(ExecuteIinternalStatement(statement, value).empty());
+    }
+
+    // values are read back, since they may be shortened when stored
+    Snapshot   next   = snapshot;
+    const Type type   = GetTypeFromNamedColumns(next.tables.at(table_id).columns);
+    auto       stored = ReadStatistics(table_id, type);
+    ASSERT(stored);
+    next.statistics.insert_or_assign(table_id, std::move(*stored));
+    Publish(std::move(next));
 }
 
 Type GetTypeFromNamedColumns(const NamedColumns& named_columns)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "error.hpp"
+#include "statistics.hpp"
 #include "type.hpp"
 
 #include <optional>
@@ -26,11 +27,27 @@ using TableId = StrongId<TableTag, unsigned int>;
 using NamedColumn  = std::pair<std::string, ColumnType>;
 using NamedColumns = std::vector<NamedColumn>;
 
+struct Index
+{
+    std::string name;
+    TableId     table_id;
+    ColumnId    column_id;
+    FileId      file_id;
+};
+
 void Init();
 
+// incremented by each change of catalog
+[[nodiscard]] unsigned int GetVersion();
+
 std::string GetFileName(FileId file_id);
 FileIds     GetTableFileIds(TableId table_id);
 
+[[nodiscard]] bool IsSystemTable(TableId table_id);
+
+// of tables which are not system tables
+[[nodiscard]] std::vector<std::string> GetTableNames();
+
 std::pair<TableId, Type>         GetTable(const SourceText& name);
 std::pair<TableId, NamedColumns> GetTableNamed(const SourceText& name);
 
@@ -41,6 +58,16 @@ void CreateTable(std::string name, NamedColumns columns);
 void TruncateTable(TableId table_id);
 void DropTable(TableId table_id);
 
+std::optional<Index> FindIndex(const std::string& name);
+std::vector<Index>   GetTableIndexes(TableId table_id);
+
+FileId CreateIndex(std::string name, TableId table_id, ColumnId column_id);
+
+// Statistics are stored with values converted to strings, long strings are shortened and the
+// histogram may have fewer buckets, so that rows fit in page. None are stored for system tables.
+std::optional<statistics::Table> FindStatistics(TableId table_id);
+void                             SetStatistics(TableId table_id, const statistics::Table& table);
+
 [[nodiscard]] Type GetTypeFromNamedColumns(const NamedColumns& named_columns);
 
 // void remove_table(TableId table_id);
@@ -4,19 +4,34 @@
 #include "catalog.hpp"
 #include "common.hpp"
 #include "error.hpp"
+#include "explain.hpp"
 #include "expr.hpp"
+#include "fst.hpp"
+#include "index.hpp"
 #include "iter.hpp"
+#include "join.hpp"
 #include "op.hpp"
+#include "optimizer.hpp"
+#include "page.hpp"
+#include "parallel.hpp"
+#include "prepare.hpp"
+#include "row.hpp"
 #include "sort.hpp"
+#include "statistics.hpp"
+#include "temp.hpp"
 #include "type.hpp"
 #include "value.hpp"
 
 #include <algorithm>
+#include <bit>
+#include <cmath>
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <variant>
@@ -29,7 +44,10 @@ struct Source
 {
     struct DataTable
     {
-        catalog::TableId table_id;
+        catalog::TableId      table_id;
+        Type                  table_type; // of all columns
+        std::vector<ColumnId> columns;    // of table which are read, all if empty
+        ExprPtr               filter;     // evaluated by scan, conditions only on this table
     };
     struct DataJoinCross
     {
@@ -44,8 +62,10 @@ struct Source
 
     using Data = std::variant<DataTable, DataJoinCross, DataJoinConditional>;
 
-    Data data;
-    Type type;
+    Data                               data;
+    Type                               type;
+    std::optional<U64>                 page_count; // estimated when joins are planned
+    std::optional<optimizer::Estimate> estimate;   // of planner, shown by EXPLAIN
 
     Source(Data data, Type type) : data{std::move(data)}, type{std::move(type)}
     {
@@ -72,8 +92,9 @@ struct Select
 
 struct QueryTodo
 {
-    Select                 select;
-    std::optional<OrderBy> order_by;
+    Select                      select;
+    std::optional<OrderBy>      order_by;
+    std::optional<unsigned int> limit;
 };
 
 class Columns
@@ -290,17 +311,148 @@ struct ExprContext
     return std::make_unique<Expr>(Expr::DataColumn{column_id}, column_type);
 }
 
+[[nodiscard]] static bool IsConstant(const ExprPtr& expr)
+{
+    return std::holds_alternative<Expr::DataConstant>(expr->data);
+}
+
+[[nodiscard]] static std::optional<Bool> GetConstantBool(const ExprPtr& expr)
+{
+    if (const auto* constant = std::get_if<Expr::DataConstant>(&expr->data))
+    {
+        if (const auto* value = std::get_if<ColumnValueBoolean>(&constant->value))
+        {
+            return *value;
+        }
+    }
+    return std::nullopt;
+}
+
+// evaluates expression once at compile time, keeps it if evaluation fails (e.g. division by zero)
+// so that the error is reported only when the expression is actually evaluated
+[[nodiscard]] static ExprPtr EvalConstantExpr(ExprPtr expr)
+{
+    try
+    {
+        ColumnValue value = expr->Eval(nullptr);
+        return std::make_unique<Expr>(Expr::DataConstant{std::move(value)}, expr->type);
+    }
+    catch (const ClientError&)
+    {
+        return expr;
+    }
+}
+
+// simplifies expression whose children are already folded
+[[nodiscard]] static ExprPtr FoldExpr(ExprPtr expr)
+{
+    return std::visit(
+        Overload{
+            [&expr](Expr::DataCast& data)
+            { return IsConstant(data.expr) ? EvalConstantExpr(std::move(expr)) : std::move(expr); },
+            [&expr](Expr::DataOp1& data)
+            {
+                if (IsConstant(data.expr))
+                {
+                    return EvalConstantExpr(std::move(expr));
+                }
+                // NOT NOT p -> p
+                if (auto* inner = std::get_if<Expr::DataOp1>(&data.expr->data);
+                    inner != nullptr && data.op.first == Op1::kNot && inner->op.first == Op1::kNot)
+                {
+                    return std::move(inner->expr);
+                }
+                return std::move(expr);
+            },
+            [&expr](Expr::DataOp2& data)
+            {
+                if (IsConstant(data.expr_l) && IsConstant(data.expr_r))
+                {
+                    return EvalConstantExpr(std::move(expr));
+                }
+                if (data.op.first != Op2::kLogicAnd && data.op.first != Op2::kLogicOr)
+                {
+                    return std::move(expr);
+                }
+                // FALSE AND p -> FALSE, TRUE AND p -> p, TRUE OR p -> TRUE, FALSE OR p -> p
+                const Bool absorbing = data.op.first == Op2::kLogicAnd ? Bool::kFalse : Bool::kTrue;
+                const Bool neutral   = data.op.first == Op2::kLogicAnd ? Bool::kTrue : Bool::kFalse;
+                for (auto [constant, other] : {std::pair{&data.expr_l, &data.expr_r},
+                                               std::pair{&data.expr_r, &data.expr_l}})
+                {
+                    const std::optional<Bool> value = GetConstantBool(*constant);
+                    if (value == absorbing)
+                    {
+                        return std::move(*constant);
+                    }
+                    if (value == neutral)
+                    {
+                        return std::move(*other);
+                    }
+                }
+                return std::move(expr);
+            },
+            [&expr](Expr::DataBetween& data)
+            {
+                if (IsConstant(data.expr) && IsConstant(data.min) && IsConstant(data.max))
+                {
+                    return EvalConstantExpr(std::move(expr));
+                }
+                return std::move(expr);
+            },
+            [&expr](Expr::DataIn& data)
+            {
+                if (!std::ranges::all_of(data.list, IsConstant))
+                {
+                    return std::move(expr);
+                }
+                if (IsConstant(data.expr))
+                {
+                    return EvalConstantExpr(std::move(expr));
+                }
+                std::vector<ColumnValue> values;
+                values.reserve(data.list.size());
+                for (ExprPtr& element : data.list)
+                {
+                    values.push_back(std::move(std::get<Expr::DataConstant>(element->data).value));
+                }
+                Expr::DataInSet in_set{.expr    = std::move(data.expr),
+                                       .list    = InList{std::move(values)},
+                                       .negated = data.negated};
+                return std::make_unique<Expr>(std::move(in_set), expr->type);
+            },
+            [&expr](auto&) { return std::move(expr); },
+        },
+        expr->data);
+}
+
+[[nodiscard]] static ExprPtr CreateCastExpr(ExprPtr expr, ColumnType to)
+{
+    return FoldExpr(std::make_unique<Expr>(Expr::DataCast{.expr = std::move(expr), .to = to}, to));
+}
+
 [[nodiscard]] static ExprPtr CompileExpr(const AstExpr& ast, const Columns* columns,
-                                         std::optional<ExprContext> context)
+                                         std::optional<ExprContext> context,
+                                         const Parameters&          parameters)
 {
     const SourceText text = ast.text;
-    return std::visit(
+    ExprPtr          expr = std::visit(
         Overload{
             [](const AstExpr::DataConstant& ast)
             {
                 const std::optional<ColumnType> type = ColumnValueToType(ast.value);
                 return std::make_unique<Expr>(Expr::DataConstant{ast.value}, type);
             },
+            [&parameters, text](const AstExpr::DataParameter& ast)
+            {
+                if (ast.index >= parameters.types.size())
+                {
+                    throw ClientError{"parameter without value", text};
+                }
+                return std::make_unique<Expr>(
+                    Expr::DataParameter{.index = ast.index, .values = parameters.values},
+                    parameters.types[ast.index]);
+            },
             [&columns, context, text](const AstExpr::DataColumn& ast)
             {
                 if (columns == nullptr)
@@ -314,35 +466,36 @@ struct ExprContext
                 }
                 return std::make_unique<Expr>(Expr::DataColumn{column_id}, column_type);
             },
-            [&columns, context](const AstExpr::DataCast& ast)
+            [&columns, context, &parameters](const AstExpr::DataCast& ast)
             {
-                ExprPtr expr = CompileExpr(*ast.expr, columns, context);
+                ExprPtr expr = CompileExpr(*ast.expr, columns, context, parameters);
                 CompileCast(expr->type, ast.to);
                 return std::make_unique<Expr>(
                     Expr::DataCast{.expr = std::move(expr), .to = ast.to.first}, ast.to.first);
             },
-            [&columns, context](const AstExpr::DataOp1& ast)
+            [&columns, context, &parameters](const AstExpr::DataOp1& ast)
             {
-                ExprPtr                         expr = CompileExpr(*ast.expr, columns, context);
+                ExprPtr                         expr =
+                    CompileExpr(*ast.expr, columns, context, parameters);
                 const std::optional<ColumnType> type = Op1Compile(ast.op, expr->type);
                 return std::make_unique<Expr>(Expr::DataOp1{.expr = std::move(expr), .op = ast.op},
                                               type);
             },
-            [&columns, context](const AstExpr::DataOp2& ast)
+            [&columns, context, &parameters](const AstExpr::DataOp2& ast)
             {
-                ExprPtr                         expr_l = CompileExpr(*ast.expr_l, columns, context);
-                ExprPtr                         expr_r = CompileExpr(*ast.expr_r, columns, context);
+                ExprPtr                         expr_l =
+                    CompileExpr(*ast.expr_l, columns, context, parameters);
+                ExprPtr                         expr_r =
+                    CompileExpr(*ast.expr_r, columns, context, parameters);
                 const std::optional<ColumnType> type =
                     CastTogether({expr_l->type, expr_r->type}, ast.op.second);
                 if (expr_l->type && type && *expr_l->type != *type)
                 {
-                    expr_l = std::make_unique<Expr>(
-                        Expr::DataCast{.expr = std::move(expr_l), .to = *type}, *type);
+                    expr_l = CreateCastExpr(std::move(expr_l), *type);
                 }
                 if (expr_r->type && type && *expr_r->type != *type)
                 {
-                    expr_r = std::make_unique<Expr>(
-                        Expr::DataCast{.expr = std::move(expr_r), .to = *type}, *type);
+                    expr_r = CreateCastExpr(std::move(expr_r), *type);
                 }
                 const std::optional<ColumnType> output_type =
                     Op2Compile(ast.op, expr_l->type, expr_r->type);
@@ -351,11 +504,14 @@ struct ExprContext
                                                             .op     = ast.op},
                                               output_type);
             },
-            [&columns, context](const AstExpr::DataBetween& ast)
+            [&columns, context, &parameters](const AstExpr::DataBetween& ast)
             {
-                ExprPtr                         expr = CompileExpr(*ast.expr, columns, context);
-                ExprPtr                         min  = CompileExpr(*ast.min, columns, context);
-                ExprPtr                         max  = CompileExpr(*ast.max, columns, context);
+                ExprPtr                         expr =
+                    CompileExpr(*ast.expr, columns, context, parameters);
+                ExprPtr                         min  =
+                    CompileExpr(*ast.min, columns, context, parameters);
+                ExprPtr                         max  =
+                    CompileExpr(*ast.max, columns, context, parameters);
                 const std::optional<ColumnType> type =
                     CastTogether({expr->type, min->type, max->type}, ast.between_text);
                 if (type && !ColumnTypeIsComparable(*type))
@@ -364,18 +520,15 @@ struct ExprContext
                 }
                 if (expr->type && type && *expr->type != *type)
                 {
-                    expr = std::make_unique<Expr>(
-                        Expr::DataCast{.expr = std::move(expr), .to = *type}, *type);
+                    expr = CreateCastExpr(std::move(expr), *type);
                 }
                 if (min->type && type && *min->type != *type)
                 {
-                    min = std::make_unique<Expr>(
-                        Expr::DataCast{.expr = std::move(min), .to = *type}, *type);
+                    min = CreateCastExpr(std::move(min), *type);
                 }
                 if (max->type && type && *max->type != *type)
                 {
-                    max = std::make_unique<Expr>(
-                        Expr::DataCast{.expr = std::move(max), .to = *type}, *type);
+                    max = CreateCastExpr(std::move(max), *type);
                 }
                 return std::make_unique<Expr>(Expr::DataBetween{.expr         = std::move(expr),
                                                                 .min          = std::move(min),
@@ -384,29 +537,27 @@ struct ExprContext
                                                                 .between_text = ast.between_text},
                                               ColumnType::kBoolean);
             },
-            [&columns, context](const AstExpr::DataIn& ast)
+            [&columns, context, &parameters](const AstExpr::DataIn& ast)
             {
-                ExprPtr              expr = CompileExpr(*ast.expr, columns, context);
+                ExprPtr              expr = CompileExpr(*ast.expr, columns, context, parameters);
                 std::vector<ExprPtr> list;
                 std::vector<std::optional<ColumnType>> types;
                 for (const AstExprPtr& ast_element : ast.list)
                 {
-                    ExprPtr element = CompileExpr(*ast_element, columns, context);
+                    ExprPtr element = CompileExpr(*ast_element, columns, context, parameters);
                     types.push_back(element->type);
                     list.push_back(std::move(element));
                 }
                 const std::optional<ColumnType> type = CastTogether(types, ast.in_text);
                 if (expr->type && type && *expr->type != *type)
                 {
-                    expr = std::make_unique<Expr>(
-                        Expr::DataCast{.expr = std::move(expr), .to = *type}, type);
+                    expr = CreateCastExpr(std::move(expr), *type);
                 }
                 for (ExprPtr& element : list)
                 {
                     if (element->type && type && *element->type != *type)
                     {
-                        element = std::make_unique<Expr>(
-                            Expr::DataCast{.expr = std::move(element), .to = *type}, type);
+                        element = CreateCastExpr(std::move(element), *type);
                     }
                 }
                 return std::make_unique<Expr>(Expr::DataIn{.expr    = std::move(expr),
@@ -414,7 +565,7 @@ struct ExprContext
                                                            .negated = ast.negated},
                                               ColumnType::kBoolean);
             },
-            [&columns, context](const AstExpr::DataFunction& ast)
+            [&columns, context, &parameters](const AstExpr::DataFunction& ast)
             {
                 ASSERT(context);
                 ASSERT(!context->inside_aggregation);
@@ -426,7 +577,8 @@ struct ExprContext
                         *ast.arg, columns,
                         ExprContext{.nonaggregated_columns = context->nonaggregated_columns,
                                     .aggregates            = context->aggregates,
-                                    .inside_aggregation    = true});
+                                    .inside_aggregation    = true},
+                        parameters);
                     switch (ast.function)
                     {
                     case Function::kAvg:
@@ -463,9 +615,11 @@ struct ExprContext
             },
         },
         ast.data);
+    return FoldExpr(std::move(expr));
 }
 
-[[nodiscard]] static std::pair<SourcePtr, Columns> CompileSource(const AstSource& ast)
+[[nodiscard]] static std::pair<SourcePtr, Columns> CompileSource(const AstSource&  ast,
+                                                                 const Parameters& parameters)
 {
     return std::visit(
         Overload{
@@ -474,13 +628,17 @@ struct ExprContext
                 auto [table_id, table_columns] = catalog::GetTableNamed(ast.name);
                 Columns columns{ast.alias.value_or(ast.name), std::move(table_columns)};
                 return std::make_pair(
-                    std::make_unique<Source>(Source::DataTable{table_id}, columns.GetType()),
+                    std::make_unique<Source>(Source::DataTable{.table_id   = table_id,
+                                                               .table_type = columns.GetType(),
+                                                               .columns    = {},
+                                                               .filter     = nullptr},
+                                             columns.GetType()),
                     std::move(columns));
             },
-            [](const AstSource::DataJoinCross& ast)
+            [&parameters](const AstSource::DataJoinCross& ast)
             {
-                auto [source_l, columns_l] = CompileSource(*ast.source_l);
-                auto [source_r, columns_r] = CompileSource(*ast.source_r);
+                auto [source_l, columns_l] = CompileSource(*ast.source_l, parameters);
+                auto [source_r, columns_r] = CompileSource(*ast.source_r, parameters);
                 Columns columns{columns_l, columns_r};
                 return std::make_pair(
                     std::make_unique<Source>(Source::DataJoinCross{.source_l = std::move(source_l),
@@ -488,12 +646,13 @@ struct ExprContext
                                              columns.GetType()),
                     std::move(columns));
             },
-            [](const AstSource::DataJoinConditional& ast)
+            [&parameters](const AstSource::DataJoinConditional& ast)
             {
-                auto [source_l, columns_l] = CompileSource(*ast.source_l);
-                auto [source_r, columns_r] = CompileSource(*ast.source_r);
+                auto [source_l, columns_l] = CompileSource(*ast.source_l, parameters);
+                auto [source_r, columns_r] = CompileSource(*ast.source_r, parameters);
                 Columns columns{columns_l, columns_r};
-                ExprPtr condition = CompileExpr(*ast.condition, &columns, std::nullopt);
+                ExprPtr condition =
+                    CompileExpr(*ast.condition, &columns, std::nullopt, parameters);
                 if (condition->type != ColumnType::kBoolean)
                 {
                     throw ClientError{"condition must be boolean", ast.condition->text};
@@ -513,13 +672,13 @@ struct ExprContext
 };
 
 [[nodiscard]] static std::pair<SourcePtr, Columns>
-CompileSources(const std::vector<AstSourcePtr>& asts)
+CompileSources(const std::vector<AstSourcePtr>& asts, const Parameters& parameters)
 {
     ASSERT(!asts.empty());
-    std::pair<SourcePtr, Columns> result = CompileSource(*asts[0]);
+    std::pair<SourcePtr, Columns> result = CompileSource(*asts[0], parameters);
     for (std::size_t i = 1; i < asts.size(); i++)
     {
-        std::pair<SourcePtr, Columns> other = CompileSource(*asts[i]);
+        std::pair<SourcePtr, Columns> other = CompileSource(*asts[i], parameters);
         Columns                       columns{result.second, other.second};
         result = std::make_pair(
             std::make_unique<Source>(Source::DataJoinCross{.source_l = std::move(result.first),
@@ -530,13 +689,14 @@ CompileSources(const std::vector<AstSourcePtr>& asts)
     return result;
 };
 
-[[nodiscard]] static ExprPtr CompileWhere(const Columns& columns, const AstExprPtr& ast)
+[[nodiscard]] static ExprPtr CompileWhere(const Columns& columns, const AstExprPtr& ast,
+                                          const Parameters& parameters)
 {
     if (!ast)
     {
         return ExprPtr{};
     }
-    ExprPtr expr = CompileExpr(*ast, &columns, std::nullopt);
+    ExprPtr expr = CompileExpr(*ast, &columns, std::nullopt, parameters);
     if (expr->type != ColumnType::kBoolean)
     {
         throw ClientError{"condition must be boolean", ast->text};
@@ -560,13 +720,13 @@ CompileSources(const std::vector<AstSourcePtr>& asts)
 }
 
 [[nodiscard]] static ExprPtr CompileHaving(const Columns& columns, const AstExprPtr& ast,
-                                           ExprContext context)
+                                           ExprContext context, const Parameters& parameters)
 {
     if (!ast)
     {
         return ExprPtr{};
     }
-    ExprPtr expr = CompileExpr(*ast, &columns, context);
+    ExprPtr expr = CompileExpr(*ast, &columns, context, parameters);
     if (expr->type != ColumnType::kBoolean)
     {
         throw ClientError{"condition must be boolean", ast->text};
@@ -577,7 +737,7 @@ CompileSources(const std::vector<AstSourcePtr>& asts)
 [[nodiscard]] static std::pair<SelectList, catalog::NamedColumns>
 CompileSelectList(const Columns& columns, const AstSelectList& ast,
                   std::unordered_map<ColumnId, SourceText>& nonaggregated_columns,
-                  Aggregates&                               aggregates)
+                  Aggregates& aggregates, const Parameters& parameters)
 {
     const catalog::NamedColumns column_names = columns.GetTableColumns();
     SelectList                  list         = {};
@@ -622,14 +782,15 @@ CompileSelectList(const Columns& columns, const AstSelectList& ast,
                         table_columns.emplace_back(column_name, column_type);
                     }
                 },
-                [&nonaggregated_columns, &aggregates, &columns, &list,
-                 &table_columns](const AstSelectList::Expr& ast_element)
+                [&nonaggregated_columns, &aggregates, &columns, &list, &table_columns,
+                 &parameters](const AstSelectList::Expr& ast_element)
                 {
                     ExprPtr expr =
                         CompileExpr(*ast_element.expr, &columns,
                                     ExprContext{.nonaggregated_columns = nonaggregated_columns,
                                                 .aggregates            = aggregates,
-                                                .inside_aggregation    = false});
+                                                .inside_aggregation    = false},
+                                    parameters);
                     const ColumnType column_type = expr->type.value_or(ColumnType::kInteger);
                     std::string      column_name =
                         ast_element.alias ? ast_element.alias->Get() : ast_element.expr->ToString();
@@ -653,21 +814,22 @@ CompileSelectList(const Columns& columns, const AstSelectList& ast,
 }
 
 [[nodiscard]] static std::tuple<Select, Columns, catalog::NamedColumns>
-CompileSelect(const AstSelect& ast)
+CompileSelect(const AstSelect& ast, const Parameters& parameters)
 {
-    auto [source, columns] = CompileSources(ast.sources);
-    ExprPtr    where       = CompileWhere(columns, ast.where);
+    auto [source, columns] = CompileSources(ast.sources, parameters);
+    ExprPtr    where       = CompileWhere(columns, ast.where, parameters);
     Aggregates aggregates  = {
          .exprs    = std::vector<Aggregates::Aggregate>{},
          .group_by = CompileGroupBy(columns, ast.group_by),
     };
     std::unordered_map<ColumnId, SourceText> nonaggregated_columns;
     auto [list, table_columns] =
-        CompileSelectList(columns, ast.list, nonaggregated_columns, aggregates);
+        CompileSelectList(columns, ast.list, nonaggregated_columns, aggregates, parameters);
     ExprPtr having = CompileHaving(columns, ast.having,
                                    ExprContext{.nonaggregated_columns = nonaggregated_columns,
                                                .aggregates            = aggregates,
-                                               .inside_aggregation    = false});
+                                               .inside_aggregation    = false},
+                                   parameters);
     if (!aggregates.exprs.empty() && aggregates.group_by.empty() && !nonaggregated_columns.empty())
     {
         throw ClientError{"nonaggregated column in aggregation",
@@ -682,7 +844,8 @@ CompileSelect(const AstSelect& ast)
 }
 
 [[nodiscard]] static OrderBy CompileOrderBy(const Columns& columns, SelectList& list,
-                                            const AstOrderBy& ast)
+                                            const Aggregates::GroupBy& group_by,
+                                            const AstOrderBy&          ast)
 {
     OrderBy order_by;
     for (const AstOrderBy::Column& ast_column : ast.columns)
@@ -697,9 +860,24 @@ CompileSelect(const AstSelect& ast)
                     }
                     return column.index.first - 1;
                 },
-                [&columns, &list](const AstExpr::DataColumn& column)
+                [&columns, &list, &group_by](const AstExpr::DataColumn& column)
                 {
-                    const auto [column_id, column_type] = columns.GetColumn(column);
+                    auto [column_id, column_type] = columns.GetColumn(column);
+                    if (!group_by.empty())
+                    {
+                        // select list is evaluated on aggregated rows, which start with keys
+                        ColumnId key_id{};
+                        while (key_id < group_by.size() && group_by.at(key_id.Get()) != column_id)
+                        {
+                            key_id++;
+                        }
+                        if (key_id == group_by.size())
+                        {
+                            throw ClientError{"nonaggregated column is not in group by clause",
+                                              column.name};
+                        }
+                        column_id = key_id;
+                    }
                     ColumnId expr_id{};
                     for (; expr_id < list.exprs.size(); expr_id++)
                     {
@@ -729,154 +907,1657 @@ CompileSelect(const AstSelect& ast)
     return order_by;
 }
 
-[[nodiscard]] static Iter CreateSourceIter(Source& source)
+// calls function for each column referenced by expression,
+// returns false if expression references aggregates
+template <typename Function> static bool ForEachExprColumn(Expr& expr, const Function& function)
 {
-    Type& type = source.type;
     return std::visit(
         Overload{
-            [&type](Source::DataTable& source) -> Iter
+            [](Expr::DataConstant&) { return true; },
+            [](Expr::DataParameter&) { return true; },
+            [&function](Expr::DataColumn& data)
             {
-                return std::make_unique<IterScan>(catalog::GetTableFileIds(source.table_id),
-                                                  std::move(type), false);
+                function(data.column_id);
+                return true;
             },
-            [&type](Source::DataJoinCross& source) -> Iter
+            [&function](Expr::DataCast& data) { return ForEachExprColumn(*data.expr, function); },
+            [&function](Expr::DataOp1& data) { return ForEachExprColumn(*data.expr, function); },
+            [&function](Expr::DataOp2& data)
             {
-                Iter iter_l = CreateSourceIter(*source.source_l);
-                Iter iter_r = CreateSourceIter(*source.source_r);
-                return std::make_unique<IterJoinCross>(std::move(iter_l), std::move(iter_r),
-                                                       std::move(type));
+                return ForEachExprColumn(*data.expr_l, function) &&
+                       ForEachExprColumn(*data.expr_r, function);
             },
-            [&type](Source::DataJoinConditional& source) -> Iter
+            [&function](Expr::DataBetween& data)
             {
-                Iter iter_l = CreateSourceIter(*source.source_l);
-                Iter iter_r = CreateSourceIter(*source.source_r);
-                return std::make_unique<IterJoinQualified>(std::move(iter_l), std::move(iter_r),
-                                                           std::move(source.condition),
-                                                           std::move(type));
+                return ForEachExprColumn(*data.expr, function) &&
+                       ForEachExprColumn(*data.min, function) &&
+                       ForEachExprColumn(*data.max, function);
+            },
+            [&function](Expr::DataIn& data)
+            {
+                return ForEachExprColumn(*data.expr, function) &&
+                       std::ranges::all_of(data.list, [&function](ExprPtr& element)
+                                           { return ForEachExprColumn(*element, function); });
             },
+            [&function](Expr::DataInSet& data) { return ForEachExprColumn(*data.expr, function); },
+            [](Expr::DataFunction&) { return false; },
         },
-        source.data);
+        expr.data);
 }
 
-[[nodiscard]] static Iter CreateSelectIter(Select& select)
+// checks if expression references some columns, all of them in range
+[[nodiscard]] static bool IsExprInRange(Expr& expr, ColumnId begin, ColumnId end)
 {
-    Iter source = CreateSourceIter(*select.source);
-    if (select.where)
+    bool       any   = false;
+    bool       all   = true;
+    const bool valid = ForEachExprColumn(expr,
+                                         [&any, &all, begin, end](ColumnId column_id)
+                                         {
+                                             any = true;
+                                             all = all && begin <= column_id && column_id < end;
+                                         });
+    return valid && any && all;
+}
+
+static void ShiftExprColumns(Expr& expr, ColumnId offset)
+{
+    std::ignore = ForEachExprColumn(expr, [offset](ColumnId& column_id)
+                                    { column_id = column_id - offset; });
+}
+
+static void SplitConjuncts(ExprPtr expr, std::vector<ExprPtr>& conjuncts)
+{
+    auto* data = std::get_if<Expr::DataOp2>(&expr->data);
+    if (data && data->op.first == Op2::kLogicAnd)
     {
-        source = std::make_unique<IterFilter>(std::move(source), std::move(select.where));
+        SplitConjuncts(std::move(data->expr_l), conjuncts);
+        SplitConjuncts(std::move(data->expr_r), conjuncts);
+        return;
     }
-    if (!select.aggregates.group_by.empty() || !select.aggregates.exprs.empty())
+    conjuncts.push_back(std::move(expr));
+}
+
+[[nodiscard]] static ExprPtr JoinConjuncts(std::vector<ExprPtr>&& conjuncts)
+{
+    ExprPtr result;
+    for (ExprPtr& conjunct : conjuncts)
     {
-        source = std::make_unique<IterAggregate>(std::move(source), std::move(select.aggregates));
+        if (!result)
+        {
+            result = std::move(conjunct);
+            continue;
+        }
+        result = std::make_unique<Expr>(
+            Expr::DataOp2{.expr_l = std::move(result),
+                          .expr_r = std::move(conjunct),
+                          .op     = std::make_pair(Op2::kLogicAnd, SourceText{})},
+            ColumnType::kBoolean);
     }
-    if (select.having)
+    return result;
+}
+
+// moves conjuncts 'l = r' comparing columns of left and right input to join keys,
+// columns of right keys are shifted to refer to right input
+[[nodiscard]] static JoinKeys ExtractJoinKeys(std::vector<ExprPtr>& conjuncts,
+                                              ColumnId column_count_l, ColumnId column_count)
+{
+    JoinKeys             keys;
+    std::vector<ExprPtr> residual;
+    for (ExprPtr& conjunct : conjuncts)
     {
-        source = std::make_unique<IterFilter>(std::move(source), std::move(select.having));
+        auto* data = std::get_if<Expr::DataOp2>(&conjunct->data);
+        if (data && data->op.first == Op2::kCompEq)
+        {
+            ExprPtr* expr_l = &data->expr_l;
+            ExprPtr* expr_r = &data->expr_r;
+            if (IsExprInRange(**expr_r, ColumnId{}, column_count_l))
+            {
+                std::swap(expr_l, expr_r);
+            }
+            if (IsExprInRange(**expr_l, ColumnId{}, column_count_l) &&
+                IsExprInRange(**expr_r, column_count_l, column_count))
+            {
+                ShiftExprColumns(**expr_r, column_count_l);
+                keys.exprs_l.push_back(std::move(*expr_l));
+                keys.exprs_r.push_back(std::move(*expr_r));
+                continue;
+            }
+        }
+        residual.push_back(std::move(conjunct));
     }
-    return std::make_unique<IterExpr>(std::move(source), std::move(select.list.exprs),
-                                      std::move(select.list.type));
+    conjuncts = std::move(residual);
+    return keys;
 }
 
-[[nodiscard]] static Iter CreateQueryIter(QueryTodo&& query)
+[[nodiscard]] static U64 EstimatePageCount(const Source& source)
 {
-    Iter iter = CreateSelectIter(query.select);
-    if (query.order_by)
+    if (source.page_count)
     {
-        iter = std::make_unique<IterSort>(std::move(iter), std::move(*query.order_by));
-        std::vector<ColumnId> columns;
-        for (ColumnId column_id{}; column_id < query.select.list.visible_count; column_id++)
+        return *source.page_count;
+    }
+    return std::visit(
+        Overload{
+            [](const Source::DataTable& source) -> U64
+            {
+                const catalog::FileIds file_ids = catalog::GetTableFileIds(source.table_id);
+                return fst::GetPageCount(file_ids.fst).Get();
+            },
+            [](const Source::DataJoinCross& source) -> U64
+            { return EstimatePageCount(*source.source_l) * EstimatePageCount(*source.source_r); },
+            [](const Source::DataJoinConditional& source) -> U64
+            {
+                return std::max(EstimatePageCount(*source.source_l),
+                                EstimatePageCount(*source.source_r));
+            },
+        },
+        source.data);
+}
+
+[[nodiscard]] static ColumnId GetTableColumn(const Source::DataTable& table, ColumnId column_id)
+{
+    return table.columns.empty() ? column_id : table.columns.at(column_id.Get());
+}
+
+// finds key of inner input which is a column of table with index on it,
+// outer key must be of the same type, so that it can be used to search the index
+[[nodiscard]] static std::optional<std::pair<std::size_t, catalog::Index>>
+FindJoinIndex(const Source& source_inner, const std::vector<ExprPtr>& keys_inner,
+              const std::vector<ExprPtr>& keys_outer)
+{
+    const auto* table = std::get_if<Source::DataTable>(&source_inner.data);
+    if (table == nullptr)
+    {
+        return std::nullopt;
+    }
+    for (catalog::Index& index : catalog::GetTableIndexes(table->table_id))
+    {
+        for (std::size_t key_index = 0; key_index < keys_inner.size(); key_index++)
         {
-            columns.push_back(column_id);
+            const auto* column = std::get_if<Expr::DataColumn>(&keys_inner[key_index]->data);
+            if (column && GetTableColumn(*table, column->column_id) == index.column_id &&
+                keys_outer[key_index]->type == source_inner.type.At(column->column_id.Get()))
+            {
+                return std::make_pair(key_index, std::move(index));
+            }
         }
-        iter = std::make_unique<IterProject>(std::move(iter), std::move(columns));
     }
-    return iter;
+    return std::nullopt;
 }
 
-[[nodiscard]] static Query CompileQuery(const AstQuery& ast)
+// Inner joins of FROM clause are reordered by estimated cost. Relations are its tables and outer
+// joins, conjuncts of join conditions and of WHERE clause which reference several relations become
+// the condition of the lowest join of all of them, those referencing one table filter its scan.
+// Sizes are estimated from statistics of tables collected by ANALYZE, or guessed without them.
+
+constexpr double kVarcharSizeGuess = 16; // of strings of tables which are not analyzed
+constexpr double kSelectivityGuess = 1.0 / 3;
+constexpr double kRowCost          = 0.01; // relative to reading a page
+
+[[nodiscard]] static Type JoinTypes(const Type& type_l, const Type& type_r)
 {
-    auto [select, columns, table_columns] = CompileSelect(ast.select);
-    std::optional<OrderBy> order_by;
-    if (ast.order_by)
+    Type type;
+    for (const Type* input : {&type_l, &type_r})
     {
-        order_by = CompileOrderBy(columns, select.list, *ast.order_by);
+        for (std::size_t i = 0; i < input->Size(); i++)
+        {
+            type.Push(input->At(i));
+        }
     }
-    QueryTodo query{.select = std::move(select), .order_by = std::move(order_by)};
-    return {.columns = std::move(table_columns),
-            .iter    = CreateQueryIter(std::move(query)),
-            .limit   = ast.limit};
+    return type;
 }
 
-[[nodiscard]] static CreateTable CompileCreateTable(AstCreateTable& ast)
+// including its slot in page, sizes of values are taken from statistics of columns if given
+[[nodiscard]] static double
+EstimateRowSize(const Type& type, const std::vector<const statistics::Column*>& statistics = {})
 {
-    std::string name = ast.name.Get(); // TODO: .get() move?
-    if (catalog::FindTable(name))
+    ASSERT(statistics.empty() || statistics.size() == type.Size());
+    double size = sizeof(page::Slotted<>::Slot);
+    for (std::size_t i = 0; i < type.Size(); i++)
     {
-        throw ClientError{"table already exists", std::move(ast.name)};
+        size += sizeof(row::ColumnPrefix);
+        if (!statistics.empty())
+        {
+            size += statistics[i]->average_size;
+            continue;
+        }
+        switch (type.At(i))
+        {
+        case ColumnType::kBoolean:
+        {
+            size += sizeof(ColumnValueBoolean);
+            break;
+        }
+        case ColumnType::kInteger:
+        {
+            size += sizeof(ColumnValueInteger);
+            break;
+        }
+        case ColumnType::kReal:
+        {
+            size += sizeof(ColumnValueReal);
+            break;
+        }
+        case ColumnType::kVarchar:
+        {
+            size += kVarcharSizeGuess;
+            break;
+        }
+        }
     }
-    return {.name = std::move(name), .columns = std::move(ast.columns)};
+    return size;
 }
 
-[[nodiscard]] static DropTable CompileDropTable(AstDropTable& ast)
+// statistics of columns of analyzed table in the given order, all of them if none are given
+[[nodiscard]] static std::vector<const statistics::Column*>
+GetColumnStatistics(const std::optional<statistics::Table>& statistics,
+                    const std::vector<ColumnId>&            columns)
 {
-    const auto& name  = ast.name.Get();
-    const auto  table = catalog::FindTable(name);
-    if (!table.has_value())
+    std::vector<const statistics::Column*> result;
+    if (!statistics)
     {
-        throw ClientError{"table does not exists", std::move(ast.name)};
+        return result;
     }
-    return {.table_id = table->first};
+    if (columns.empty())
+    {
+        for (const statistics::Column& column : statistics->columns)
+        {
+            result.push_back(&column);
+        }
+        return result;
+    }
+    for (const ColumnId column_id : columns)
+    {
+        result.push_back(&statistics->columns.at(column_id.Get()));
+    }
+    return result;
 }
 
-[[nodiscard]] static InsertValue CompileInsertValue(AstInsertValue& ast)
+// rows in the given pages of source, its statistics are used if it is analyzed table
+[[nodiscard]] static double EstimateRowCount(const Source& source, double pages)
 {
-    auto [table_id, type] = catalog::GetTable(ast.table);
-    if (ast.exprs.size() != type.Size())
+    const auto* table = std::get_if<Source::DataTable>(&source.data);
+    if (table == nullptr)
     {
-        throw ClientError{"column number mismatch"};
+        return pages * page::kSize / EstimateRowSize(source.type);
     }
-    Value value;
-    for (std::size_t i = 0; i < type.Size(); i++)
+    const std::optional<statistics::Table> statistics = catalog::FindStatistics(table->table_id);
+    if (statistics && statistics->page_count > 0)
+    {
+        // table may have changed since it was analyzed
+        return static_cast<double>(statistics->row_count) * pages /
+               static_cast<double>(statistics->page_count);
+    }
+    // pages hold whole rows
+    return pages * page::kSize / EstimateRowSize(table->table_type);
+}
+
+// inner source is table with the index on its key column
+[[nodiscard]] static bool IsJoinIndexPreferred(const Source&         source_outer,
+                                               const Source&         source_inner,
+                                               const catalog::Index& index)
+{
+    const auto&  table      = std::get<Source::DataTable>(source_inner.data);
+    const double pages      = static_cast<double>(EstimatePageCount(source_outer));
+    const double rows_outer = EstimateRowCount(source_outer, pages);
+    return IterJoinIndex::IsPreferred(rows_outer, EstimatePageCount(source_inner),
+                                      catalog::FindStatistics(table.table_id), index.column_id);
+}
+
+// conjunct of filter of table which compares indexed column with constant or parameter of the
+// same type, so that rows can be found by searching the index
+struct ScanIndex
+{
+    catalog::Index index;
+    bool           column_left; // side of comparison
+    ColumnId       column_id;   // of source
+    double         page_count;  // read by search, estimated like lookup of index join
+};
+
+[[nodiscard]] static std::optional<ScanIndex> FindScanIndex(const Source::DataTable& table,
+                                                            const Expr&              conjunct)
+{
+    const auto* data = std::get_if<Expr::DataOp2>(&conjunct.data);
+    if (data == nullptr || data->op.first != Op2::kCompEq)
     {
-        ExprPtr expr = CompileExpr(*ast.exprs[i], nullptr, std::nullopt);
-        // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
-        if (expr->type.has_value() && expr->type.value() != type.At(i))
+        return std::nullopt;
+    }
+    for (const bool column_left : {true, false})
+    {
+        const Expr& side_column = column_left ? *data->expr_l : *data->expr_r;
+        const Expr& side_key    = column_left ? *data->expr_r : *data->expr_l;
+        const auto* column      = std::get_if<Expr::DataColumn>(&side_column.data);
+        if (column == nullptr || side_column.type != side_key.type ||
+            (!std::holds_alternative<Expr::DataConstant>(side_key.data) &&
+             !std::holds_alternative<Expr::DataParameter>(side_key.data)))
+        {
+            continue;
+        }
+        const ColumnId table_column_id = GetTableColumn(table, column->column_id);
+        for (catalog::Index& index : catalog::GetTableIndexes(table.table_id))
         {
-            throw ClientError{"column type mismatch", ast.exprs[i]->text};
+            if (index.column_id == table_column_id)
+            {
+                const double page_count = IterJoinIndex::EstimateLookupPageCount(
+                    catalog::FindStatistics(table.table_id), table_column_id);
+                return ScanIndex{.index       = std::move(index),
+                                 .column_left = column_left,
+                                 .column_id   = column->column_id,
+                                 .page_count  = page_count};
+            }
         }
-        value.push_back(expr->Eval(nullptr));
     }
-    return {.table_id = table_id, .type = std::move(type), .value = std::move(value)};
+    return std::nullopt;
 }
 
-[[nodiscard]] static Statement CompileDelete(const AstDelete& ast)
+// finds conjunct for which searching index reads fewer pages than scanning table
+[[nodiscard]] static std::optional<std::pair<std::size_t, ScanIndex>>
+FindPreferredScanIndex(const Source::DataTable& table, const std::vector<ExprPtr>& conjuncts)
 {
-    auto [table_id, table_columns] = catalog::GetTableNamed(ast.table);
-    if (ast.condition_opt)
+    const catalog::FileIds file_ids   = catalog::GetTableFileIds(table.table_id);
+    const auto             page_count = static_cast<double>(fst::GetPageCount(file_ids.fst).Get());
+    for (std::size_t i = 0; i < conjuncts.size(); i++)
     {
-        const Columns columns{ast.table, table_columns};
-        auto          condition = CompileExpr(*ast.condition_opt, &columns, std::nullopt);
-        if (condition->type != ColumnType::kBoolean)
+        std::optional<ScanIndex> scan_index = FindScanIndex(table, *conjuncts[i]);
+        if (scan_index && scan_index->page_count < page_count)
         {
-            throw ClientError{"condition must be boolean", ast.condition_opt->text};
+            return std::make_pair(i, std::move(*scan_index));
         }
-        const auto file_ids  = catalog::GetTableFileIds(table_id);
-        auto       type      = catalog::GetTypeFromNamedColumns(table_columns);
-        auto       iter_scan = std::make_unique<IterScan>(file_ids, std::move(type), true);
-        auto iter_filter = std::make_unique<IterFilter>(std::move(iter_scan), std::move(condition));
-        return DeleteConditional{.table_id = table_id, .iter = std::move(iter_filter)};
     }
-    return TruncateTable{.table_id = table_id};
+    return std::nullopt;
+}
+
+struct JoinRelation
+{
+    SourcePtr                        source;
+    ColumnId                         begin, end; // columns in the original order
+    double                           row_size;
+    optimizer::Estimate              estimate;
+    std::vector<ColumnId>            indexed_columns; // of relation, if it is table
+    std::optional<statistics::Table> statistics;      // if relation is analyzed table
+};
+
+// side of equality which can be a join key
+struct JoinKeySide
+{
+    optimizer::RelationSet    relations;
+    std::optional<ColumnId>   column; // of its relation, if side is a column
+    std::optional<ColumnType> type;
+};
+
+struct JoinPredicate
+{
+    ExprPtr                                            expr;
+    optimizer::RelationSet                             relations;
+    std::optional<std::pair<JoinKeySide, JoinKeySide>> equality;
+    double                                             selectivity;
+};
+
+struct JoinGraph
+{
+    std::vector<JoinRelation>  relations;
+    std::vector<JoinPredicate> predicates;
+};
+
+[[nodiscard]] static bool IsInnerJoin(const Source& source)
+{
+    if (std::holds_alternative<Source::DataJoinCross>(source.data))
+    {
+        return true;
+    }
+    const auto* join = std::get_if<Source::DataJoinConditional>(&source.data);
+    return join && join->join == AstSource::DataJoinConditional::Join::kInner;
+}
+
+[[nodiscard]] static std::size_t CountJoinRelations(const Source& source)
+{
+    if (!IsInnerJoin(source))
+    {
+        return 1;
+    }
+    return std::visit(
+        Overload{
+            [](const Source::DataTable&) -> std::size_t { UNREACHABLE(); },
+            [](const auto& join) -> std::size_t
+            { return CountJoinRelations(*join.source_l) + CountJoinRelations(*join.source_r); },
+        },
+        source.data);
+}
+
+// moves relations of inner joins to graph and conjuncts of their conditions to conjuncts
+static void AddJoinRelations(JoinGraph& graph, SourcePtr source, ColumnId begin,
+                             std::vector<ExprPtr>& conjuncts)
+{
+    if (IsInnerJoin(*source))
+    {
+        const auto add_inputs = [&graph, begin, &conjuncts](SourcePtr& source_l,
+                                                            SourcePtr& source_r)
+        {
+            const ColumnId begin_r = begin + static_cast<ColumnId::Type>(source_l->type.Size());
+            AddJoinRelations(graph, std::move(source_l), begin, conjuncts);
+            AddJoinRelations(graph, std::move(source_r), begin_r, conjuncts);
+        };
+        if (auto* join = std::get_if<Source::DataJoinConditional>(&source->data))
+        {
+            add_inputs(join->source_l, join->source_r);
+            std::vector<ExprPtr> condition;
+            SplitConjuncts(std::move(join->condition), condition);
+            for (ExprPtr& conjunct : condition)
+            {
+                std::ignore = ForEachExprColumn(*conjunct, [begin](ColumnId& column_id)
+                                                { column_id = column_id + begin; });
+                conjuncts.push_back(std::move(conjunct));
+            }
+            return;
+        }
+        auto& join = std::get<Source::DataJoinCross>(source->data);
+        add_inputs(join.source_l, join.source_r);
+        return;
+    }
+    const double                     pages    = static_cast<double>(EstimatePageCount(*source));
+    const double                     rows     = EstimateRowCount(*source, pages);
+    double                           row_size = EstimateRowSize(source->type);
+    std::vector<ColumnId>            indexed_columns;
+    std::optional<statistics::Table> statistics;
+    if (const auto* table = std::get_if<Source::DataTable>(&source->data))
+    {
+        statistics = catalog::FindStatistics(table->table_id);
+        row_size   = EstimateRowSize(source->type, GetColumnStatistics(statistics, table->columns));
+        const std::vector<catalog::Index> indexes = catalog::GetTableIndexes(table->table_id);
+        for (ColumnId column_id{}; column_id < source->type.Size(); column_id++)
+        {
+            const ColumnId table_column_id = GetTableColumn(*table, column_id);
+            if (std::ranges::any_of(indexes, [table_column_id](const catalog::Index& index)
+                                    { return index.column_id == table_column_id; }))
+            {
+                indexed_columns.push_back(column_id);
+            }
+        }
+    }
+    const ColumnId end = begin + static_cast<ColumnId::Type>(source->type.Size());
+    graph.relations.push_back({.source          = std::move(source),
+                               .begin           = begin,
+                               .end             = end,
+                               .row_size        = row_size,
+                               .estimate        = {.rows = rows, .cost = pages},
+                               .indexed_columns = std::move(indexed_columns),
+                               .statistics      = std::move(statistics)});
+}
+
+[[nodiscard]] static std::size_t FindJoinRelation(const JoinGraph& graph, ColumnId column_id)
+{
+    for (std::size_t i = 0; i < graph.relations.size(); i++)
+    {
+        if (graph.relations[i].begin <= column_id && column_id < graph.relations[i].end)
+        {
+            return i;
+        }
+    }
+    UNREACHABLE();
+}
+
+// returns statistics of column if expression is column of analyzed table
+[[nodiscard]] static const statistics::Column* FindColumnStatistics(const JoinGraph& graph,
+                                                                    const Expr&      expr)
+{
+    const auto* column = std::get_if<Expr::DataColumn>(&expr.data);
+    if (column == nullptr)
+    {
+        return nullptr;
+    }
+    const JoinRelation& relation = graph.relations[FindJoinRelation(graph, column->column_id)];
+    if (!relation.statistics)
+    {
+        return nullptr;
+    }
+    const auto&    table     = std::get<Source::DataTable>(relation.source->data);
+    const ColumnId column_id = GetTableColumn(table, column->column_id - relation.begin);
+    return &relation.statistics->columns.at(column_id.Get());
+}
+
+// returns nothing if expression references aggregates
+[[nodiscard]] static std::optional<optimizer::RelationSet> GetExprRelations(const JoinGraph& graph,
+                                                                            Expr&            expr)
+{
+    optimizer::RelationSet relations = 0;
+    const bool             valid     = ForEachExprColumn(
+        expr, [&graph, &relations](ColumnId column_id)
+        { relations |= optimizer::RelationSet{1} << FindJoinRelation(graph, column_id); });
+    if (!valid)
+    {
+        return std::nullopt;
+    }
+    return relations;
+}
+
+// moves conjunct to graph if it references several relations
+[[nodiscard]] static bool AddJoinPredicate(JoinGraph& graph, ExprPtr& conjunct)
+{
+    const auto relations = GetExprRelations(graph, *conjunct);
+    if (!relations || std::popcount(*relations) < 2)
+    {
+        return false;
+    }
+    JoinPredicate predicate{.expr        = nullptr,
+                            .relations   = *relations,
+                            .equality    = std::nullopt,
+                            .selectivity = kSelectivityGuess};
+    auto* data = std::get_if<Expr::DataOp2>(&conjunct->data);
+    if (data && data->op.first == Op2::kCompEq)
+    {
+        const auto get_side = [&graph](Expr& expr) -> JoinKeySide
+        {
+            JoinKeySide side{.relations = GetExprRelations(graph, expr).value_or(0),
+                             .column    = std::nullopt,
+                             .type      = expr.type};
+            if (const auto* column = std::get_if<Expr::DataColumn>(&expr.data))
+            {
+                const JoinRelation& relation =
+                    graph.relations[FindJoinRelation(graph, column->column_id)];
+                side.column = column->column_id - relation.begin;
+            }
+            return side;
+        };
+        JoinKeySide side_l = get_side(*data->expr_l);
+        JoinKeySide side_r = get_side(*data->expr_r);
+        if (side_l.relations != 0 && side_r.relations != 0 &&
+            (side_l.relations & side_r.relations) == 0)
+        {
+            const statistics::Column* statistics_l = FindColumnStatistics(graph, *data->expr_l);
+            const statistics::Column* statistics_r = FindColumnStatistics(graph, *data->expr_r);
+            if (statistics_l != nullptr && statistics_r != nullptr)
+            {
+                predicate.selectivity =
+                    statistics::EstimateJoinSelectivity(*statistics_l, *statistics_r);
+            }
+            else
+            {
+                // assuming keys of the smaller side are unique, each row of the other one has a
+                // match
+                const auto get_rows = [&graph](optimizer::RelationSet relations)
+                {
+                    double rows = 1;
+                    for (std::size_t i = 0; i < graph.relations.size(); i++)
+                    {
+                        if ((relations & (optimizer::RelationSet{1} << i)) != 0)
+                        {
+                            rows = std::max(rows, graph.relations[i].estimate.rows);
+                        }
+                    }
+                    return rows;
+                };
+                predicate.selectivity =
+                    1 / std::min(get_rows(side_l.relations), get_rows(side_r.relations));
+            }
+            predicate.equality = std::make_pair(std::move(side_l), std::move(side_r));
+        }
+    }
+    predicate.expr = std::move(conjunct);
+    graph.predicates.push_back(std::move(predicate));
+    return true;
+}
+
+[[nodiscard]] static Op2 MirrorComparison(Op2 op)
+{
+    switch (op)
+    {
+    case Op2::kCompL:
+        return Op2::kCompG;
+    case Op2::kCompLe:
+        return Op2::kCompGe;
+    case Op2::kCompG:
+        return Op2::kCompL;
+    case Op2::kCompGe:
+        return Op2::kCompLe;
+    default:
+        return op;
+    }
+}
+
+[[nodiscard]] static bool IsComparison(Op2 op)
+{
+    return op == Op2::kCompL || op == Op2::kCompLe || op == Op2::kCompG || op == Op2::kCompGe ||
+           op == Op2::kCompEq || op == Op2::kCompNe;
+}
+
+// fraction of rows of table for which condition on its columns is true, conditions which do not
+// compare column with constants are guessed
+[[nodiscard]] static double EstimateFilterSelectivity(const JoinGraph& graph, const Expr& expr)
+{
+    const auto get_constant = [](const Expr& expr) -> const ColumnValue*
+    {
+        const auto* constant = std::get_if<Expr::DataConstant>(&expr.data);
+        return constant ? &constant->value : nullptr;
+    };
+    if (const auto* data = std::get_if<Expr::DataOp2>(&expr.data))
+    {
+        const Op2 op = data->op.first;
+        if (op == Op2::kLogicOr)
+        {
+            const double selectivity_l = EstimateFilterSelectivity(graph, *data->expr_l);
+            const double selectivity_r = EstimateFilterSelectivity(graph, *data->expr_r);
+            return selectivity_l + selectivity_r - (selectivity_l * selectivity_r);
+        }
+        const statistics::Column* column_l   = FindColumnStatistics(graph, *data->expr_l);
+        const statistics::Column* column_r   = FindColumnStatistics(graph, *data->expr_r);
+        const ColumnValue*        constant_l = get_constant(*data->expr_l);
+        const ColumnValue*        constant_r = get_constant(*data->expr_r);
+        if (IsComparison(op) && column_l != nullptr && constant_r != nullptr)
+        {
+            return statistics::EstimateSelectivity(*column_l, op, *constant_r);
+        }
+        if (IsComparison(op) && constant_l != nullptr && column_r != nullptr)
+        {
+            return statistics::EstimateSelectivity(*column_r, MirrorComparison(op), *constant_l);
+        }
+    }
+    if (const auto* data = std::get_if<Expr::DataBetween>(&expr.data))
+    {
+        const statistics::Column* column = FindColumnStatistics(graph, *data->expr);
+        const ColumnValue*        min    = get_constant(*data->min);
+        const ColumnValue*        max    = get_constant(*data->max);
+        if (column != nullptr && min != nullptr && max != nullptr)
+        {
+            const double not_null = 1 - column->null_fraction;
+            const double selectivity =
+                std::max(statistics::EstimateSelectivity(*column, Op2::kCompGe, *min) +
+                             statistics::EstimateSelectivity(*column, Op2::kCompLe, *max) -
+                             not_null,
+                         0.0);
+            return data->negated ? not_null - selectivity : selectivity;
+        }
+    }
+    if (const auto* data = std::get_if<Expr::DataOp1>(&expr.data))
+    {
+        const statistics::Column* column = FindColumnStatistics(graph, *data->expr);
+        if (column != nullptr && data->op.first == Op1::kIsNull)
+        {
+            return column->null_fraction;
+        }
+        if (column != nullptr && data->op.first == Op1::kIsNotNull)
+        {
+            return 1 - column->null_fraction;
+        }
+    }
+    return kSelectivityGuess;
+}
+
+// moves conjunct to filter of table if it references only that table
+[[nodiscard]] static bool AddScanFilter(JoinGraph& graph, ExprPtr& conjunct)
+{
+    const auto relations = GetExprRelations(graph, *conjunct);
+    if (!relations || !std::has_single_bit(*relations))
+    {
+        return false;
+    }
+    JoinRelation& relation = graph.relations[std::countr_zero(*relations)];
+    auto*         table    = std::get_if<Source::DataTable>(&relation.source->data);
+    if (table == nullptr)
+    {
+        return false; // outer join
+    }
+    relation.estimate.rows *= EstimateFilterSelectivity(graph, *conjunct);
+    ShiftExprColumns(*conjunct, relation.begin);
+    if (const std::optional<ScanIndex> scan_index = FindScanIndex(*table, *conjunct))
+    {
+        // table is not scanned if searching index is cheaper
+        relation.estimate.cost = std::min(relation.estimate.cost, scan_index->page_count);
+    }
+    std::vector<ExprPtr> filter;
+    if (table->filter)
+    {
+        filter.push_back(std::move(table->filter));
+    }
+    filter.push_back(std::move(conjunct));
+    table->filter = JoinConjuncts(std::move(filter));
+    return true;
+}
+
+// predicate is evaluated by join of plans if it is not evaluated by any of them
+[[nodiscard]] static bool IsJoinPredicate(const JoinPredicate& predicate,
+                                          optimizer::RelationSet relations_l,
+                                          optimizer::RelationSet relations_r)
+{
+    return (predicate.relations & ~(relations_l | relations_r)) == 0 &&
+           (predicate.relations & relations_l) != 0 && (predicate.relations & relations_r) != 0;
+}
+
+[[nodiscard]] static double EstimatePlanPageCount(const JoinGraph&       graph,
+                                                  const optimizer::Plan& plan)
+{
+    double row_size = 0;
+    for (std::size_t i = 0; i < graph.relations.size(); i++)
+    {
+        if ((plan.relations & (optimizer::RelationSet{1} << i)) != 0)
+        {
+            row_size += graph.relations[i].row_size;
+        }
+    }
+    return std::max(1.0, std::ceil(plan.estimate.rows * row_size / page::kSize));
+}
+
+// mirrors the choice of join operator by CreateSourceIter
+[[nodiscard]] static optimizer::Estimate EstimateJoin(const JoinGraph&       graph,
+                                                      const optimizer::Plan& plan_l,
+                                                      const optimizer::Plan& plan_r)
+{
+    const double           pages_l    = EstimatePlanPageCount(graph, plan_l);
+    const double           pages_r    = EstimatePlanPageCount(graph, plan_r);
+    const bool             outer_left = pages_l <= pages_r; // smaller input is outer
+    const optimizer::Plan& plan_outer = outer_left ? plan_l : plan_r;
+    const optimizer::Plan& plan_inner = outer_left ? plan_r : plan_l;
+
+    double rows     = plan_l.estimate.rows * plan_r.estimate.rows;
+    bool   keys     = false;
+    bool   sortable = true;
+    // index of inner table on key column, as relation and its column
+    std::optional<std::pair<const JoinRelation*, ColumnId>> index;
+    for (const JoinPredicate& predicate : graph.predicates)
+    {
+        if (!IsJoinPredicate(predicate, plan_l.relations, plan_r.relations))
+        {
+            continue;
+        }
+        rows *= predicate.selectivity;
+        if (!predicate.equality)
+        {
+            continue;
+        }
+        auto [side_outer, side_inner] = *predicate.equality;
+        if ((side_outer.relations & plan_outer.relations) == 0)
+        {
+            std::swap(side_outer, side_inner);
+        }
+        if ((side_outer.relations & ~plan_outer.relations) != 0 ||
+            (side_inner.relations & ~plan_inner.relations) != 0)
+        {
+            continue;
+        }
+        keys     = true;
+        sortable = sortable && side_outer.type && *side_outer.type != ColumnType::kBoolean &&
+                   side_inner.type && *side_inner.type != ColumnType::kBoolean;
+        if (!index && plan_inner.IsLeaf() && side_inner.column &&
+            side_outer.type == side_inner.type)
+        {
+            const JoinRelation& relation =
+                graph.relations[std::countr_zero(plan_inner.relations)];
+            if (std::ranges::find(relation.indexed_columns, *side_inner.column) !=
+                relation.indexed_columns.end())
+            {
+                const auto& table = std::get<Source::DataTable>(relation.source->data);
+                index.emplace(&relation, GetTableColumn(table, *side_inner.column));
+            }
+        }
+    }
+
+    const double row_cost = rows * kRowCost;
+    if (keys && index &&
+        IterJoinIndex::IsPreferred(plan_outer.estimate.rows,
+                                   static_cast<U64>(outer_left ? pages_r : pages_l),
+                                   index->first->statistics, index->second))
+    {
+        // inner table is not scanned
+        const double lookup_pages =
+            IterJoinIndex::EstimateLookupPageCount(index->first->statistics, index->second);
+        return {.rows = rows,
+                .cost = plan_outer.estimate.cost + (plan_outer.estimate.rows * lookup_pages) +
+                        row_cost};
+    }
+
+    const double inputs_cost = plan_l.estimate.cost + plan_r.estimate.cost;
+    const double work_pages  = static_cast<double>(temp::kWorkMemory) / page::kSize;
+    if (!keys)
+    {
+        // right input is read again for each block of left input
+        const double block_count = std::ceil(pages_l / work_pages);
+        return {.rows = rows,
+                .cost = inputs_cost + (block_count * pages_r) +
+                        (plan_l.estimate.rows * plan_r.estimate.rows * kRowCost) + row_cost};
+    }
+    const double input_row_cost = (plan_l.estimate.rows + plan_r.estimate.rows) * kRowCost;
+    if (sortable && std::min(pages_l, pages_r) > work_pages * temp::kPartitionCount)
+    {
+        // both inputs are sorted in runs, which are written and read once
+        return {.rows = rows,
+                .cost = inputs_cost + (2 * (pages_l + pages_r)) + input_row_cost + row_cost};
+    }
+    // both inputs are partitioned if the smaller one does not fit in work memory
+    const double spill_cost = std::min(pages_l, pages_r) > work_pages ? 2 * (pages_l + pages_r) : 0;
+    return {.rows = rows, .cost = inputs_cost + spill_cost + input_row_cost + row_cost};
+}
+
+// moves relations and predicates of graph to source which joins them as planned
+[[nodiscard]] static SourcePtr BuildJoinSource(JoinGraph&                          graph,
+                                               const std::vector<optimizer::Plan>& plans,
+                                               std::size_t                         index,
+                                               std::vector<std::size_t>&           order)
+{
+    const optimizer::Plan& plan = plans[index];
+    if (plan.IsLeaf())
+    {
+        const std::size_t relation_index = std::countr_zero(plan.relations);
+        order.push_back(relation_index);
+        SourcePtr source  = std::move(graph.relations[relation_index].source);
+        source->page_count = static_cast<U64>(EstimatePlanPageCount(graph, plan)); // filtered
+        source->estimate   = plan.estimate;
+        return source;
+    }
+    const std::size_t order_begin = order.size();
+    SourcePtr         source_l    = BuildJoinSource(graph, plans, plan.left, order);
+    SourcePtr         source_r    = BuildJoinSource(graph, plans, plan.right, order);
+
+    // columns of relations are moved to their place in joined rows
+    std::vector<ColumnId> offsets(graph.relations.size());
+    ColumnId              offset{};
+    for (std::size_t i = order_begin; i < order.size(); i++)
+    {
+        const JoinRelation& relation = graph.relations[order[i]];
+        offsets[order[i]]            = offset;
+        offset                       = offset + (relation.end - relation.begin);
+    }
+    std::vector<ExprPtr> conjuncts;
+    for (JoinPredicate& predicate : graph.predicates)
+    {
+        if (IsJoinPredicate(predicate, plans[plan.left].relations, plans[plan.right].relations))
+        {
+            std::ignore = ForEachExprColumn(
+                *predicate.expr,
+                [&graph, &offsets](ColumnId& column_id)
+                {
+                    const std::size_t relation_index = FindJoinRelation(graph, column_id);
+                    column_id = offsets[relation_index] +
+                                (column_id - graph.relations[relation_index].begin);
+                });
+            conjuncts.push_back(std::move(predicate.expr));
+        }
+    }
+
+    Type      type = JoinTypes(source_l->type, source_r->type);
+    SourcePtr source;
+    if (conjuncts.empty())
+    {
+        source = std::make_unique<Source>(
+            Source::DataJoinCross{.source_l = std::move(source_l), .source_r = std::move(source_r)},
+            std::move(type));
+    }
+    else
+    {
+        source = std::make_unique<Source>(
+            Source::DataJoinConditional{.source_l  = std::move(source_l),
+                                        .source_r  = std::move(source_r),
+                                        .join      = AstSource::DataJoinConditional::Join::kInner,
+                                        .condition = JoinConjuncts(std::move(conjuncts))},
+            std::move(type));
+    }
+    source->page_count = static_cast<U64>(EstimatePlanPageCount(graph, plan));
+    source->estimate   = plan.estimate;
+    return source;
+}
+
+// Replaces source by source with inner joins in planned order, and moves conjuncts to joins and
+// scans. If the order of columns changed, the other conjuncts are changed to reference columns of
+// the new source, and the columns in original order are returned.
+[[nodiscard]] static std::optional<std::vector<ColumnId>>
+PlanSource(SourcePtr& source, std::vector<ExprPtr>& conjuncts)
+{
+    if (CountJoinRelations(*source) > optimizer::kRelationCountMax)
+    {
+        return std::nullopt;
+    }
+    JoinGraph            graph;
+    std::vector<ExprPtr> candidates;
+    AddJoinRelations(graph, std::move(source), ColumnId{}, candidates);
+    for (ExprPtr& conjunct : conjuncts)
+    {
+        candidates.push_back(std::move(conjunct));
+    }
+    conjuncts.clear();
+    // selectivity of join predicates is estimated from unfiltered tables
+    std::vector<ExprPtr> filters;
+    for (ExprPtr& candidate : candidates)
+    {
+        if (!AddJoinPredicate(graph, candidate))
+        {
+            filters.push_back(std::move(candidate));
+        }
+    }
+    for (ExprPtr& filter : filters)
+    {
+        if (!AddScanFilter(graph, filter))
+        {
+            conjuncts.push_back(std::move(filter));
+        }
+    }
+
+    std::vector<optimizer::Estimate> estimates;
+    for (const JoinRelation& relation : graph.relations)
+    {
+        estimates.push_back(relation.estimate);
+    }
+    const std::vector<optimizer::Plan> plans =
+        optimizer::OrderJoins(estimates, [&graph](const optimizer::Plan& plan_l,
+                                                  const optimizer::Plan& plan_r)
+                              { return EstimateJoin(graph, plan_l, plan_r); });
+    std::vector<std::size_t> order;
+    source = BuildJoinSource(graph, plans, plans.size() - 1, order);
+
+    std::vector<ColumnId> offsets(graph.relations.size());
+    ColumnId              offset{};
+    for (const std::size_t relation_index : order)
+    {
+        const JoinRelation& relation = graph.relations[relation_index];
+        offsets[relation_index]      = offset;
+        offset                       = offset + (relation.end - relation.begin);
+    }
+    std::vector<ColumnId> columns;
+    bool                  reordered = false;
+    for (std::size_t i = 0; i < graph.relations.size(); i++)
+    {
+        const JoinRelation& relation = graph.relations[i];
+        for (ColumnId column_id = relation.begin; column_id < relation.end; column_id++)
+        {
+            columns.push_back(offsets[i] + (column_id - relation.begin));
+            reordered = reordered || columns.back() != column_id;
+        }
+    }
+    if (!reordered)
+    {
+        return std::nullopt;
+    }
+    for (ExprPtr& conjunct : conjuncts)
+    {
+        std::ignore = ForEachExprColumn(*conjunct, [&columns](ColumnId& column_id)
+                                        { column_id = columns[column_id.Get()]; });
+    }
+    return columns;
+}
+
+[[nodiscard]] static Iter CreateSourceIter(Source& source)
+{
+    Type& type = source.type;
+    Iter  iter = std::visit(
+        Overload{
+            [&type](Source::DataTable& source) -> Iter
+            {
+                std::vector<ExprPtr> conjuncts;
+                if (source.filter)
+                {
+                    SplitConjuncts(std::move(source.filter), conjuncts);
+                }
+                if (const auto scan_index = FindPreferredScanIndex(source, conjuncts))
+                {
+                    const auto& [conjunct_index, index] = *scan_index;
+                    auto& data = std::get<Expr::DataOp2>(conjuncts[conjunct_index]->data);
+                    ExprPtr key = std::move(index.column_left ? data.expr_r : data.expr_l);
+                    conjuncts.erase(conjuncts.begin() +
+                                    static_cast<std::ptrdiff_t>(conjunct_index));
+                    return std::make_unique<IterScanIndex>(
+                        catalog::GetTableFileIds(source.table_id).dat, std::move(type),
+                        std::move(source.columns), index.index.file_id, index.column_id,
+                        std::move(key), JoinConjuncts(std::move(conjuncts)));
+                }
+                source.filter = JoinConjuncts(std::move(conjuncts));
+                return std::make_unique<IterScan>(catalog::GetTableFileIds(source.table_id),
+                                                  std::move(type), std::move(source.columns),
+                                                  false, std::move(source.filter));
+            },
+            [&type](Source::DataJoinCross& source) -> Iter
+            {
+                Iter iter_l = CreateSourceIter(*source.source_l);
+                Iter iter_r = CreateSourceIter(*source.source_r);
+                return std::make_unique<IterJoinCross>(std::move(iter_l), std::move(iter_r),
+                                                       std::move(type));
+            },
+            [&type](Source::DataJoinConditional& source) -> Iter
+            {
+                const ColumnId column_count_l{
+                    static_cast<ColumnId::Type>(source.source_l->type.Size())};
+                const ColumnId column_count{static_cast<ColumnId::Type>(type.Size())};
+                const U64      page_count_l = EstimatePageCount(*source.source_l);
+                const U64      page_count_r = EstimatePageCount(*source.source_r);
+
+                std::vector<ExprPtr> conjuncts;
+                SplitConjuncts(std::move(source.condition), conjuncts);
+                JoinKeys keys     = ExtractJoinKeys(conjuncts, column_count_l, column_count);
+                ExprPtr  residual = JoinConjuncts(std::move(conjuncts));
+                if (!keys.exprs_l.empty())
+                {
+                    // smaller input is outer
+                    const bool outer_left   = page_count_l <= page_count_r;
+                    Source&    source_inner = outer_left ? *source.source_r : *source.source_l;
+                    const auto join_index   = FindJoinIndex(
+                        source_inner, outer_left ? keys.exprs_r : keys.exprs_l,
+                        outer_left ? keys.exprs_l : keys.exprs_r);
+                    if (join_index &&
+                        IsJoinIndexPreferred(outer_left ? *source.source_l : *source.source_r,
+                                             source_inner, join_index->second))
+                    {
+                        const auto [key_index, index] = *join_index;
+                        auto& table = std::get<Source::DataTable>(source_inner.data);
+                        if (table.filter)
+                        {
+                            // inner table is not scanned
+                            if (outer_left)
+                            {
+                                std::ignore = ForEachExprColumn(
+                                    *table.filter, [column_count_l](ColumnId& column_id)
+                                    { column_id = column_id + column_count_l; });
+                            }
+                            std::vector<ExprPtr> conditions;
+                            if (residual)
+                            {
+                                conditions.push_back(std::move(residual));
+                            }
+                            conditions.push_back(std::move(table.filter));
+                            residual = JoinConjuncts(std::move(conditions));
+                        }
+                        Iter iter_outer =
+                            CreateSourceIter(outer_left ? *source.source_l : *source.source_r);
+                        return std::make_unique<IterJoinIndex>(
+                            std::move(iter_outer), catalog::GetTableFileIds(table.table_id).dat,
+                            std::move(source_inner.type), std::move(table.columns), index.file_id,
+                            std::move(keys), key_index, std::move(residual), outer_left,
+                            std::move(type));
+                    }
+                }
+
+                Iter iter_l = CreateSourceIter(*source.source_l);
+                Iter iter_r = CreateSourceIter(*source.source_r);
+                if (keys.exprs_l.empty())
+                {
+                    return std::make_unique<IterJoinQualified>(std::move(iter_l), std::move(iter_r),
+                                                               std::move(residual),
+                                                               std::move(type));
+                }
+                if (IterJoinMerge::IsPreferred(keys, *iter_l, *iter_r, page_count_l, page_count_r))
+                {
+                    return std::make_unique<IterJoinMerge>(std::move(iter_l), std::move(iter_r),
+                                                           std::move(keys), std::move(residual),
+                                                           std::move(type));
+                }
+                return std::make_unique<IterJoinHash>(std::move(iter_l), std::move(iter_r),
+                                                      std::move(keys), std::move(residual),
+                                                      page_count_l <= page_count_r,
+                                                      std::move(type));
+            },
+        },
+        source.data);
+    iter->estimate = source.estimate;
+    return iter;
+}
+
+// Columns of tables which are not referenced by the query are not read. Conditions of joins are
+// marked before their inputs, so that a table none of whose columns are referenced keeps its first
+// column, then rows of joins and temporary files are never empty.
+static void MarkSourceColumns(Source& source, ColumnId begin, std::vector<bool>& used)
+{
+    const auto mark        = [begin, &used](ColumnId column_id)
+    { used[(begin + column_id).Get()] = true; };
+    const auto mark_inputs = [begin, &used](Source& source_l, Source& source_r)
+    {
+        const ColumnId begin_r = begin + static_cast<ColumnId::Type>(source_l.type.Size());
+        MarkSourceColumns(source_l, begin, used);
+        MarkSourceColumns(source_r, begin_r, used);
+    };
+    std::visit(
+        Overload{
+            [begin, &used, &source](Source::DataTable&)
+            {
+                const auto first = used.begin() + begin.Get();
+                const auto last  = first + static_cast<std::ptrdiff_t>(source.type.Size());
+                if (std::none_of(first, last, std::identity{}))
+                {
+                    *first = true;
+                }
+            },
+            [&mark_inputs](Source::DataJoinCross& join)
+            { mark_inputs(*join.source_l, *join.source_r); },
+            [&mark, &mark_inputs](Source::DataJoinConditional& join)
+            {
+                std::ignore = ForEachExprColumn(*join.condition, mark);
+                mark_inputs(*join.source_l, *join.source_r);
+            },
+        },
+        source.data);
+}
+
+// ids are the new ids of all columns of the whole source
+static void PruneSourceColumns(Source& source, ColumnId begin, const std::vector<bool>& used,
+                               const std::vector<ColumnId>& ids)
+{
+    std::visit(
+        Overload{
+            [begin, &used, &source](Source::DataTable& table)
+            {
+                Type type;
+                for (ColumnId column_id{}; column_id < source.type.Size(); column_id++)
+                {
+                    if (used[(begin + column_id).Get()])
+                    {
+                        table.columns.push_back(column_id);
+                        type.Push(source.type.At(column_id.Get()));
+                    }
+                }
+                if (table.columns.size() == source.type.Size())
+                {
+                    table.columns.clear();
+                }
+                source.type = std::move(type);
+            },
+            [begin, &used, &ids, &source](auto& join)
+            {
+                const ColumnId begin_r =
+                    begin + static_cast<ColumnId::Type>(join.source_l->type.Size());
+                PruneSourceColumns(*join.source_l, begin, used, ids);
+                PruneSourceColumns(*join.source_r, begin_r, used, ids);
+                if constexpr (std::is_same_v<std::decay_t<decltype(join)>,
+                                             Source::DataJoinConditional>)
+                {
+                    std::ignore = ForEachExprColumn(
+                        *join.condition, [begin, &ids](ColumnId& column_id)
+                        { column_id = ids[(begin + column_id).Get()] - ids[begin.Get()]; });
+                }
+                source.type = JoinTypes(join.source_l->type, join.source_r->type);
+            },
+        },
+        source.data);
+}
+
+static void PruneColumns(Select& select)
+{
+    const bool aggregated = !select.aggregates.group_by.empty() || !select.aggregates.exprs.empty();
+
+    // select list and having are evaluated on aggregated rows
+    std::vector<ExprPtr*> exprs;
+    if (select.where)
+    {
+        exprs.push_back(&select.where);
+    }
+    for (Aggregates::Aggregate& aggregate : select.aggregates.exprs)
+    {
+        if (aggregate.arg)
+        {
+            exprs.push_back(&aggregate.arg);
+        }
+    }
+    if (!aggregated)
+    {
+        for (ExprPtr& expr : select.list.exprs)
+        {
+            exprs.push_back(&expr);
+        }
+    }
+
+    std::vector<bool> used(select.source->type.Size());
+    const auto        mark = [&used](ColumnId column_id) { used[column_id.Get()] = true; };
+    for (ExprPtr* expr : exprs)
+    {
+        std::ignore = ForEachExprColumn(**expr, mark);
+    }
+    for (const ColumnId column_id : select.aggregates.group_by)
+    {
+        mark(column_id);
+    }
+    MarkSourceColumns(*select.source, ColumnId{}, used);
+    if (std::ranges::all_of(used, std::identity{}))
+    {
+        return;
+    }
+
+    std::vector<ColumnId> ids;
+    ColumnId              id{};
+    for (const bool column_used : used)
+    {
+        ids.push_back(id);
+        if (column_used)
+        {
+            id++;
+        }
+    }
+    PruneSourceColumns(*select.source, ColumnId{}, used, ids);
+    const auto remap = [&ids](ColumnId& column_id) { column_id = ids[column_id.Get()]; };
+    for (ExprPtr* expr : exprs)
+    {
+        std::ignore = ForEachExprColumn(**expr, remap);
+    }
+    for (ColumnId& column_id : select.aggregates.group_by)
+    {
+        remap(column_id);
+    }
+}
+
+// sort-based aggregation emits groups ordered by keys, so the rows need not be sorted again
+// if they are ordered by a prefix of group by columns
+[[nodiscard]] static bool IsOrderedByGroup(const Select& select, const OrderBy& order_by)
+{
+    if (order_by.columns.size() > select.aggregates.group_by.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < order_by.columns.size(); i++)
+    {
+        const OrderBy::Column& column = order_by.columns[i];
+        const auto*            expr   = std::get_if<Expr::DataColumn>(
+            &select.list.exprs.at(column.column_id.Get())->data);
+        if (!column.asc || !expr || expr->column_id != i)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// large table is scanned by worker threads, which also filter, and aggregate or project rows
+[[nodiscard]] static std::optional<Iter> CreateParallelSelectIter(Select& select, bool ordered)
+{
+    auto* table = std::get_if<Source::DataTable>(&select.source->data);
+    if (!table || catalog::IsSystemTable(table->table_id))
+    {
+        return std::nullopt;
+    }
+    const bool aggregated = !select.aggregates.group_by.empty() || !select.aggregates.exprs.empty();
+    if (aggregated && (select.aggregates.group_by.empty() || ordered))
+    {
+        return std::nullopt;
+    }
+    if (select.where)
+    {
+        std::vector<ExprPtr> conjuncts;
+        SplitConjuncts(std::move(select.where), conjuncts);
+        const bool indexed = FindPreferredScanIndex(*table, conjuncts).has_value();
+        select.where       = JoinConjuncts(std::move(conjuncts));
+        if (indexed)
+        {
+            return std::nullopt; // few pages are read by searching index
+        }
+    }
+    const catalog::FileIds file_ids = catalog::GetTableFileIds(table->table_id);
+    const unsigned int worker_count = parallel::GetWorkerCount(fst::GetPageCount(file_ids.fst));
+    if (worker_count <= 1)
+    {
+        return std::nullopt;
+    }
+    if (aggregated)
+    {
+        return std::make_unique<IterAggregateParallel>(
+            file_ids, select.source->type, std::move(table->columns), std::move(select.where),
+            std::move(select.aggregates), worker_count);
+    }
+    return std::make_unique<IterGather>(file_ids, std::move(select.source->type),
+                                        std::move(table->columns), std::move(select.where),
+                                        std::move(select.list.exprs), std::move(select.list.type),
+                                        worker_count);
+}
+
+[[nodiscard]] static Iter CreateSelectIter(Select& select, bool ordered)
+{
+    const bool aggregated = !select.aggregates.group_by.empty() || !select.aggregates.exprs.empty();
+    Iter       source;
+    PruneColumns(select);
+    if (std::optional<Iter> iter = CreateParallelSelectIter(select, ordered))
+    {
+        if (!aggregated)
+        {
+            return std::move(*iter); // rows are projected by workers
+        }
+        source = std::move(*iter);
+    }
+    if (!source)
+    {
+        std::vector<ExprPtr> conjuncts;
+        if (select.where)
+        {
+            SplitConjuncts(std::move(select.where), conjuncts);
+        }
+        std::optional<std::vector<ColumnId>> columns = PlanSource(select.source, conjuncts);
+        source = CreateSourceIter(*select.source);
+        if (ExprPtr where = JoinConjuncts(std::move(conjuncts)))
+        {
+            source = std::make_unique<IterFilter>(std::move(source), std::move(where));
+        }
+        if (columns)
+        {
+            source = std::make_unique<IterProject>(std::move(source), std::move(*columns));
+        }
+        if (!select.aggregates.group_by.empty() && !ordered)
+        {
+            source = std::make_unique<IterAggregateHash>(std::move(source),
+                                                         std::move(select.aggregates));
+        }
+        else if (aggregated)
+        {
+            source =
+                std::make_unique<IterAggregate>(std::move(source), std::move(select.aggregates));
+        }
+    }
+    if (select.having)
+    {
+        source = std::make_unique<IterFilter>(std::move(source), std::move(select.having));
+    }
+    return std::make_unique<IterExpr>(std::move(source), std::move(select.list.exprs),
+                                      std::move(select.list.type));
+}
+
+[[nodiscard]] static Iter CreateQueryIter(QueryTodo&& query)
+{
+    const bool ordered = query.order_by && !query.select.aggregates.group_by.empty() &&
+                         IsOrderedByGroup(query.select, *query.order_by);
+    Iter iter = CreateSelectIter(query.select, ordered);
+    if (query.order_by)
+    {
+        if (!ordered && query.limit)
+        {
+            iter = std::make_unique<IterTopN>(std::move(iter), std::move(*query.order_by),
+                                              *query.limit);
+        }
+        else if (!ordered)
+        {
+            iter = std::make_unique<IterSort>(std::move(iter), std::move(*query.order_by));
+        }
+        std::vector<ColumnId> columns;
+        for (ColumnId column_id{}; column_id < query.select.list.visible_count; column_id++)
+        {
+            columns.push_back(column_id);
+        }
+        iter = std::make_unique<IterProject>(std::move(iter), std::move(columns));
+    }
+    if (query.limit)
+    {
+        iter->SetLimit(*query.limit);
+    }
+    return iter;
+}
+
+[[nodiscard]] static Query CompileQuery(const AstQuery& ast, const Parameters& parameters)
+{
+    auto [select, columns, table_columns] = CompileSelect(ast.select, parameters);
+    std::optional<OrderBy> order_by;
+    if (ast.order_by)
+    {
+        order_by =
+            CompileOrderBy(columns, select.list, select.aggregates.group_by, *ast.order_by);
+    }
+    QueryTodo query{
+        .select = std::move(select), .order_by = std::move(order_by), .limit = ast.limit};
+    return {.columns = std::move(table_columns),
+            .iter    = CreateQueryIter(std::move(query)),
+            .limit   = ast.limit};
+}
+
+[[nodiscard]] static CreateTable CompileCreateTable(AstCreateTable& ast)
+{
+    std::string name = ast.name.Get(); // TODO: .get() move?
+    if (catalog::FindTable(name))
+    {
+        throw ClientError{"table already exists", std::move(ast.name)};
+    }
+    return {.name = std::move(name), .columns = std::move(ast.columns)};
+}
+
+[[nodiscard]] static CreateIndex CompileCreateIndex(AstCreateIndex& ast)
+{
+    std::string name = ast.name.Get();
+    if (catalog::FindIndex(name))
+    {
+        throw ClientError{"index already exists", std::move(ast.name)};
+    }
+    auto [table_id, table_columns] = catalog::GetTableNamed(ast.table);
+    const auto iter                = std::ranges::find_if(
+        table_columns, [&ast](const catalog::NamedColumn& column)
+        { return column.first == ast.column.Get(); });
+    if (iter == table_columns.end())
+    {
+        throw ClientError{"column not found", std::move(ast.column)};
+    }
+    if (iter->second == ColumnType::kBoolean)
+    {
+        throw ClientError{"invalid column type", std::move(ast.column)};
+    }
+    const ColumnId column_id{static_cast<ColumnId::Type>(iter - table_columns.begin())};
+    return {.name       = std::move(name),
+            .table_id   = table_id,
+            .table_type = catalog::GetTypeFromNamedColumns(table_columns),
+            .column_id  = column_id};
+}
+
+[[nodiscard]] static DropTable CompileDropTable(AstDropTable& ast)
+{
+    const auto& name  = ast.name.Get();
+    const auto  table = catalog::FindTable(name);
+    if (!table.has_value())
+    {
+        throw ClientError{"table does not exists", std::move(ast.name)};
+    }
+    return {.table_id = table->first};
+}
+
+[[nodiscard]] static InsertValue CompileInsertValue(AstInsertValue&   ast,
+                                                    const Parameters& parameters)
+{
+    auto [table_id, type]               = catalog::GetTable(ast.table);
+    std::vector<catalog::Index> indexes = catalog::GetTableIndexes(table_id);
+
+    std::vector<std::vector<ExprPtr>> rows;
+    for (const std::vector<AstExprPtr>& ast_exprs : ast.rows)
+    {
+        if (ast_exprs.size() != type.Size())
+        {
+            throw ClientError{"column number mismatch"};
+        }
+        std::vector<ExprPtr> exprs;
+        for (std::size_t i = 0; i < type.Size(); i++)
+        {
+            ExprPtr expr = CompileExpr(*ast_exprs[i], nullptr, std::nullopt, parameters);
+            // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+            if (expr->type.has_value() && expr->type.value() != type.At(i))
+            {
+                throw ClientError{"column type mismatch", ast_exprs[i]->text};
+            }
+            exprs.push_back(std::move(expr));
+        }
+        for (const catalog::Index& index : indexes)
+        {
+            const ExprPtr& expr = exprs[index.column_id.Get()];
+            if (IsConstant(expr) && !btree::IsKeySizeValid({expr->Eval(nullptr)}))
+            {
+                throw ClientError{"index key too long", ast_exprs[index.column_id.Get()]->text};
+            }
+        }
+        rows.push_back(std::move(exprs));
+    }
+    return {.table_id = table_id,
+            .type     = std::move(type),
+            .rows     = std::move(rows),
+            .indexes  = std::move(indexes)};
+}
+
+[[nodiscard]] static bool SourceReadsTable(const AstSource& source, const std::string& table)
+{
+    return std::visit(
+        Overload{[&table](const AstSource::DataTable& data) { return data.name.Get() == table; },
+                 [&table](const AstSource::DataJoinCross& data)
+                 {
+                     return SourceReadsTable(*data.source_l, table) ||
+                            SourceReadsTable(*data.source_r, table);
+                 },
+                 [&table](const AstSource::DataJoinConditional& data)
+                 {
+                     return SourceReadsTable(*data.source_l, table) ||
+                            SourceReadsTable(*data.source_r, table);
+                 }},
+        source.data);
+}
+
+[[nodiscard]] static InsertQuery CompileInsertQuery(AstInsertQuery&   ast,
+                                                    const Parameters& parameters)
+{
+    auto [table_id, type] = catalog::GetTable(ast.table);
+    Query query           = CompileQuery(ast.query, parameters);
+    if (query.columns.size() != type.Size())
+    {
+        throw ClientError{"column number mismatch", ast.table};
+    }
+    for (std::size_t i = 0; i < type.Size(); i++)
+    {
+        if (query.columns[i].second != type.At(i))
+        {
+            throw ClientError{"column type mismatch", ast.table};
+        }
+    }
+    // otherwise inserted rows could be read again
+    const bool materialized =
+        std::ranges::any_of(ast.query.select.sources, [&ast](const AstSourcePtr& source)
+                            { return SourceReadsTable(*source, ast.table.Get()); });
+    if (materialized)
+    {
+        query.iter = std::make_unique<IterMaterialize>(std::move(query.iter));
+    }
+    return {.table_id     = table_id,
+            .type         = std::move(type),
+            .query        = std::move(query),
+            .materialized = materialized,
+            .indexes      = catalog::GetTableIndexes(table_id)};
+}
+
+[[nodiscard]] static Statement CompileDelete(const AstDelete& ast, const Parameters& parameters)
+{
+    auto [table_id, table_columns] = catalog::GetTableNamed(ast.table);
+    if (ast.condition_opt)
+    {
+        const Columns columns{ast.table, table_columns};
+        auto          condition =
+            CompileExpr(*ast.condition_opt, &columns, std::nullopt, parameters);
+        if (condition->type != ColumnType::kBoolean)
+        {
+            throw ClientError{"condition must be boolean", ast.condition_opt->text};
+        }
+        const auto file_ids = catalog::GetTableFileIds(table_id);
+        auto       type     = catalog::GetTypeFromNamedColumns(table_columns);
+        auto       iter     = std::make_unique<IterScan>(
+            file_ids, std::move(type), std::vector<ColumnId>{}, true, std::move(condition));
+        return DeleteConditional{.table_id = table_id, .iter = std::move(iter)};
+    }
+    return TruncateTable{.table_id = table_id};
+}
+
+[[nodiscard]] static AnalyzeTables CompileAnalyze(const AstAnalyze& ast)
+{
+    AnalyzeTables statement;
+    if (ast.table)
+    {
+        auto table = catalog::GetTable(*ast.table);
+        if (catalog::IsSystemTable(table.first))
+        {
+            throw ClientError{"system table cannot be analyzed", *ast.table};
+        }
+        statement.tables.push_back(std::move(table));
+        return statement;
+    }
+    for (const std::string& name : catalog::GetTableNames())
+    {
+        auto table = catalog::FindTable(name);
+        ASSERT(table.has_value());
+        statement.tables.push_back(std::move(*table)); // NOLINT(bugprone-unchecked-optional-access)
+    }
+    return statement;
+}
+
+[[nodiscard]] static ExplainQuery CompileExplain(const AstExplain& ast,
+                                                 const Parameters& parameters)
+{
+    Query         query = CompileQuery(ast.query, parameters);
+    explain::Node plan  = explain::Describe(query.iter, ast.analyze);
+    return {.query = std::move(query), .plan = std::move(plan), .analyze = ast.analyze};
+}
+
+[[nodiscard]] static PrepareStatement CompilePrepare(AstPrepare& ast)
+{
+    std::string name = ast.name.Get();
+    if (prepare::FindStatement(name))
+    {
+        throw ClientError{"prepared statement already exists", std::move(ast.name)};
+    }
+    auto [source, parameter_count] = prepare::Normalize(ast.statement.Get());
+    return {.name            = std::move(name),
+            .source          = std::move(source),
+            .parameter_count = parameter_count};
+}
+
+[[nodiscard]] static ExecutePrepared CompileExecute(const AstExecute& ast)
+{
+    std::optional<prepare::Prepared> prepared = prepare::FindStatement(ast.name.Get());
+    if (!prepared)
+    {
+        throw ClientError{"prepared statement not found", ast.name};
+    }
+    if (ast.args.size() != prepared->parameter_count)
+    {
+        throw ClientError{"parameter number mismatch", ast.name};
+    }
+    Value parameters;
+    for (const AstExprPtr& arg : ast.args)
+    {
+        parameters.push_back(CompileExpr(*arg, nullptr, std::nullopt, {})->Eval(nullptr));
+    }
+    return {.source = std::move(prepared->source), .parameters = std::move(parameters)};
+}
+
+[[nodiscard]] static DeallocatePrepared CompileDeallocate(const AstDeallocate& ast)
+{
+    std::string name = ast.name.Get();
+    if (!prepare::FindStatement(name))
+    {
+        throw ClientError{"prepared statement not found", ast.name};
+    }
+    return {.name = std::move(name)};
+}
+
+[[nodiscard]] static CopyTable CompileCopy(AstCopy& ast)
+{
+    auto [table_id, type] = catalog::GetTable(ast.table);
+    if (catalog::IsSystemTable(table_id))
+    {
+        throw ClientError{"system table cannot be loaded", std::move(ast.table)};
+    }
+    load::Format format = load::Format::kCsv;
+    if (ast.format)
+    {
+        if (ast.format->Get() == "BINARY")
+        {
+            format = load::Format::kBinary;
+        }
+        else if (ast.format->Get() != "CSV")
+        {
+            throw ClientError{"unknown format", std::move(*ast.format)};
+        }
+    }
+    return {.table_id  = table_id,
+            .type      = std::move(type),
+            .file_name = std::move(ast.file_name),
+            .format    = format,
+            .indexes   = catalog::GetTableIndexes(table_id)};
 }
 
-[[nodiscard]] Statement CompileStatement(AstStatement& ast)
+[[nodiscard]] Statement CompileStatement(AstStatement& ast, const Parameters& parameters)
 {
     return std::visit(
         Overload{[](AstCreateTable& ast) -> Statement { return CompileCreateTable(ast); },
+                 [](AstCreateIndex& ast) -> Statement { return CompileCreateIndex(ast); },
                  [](AstDropTable& ast) -> Statement { return CompileDropTable(ast); },
-                 [](AstInsertValue& ast) -> Statement { return CompileInsertValue(ast); },
-                 [](AstQuery& ast) -> Statement { return CompileQuery(ast); },
+                 [&parameters](AstInsertValue& ast) -> Statement
+                 { return CompileInsertValue(ast, parameters); },
+                 [&parameters](AstInsertQuery& ast) -> Statement
+                 { return CompileInsertQuery(ast, parameters); },
+                 [&parameters](AstQuery& ast) -> Statement
+                 { return CompileQuery(ast, parameters); },
                  [](AstUpdate&) -> Statement { UNREACHABLE(); },
-                 [](AstDelete& ast) -> Statement { return CompileDelete(ast); }},
+                 [&parameters](AstDelete& ast) -> Statement
+                 { return CompileDelete(ast, parameters); },
+                 [](AstAnalyze& ast) -> Statement { return CompileAnalyze(ast); },
+                 [&parameters](AstExplain& ast) -> Statement
+                 { return CompileExplain(ast, parameters); },
+                 [](AstPrepare& ast) -> Statement { return CompilePrepare(ast); },
+                 [](AstExecute& ast) -> Statement { return CompileExecute(ast); },
+                 [](AstDeallocate& ast) -> Statement { return CompileDeallocate(ast); },
+                 [](AstCopy& ast) -> Statement { return CompileCopy(ast); }},
         ast);
 }
@@ -2,12 +2,17 @@
 
 #include "ast.hpp"
 #include "catalog.hpp"
+#include "explain.hpp"
+#include "expr.hpp"
 #include "iter.hpp"
+#include "load.hpp"
 #include "type.hpp"
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 struct CreateTable
 {
@@ -15,6 +20,14 @@ struct CreateTable
     catalog::NamedColumns columns;
 };
 
+struct CreateIndex
+{
+    std::string      name;
+    catalog::TableId table_id;
+    Type             table_type;
+    ColumnId         column_id;
+};
+
 struct DropTable
 {
     catalog::TableId table_id;
@@ -22,9 +35,10 @@ struct DropTable
 
 struct InsertValue
 {
-    catalog::TableId table_id;
-    Type             type; // TODO: avoid copy
-    Value            value;
+    catalog::TableId                  table_id;
+    Type                              type; // TODO: avoid copy
+    std::vector<std::vector<ExprPtr>> rows; // evaluated when executed, may read parameters
+    std::vector<catalog::Index>       indexes;
 };
 
 struct Query
@@ -34,6 +48,15 @@ struct Query
     std::optional<unsigned int> limit;
 };
 
+struct InsertQuery
+{
+    catalog::TableId            table_id;
+    Type                        type;
+    Query                       query;
+    bool                        materialized; // all rows are read first, if query reads table
+    std::vector<catalog::Index> indexes;
+};
+
 struct TruncateTable
 {
     catalog::TableId table_id;
@@ -45,7 +68,56 @@ struct DeleteConditional
     Iter             iter;
 };
 
+struct AnalyzeTables
+{
+    std::vector<std::pair<catalog::TableId, Type>> tables;
+};
+
+struct ExplainQuery
+{
+    Query         query;
+    explain::Node plan; // operators of query are instrumented if analyze is set
+    bool          analyze;
+};
+
+struct PrepareStatement
+{
+    std::string  name;
+    std::string  source; // normalized
+    unsigned int parameter_count;
+};
+
+struct ExecutePrepared
+{
+    std::string source; // of prepared statement
+    Value       parameters;
+};
+
+struct DeallocatePrepared
+{
+    std::string name;
+};
+
+struct CopyTable
+{
+    catalog::TableId            table_id;
+    Type                        type;
+    std::string                 file_name;
+    load::Format                format;
+    std::vector<catalog::Index> indexes;
+};
+
 using Statement =
-    std::variant<CreateTable, DropTable, InsertValue, Query, TruncateTable, DeleteConditional>;
+    std::variant<CreateTable, CreateIndex, DropTable, InsertValue, InsertQuery, Query,
+                 TruncateTable, DeleteConditional, AnalyzeTables, ExplainQuery, PrepareStatement,
+                 ExecutePrepared, DeallocatePrepared, CopyTable>;
+
+// Types of parameters are known when statement is compiled, their values are set before each
+// execution. Statement may be executed again if it is INSERT, SELECT or DELETE.
+struct Parameters
+{
+    std::vector<std::optional<ColumnType>> types; // none for NULL
+    std::shared_ptr<Value>                 values;
+};
 
-[[nodiscard]] Statement CompileStatement(AstStatement& ast);
+[[nodiscard]] Statement CompileStatement(AstStatement& ast, const Parameters& parameters = {});
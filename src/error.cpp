@@ -5,8 +5,12 @@
 #include <cctype>
 #include <cstdio>
 #include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 [[nodiscard]] static inline char EscapeChar(char c)
 {
@@ -30,9 +34,35 @@ void SourceText::PrintEscaped() const
     std::printf("\n");
 }
 
+std::optional<SourceText> SourceText::Relocate(const std::string& source,
+                                               const std::string& copy) const
+{
+    ASSERT(first_ && last_ && source.size() == copy.size());
+    const char* const source_end = source.c_str() + source.size();
+    if (std::less<>{}(first_, source.c_str()) || !std::less<>{}(last_, source_end))
+    {
+        return std::nullopt;
+    }
+    const char* const begin = copy.c_str() + (first_ - source.c_str());
+    const char* const end   = copy.c_str() + (last_ - source.c_str()) + 1;
+    return SourceText{begin, end};
+}
+
 void SourceText::PrintError(const std::string& source) const
 {
     ASSERT(first_ && last_);
+    // text is not in source, e.g. of statement compiled without copy of its source kept by error
+    const char* const source_end = source.c_str() + source.size();
+    if (std::less<>{}(first_, source.c_str()) || !std::less<>{}(last_, source_end))
+    {
+        std::fprintf(stderr, "\n | ");
+        for (const char c : text_)
+        {
+            std::fprintf(stderr, "%c", EscapeChar(c));
+        }
+        std::fprintf(stderr, "\n | %s\n\n", std::string(text_.size(), '^').c_str());
+        return;
+    }
     const char* padded_first = first_;
     while (padded_first > source.c_str() && padded_first[-1] != '\n' && padded_first[-1] != '\r')
     {
@@ -56,12 +86,26 @@ void SourceText::PrintError(const std::string& source) const
     std::fprintf(stderr, "\n\n");
 }
 
+void ClientError::SetSource(const std::string& source)
+{
+    if (!text_ || source_)
+    {
+        return;
+    }
+    auto copy = std::make_shared<const std::string>(source);
+    if (std::optional<SourceText> text = text_->Relocate(source, *copy))
+    {
+        text_   = std::move(*text);
+        source_ = std::move(copy);
+    }
+}
+
 void ClientError::PrintError(const std::string& source) const
 {
     std::fprintf(stderr, "client error: %s\n", what());
     if (text_)
     {
-        text_->PrintError(source);
+        text_->PrintError(source_ ? *source_ : source);
     }
 }
 
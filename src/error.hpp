@@ -57,6 +57,10 @@ public:
         return text_;
     }
 
+    // the same text in copy of source, nothing if text is not in source
+    [[nodiscard]] std::optional<SourceText> Relocate(const std::string& source,
+                                                     const std::string& copy) const;
+
     void PrintEscaped() const;
     void PrintError(const std::string& source) const;
 
@@ -75,10 +79,15 @@ public:
         : std::runtime_error{message}, text_{std::move(text)}
     {
     }
+    // keeps copy of source if text of error is in it, so that it is printed instead of source
+    // given to PrintError, e.g. text of prepared statement, which is not in statement executing it
+    void SetSource(const std::string& source);
+
     void PrintError(const std::string& source) const;
 
 private:
-    std::optional<SourceText> text_;
+    std::optional<SourceText>          text_;
+    std::shared_ptr<const std::string> source_; // shared by copies of error
 };
 
 class ServerError : public std::runtime_error
@@ -5,19 +5,23 @@
 #include "common.hpp"
 #include "compile.hpp"
 #include "error.hpp"
+#include "explain.hpp"
 #include "fst.hpp"
-#include "lexer.hpp"
+#include "index.hpp"
+#include "load.hpp"
 #include "page.hpp"
-#include "parse.hpp"
+#include "prepare.hpp"
 #include "row.hpp"
 #include "row_id.hpp"
-#include "token.hpp"
+#include "statistics.hpp"
+#include "temp.hpp"
 #include "type.hpp"
 #include "value.hpp"
 
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <memory>
 #include <optional>
 #include <ratio>
 #include <string>
@@ -25,33 +29,60 @@
 #include <variant>
 #include <vector>
 
-[[nodiscard]] std::vector<Value> ExecuteIinternalStatement(const std::string& source)
+// executes plan of statement with parameters, plan is compiled only if it is not cached
+template <typename Function>
+static void ExecutePlan(const std::string& source, const Value& parameters,
+                        const Function& function)
+{
+    const std::shared_ptr<prepare::Plan> plan = prepare::GetPlan(source, parameters);
+    *plan->parameters                         = parameters;
+    plan->running                             = true;
+    try
+    {
+        function(plan->statement);
+    }
+    catch (ClientError& error)
+    {
+        prepare::RemovePlan(source, parameters); // its operators may be left open
+        error.SetSource(plan->source);
+        throw;
+    }
+    catch (...)
+    {
+        prepare::RemovePlan(source, parameters);
+        throw;
+    }
+    plan->running = false;
+}
+
+[[nodiscard]] std::vector<Value> ExecuteIinternalStatement(const std::string& source,
+                                                           const Value&       parameters)
 {
     try
     {
-        Lexer        lexer{source};
-        AstStatement ast = ParseStatement(lexer);
-        lexer.Expect(Token::kEnd);
-        const Statement    statement = CompileStatement(ast);
         std::vector<Value> values;
-        if (const Query* const query = std::get_if<Query>(&statement))
-        {
-            query->iter->Open();
-            for (;;)
-            {
-                std::optional<Value> value = query->iter->Next();
-                if (!value)
-                {
-                    break;
-                }
-                values.push_back(std::move(*value));
-            }
-            query->iter->Close();
-        }
-        else
-        {
-            ExecuteStatement(statement);
-        }
+        ExecutePlan(source, parameters,
+                    [&values](const Statement& statement)
+                    {
+                        if (const Query* const query = std::get_if<Query>(&statement))
+                        {
+                            query->iter->Open();
+                            for (;;)
+                            {
+                                std::optional<Value> value = query->iter->Next();
+                                if (!value)
+                                {
+                                    break;
+                                }
+                                values.push_back(std::move(*value));
+                            }
+                            query->iter->Close();
+                        }
+                        else
+                        {
+                            ExecuteStatement(statement);
+                        }
+                    });
         return values;
     }
     catch (const ClientError& error)
@@ -71,31 +102,198 @@ static void ExecuteCreateTable(const CreateTable& statement)
     catalog::CreateTable(statement.name, statement.columns);
 }
 
+static void ExecuteCreateIndex(const CreateIndex& statement)
+{
+    const ColumnId column_id  = statement.column_id;
+    Type           table_type = statement.table_type;
+    Type           key_type;
+    key_type.Push(table_type.At(column_id.Get()));
+    IterScan iter{catalog::GetTableFileIds(statement.table_id), std::move(table_type), {}, true,
+                  nullptr};
+
+    // keys are checked before index is created
+    std::vector<std::pair<Value, ColumnValueInteger>> entries;
+    iter.Open();
+    for (;;)
+    {
+        std::optional<Value> value = iter.Next();
+        if (!value)
+        {
+            break;
+        }
+        Value key = {std::move(value->at(column_id.Get()))};
+        if (key.front().index() == 0)
+        {
+            continue; // NULL never matches
+        }
+        if (!btree::IsKeySizeValid(key))
+        {
+            throw ClientError{"index key too long"};
+        }
+        entries.emplace_back(std::move(key), std::get<ColumnValueInteger>(value->back()));
+    }
+    iter.Close();
+
+    const catalog::FileId file_id =
+        catalog::CreateIndex(statement.name, statement.table_id, column_id);
+    for (const auto& [key, row_id] : entries)
+    {
+        btree::Insert(file_id, key_type, key, row_id);
+    }
+}
+
 static void ExecuteDropTable(const DropTable& statement)
 {
     catalog::DropTable(statement.table_id);
 }
 
-static void ExecuteInsertValue(const InsertValue& statement)
+// Inserts rows to table. Page of the last row is kept pinned and the next rows are inserted to it
+// while they fit, so that free space tree is searched and updated once per page.
+class TableInserter
 {
-    const row::Prefix  prefix      = row::CalculateLayout(statement.value);
-    const page::Offset align       = statement.type.GetAlign();
-    const page::Offset size_padded = prefix.size + align - 1;
+public:
+    TableInserter(catalog::TableId table_id, const Type& type,
+                  const std::vector<catalog::Index>& indexes)
+        : type_{type}, indexes_{indexes}, file_ids_{catalog::GetTableFileIds(table_id)}
+    {
+    }
 
-    const auto [file_fst, file_dat] = catalog::GetTableFileIds(statement.table_id);
-    const auto [page_id, append]    = fst::FindOrAppend(file_fst, size_padded);
-    const buffer::Pin<page::Slotted<>> page{file_dat, page_id, append};
-    if (append)
+    // keys of indexes must be small enough, checked before row is inserted
+    void CheckKeys(const Value& value) const
     {
-        page->Init({});
+        for (const catalog::Index& index : indexes_)
+        {
+            if (!btree::IsKeySizeValid({value[index.column_id.Get()]}))
+            {
+                throw ClientError{"index key too long"};
+            }
+        }
     }
 
-    page::Offset free_size{};
-    U8* const    row = page->Insert(align, prefix.size, {}, &free_size);
-    ASSERT(row);
-    row::Write(prefix, statement.value, row);
+    // keys of row must be checked first
+    void Insert(const Value& value)
+    {
+        const row::Prefix  prefix = row::CalculateLayout(value);
+        const page::Offset align  = type_.GetAlign();
+        U8*                row    = nullptr;
+        if (page_.GetPage() != nullptr)
+        {
+            row = page_->Insert(align, prefix.size, {}, &free_size_);
+        }
+        if (row == nullptr)
+        {
+            Finish();
+            const page::Offset size_padded =
+                sizeof(page::Slotted<>::Slot) + prefix.size + align - 1;
+            const auto [page_id, append] = fst::FindOrAppend(file_ids_.fst, size_padded);
+            page_ = buffer::Pin<page::Slotted<>>{file_ids_.dat, page_id, append};
+            if (append)
+            {
+                page_->Init({});
+            }
+            row = page_->Insert(align, prefix.size, {}, &free_size_);
+            ASSERT(row);
+        }
+        row::Write(prefix, value, row);
 
-    fst::Update(file_fst, page_id, free_size);
+        const ColumnValueInteger row_id = PackRowId(page_.GetPageId(), page_->GetEntryCount() - 1);
+        for (const catalog::Index& index : indexes_)
+        {
+            const ColumnValue& key = value[index.column_id.Get()];
+            if (key.index() == 0)
+            {
+                continue; // NULL never matches
+            }
+            Type key_type;
+            key_type.Push(type_.At(index.column_id.Get()));
+            btree::Insert(index.file_id, key_type, {key}, row_id);
+        }
+    }
+
+    // must be called after last row, also when insert fails
+    void Finish()
+    {
+        if (page_.GetPage() != nullptr)
+        {
+            fst::Update(file_ids_.fst, page_.GetPageId(), free_size_);
+            page_ = buffer::Pin<page::Slotted<>>{};
+        }
+    }
+
+private:
+    const Type&                        type_;
+    const std::vector<catalog::Index>& indexes_;
+    const catalog::FileIds             file_ids_;
+
+    buffer::Pin<page::Slotted<>> page_;
+    page::Offset                 free_size_{};
+};
+
+static void ExecuteInsertValue(const InsertValue& statement)
+{
+    // all rows are evaluated and checked first, so that none are inserted if any is invalid
+    TableInserter      inserter{statement.table_id, statement.type, statement.indexes};
+    std::vector<Value> values;
+    values.reserve(statement.rows.size());
+    for (const std::vector<ExprPtr>& exprs : statement.rows)
+    {
+        Value& value = values.emplace_back();
+        value.reserve(exprs.size());
+        for (const ExprPtr& expr : exprs)
+        {
+            value.push_back(expr->Eval(nullptr));
+        }
+        inserter.CheckKeys(value);
+    }
+
+    try
+    {
+        for (const Value& value : values)
+        {
+            inserter.Insert(value);
+        }
+    }
+    catch (...)
+    {
+        inserter.Finish();
+        throw;
+    }
+    inserter.Finish();
+}
+
+// Rows are inserted while query is read, so rows inserted before an error (e.g. in evaluation of
+// a later row) stay in table. They are not staged, since result of query may be large.
+static void ExecuteInsertQuery(const InsertQuery& statement)
+{
+    const Query&  query = statement.query;
+    TableInserter inserter{statement.table_id, statement.type, statement.indexes};
+    query.iter->Open();
+    try
+    {
+        if (statement.materialized)
+        {
+            query.iter->Restart(); // stores all rows before any is inserted
+        }
+        unsigned int count = 0;
+        while (!query.limit || count < *query.limit)
+        {
+            std::optional<Value> value = query.iter->Next();
+            if (!value)
+            {
+                break;
+            }
+            inserter.CheckKeys(*value);
+            inserter.Insert(*value);
+            count++;
+        }
+    }
+    catch (...)
+    {
+        inserter.Finish();
+        throw;
+    }
+    inserter.Finish();
+    query.iter->Close();
 }
 
 [[nodiscard]] static std::string Pad(const std::string& string, std::size_t width, bool left)
@@ -107,6 +305,7 @@ static void ExecuteInsertValue(const InsertValue& statement)
 
 static void ExecuteQuery(const Query& query)
 {
+    temp::ResetStats();
     const auto time_start = std::chrono::high_resolution_clock::now();
     query.iter->Open();
 
@@ -190,7 +389,17 @@ static void ExecuteQuery(const Query& query)
     }
     std::printf("+\n");
 
-    std::printf("(%u rows in %.1lf ms)\n\n", count, time_delta.count());
+    const temp::Stats stats = temp::GetStats();
+    if (stats.bytes_spilled > 0)
+    {
+        std::printf("(%u rows in %.1lf ms, %u merge passes, %.1lf KB spilled)\n\n", count,
+                    time_delta.count(), stats.merge_passes,
+                    static_cast<double>(stats.bytes_spilled) / 1024);
+    }
+    else
+    {
+        std::printf("(%u rows in %.1lf ms)\n\n", count, time_delta.count());
+    }
 }
 
 static void ExecuteTruncate(const TruncateTable& statement)
@@ -220,13 +429,100 @@ static void ExecuteDelete(const DeleteConditional& statement)
     statement.iter->Close();
 }
 
+static void ExecuteAnalyze(const AnalyzeTables& statement)
+{
+    for (const auto& [table_id, type] : statement.tables)
+    {
+        const catalog::FileIds file_ids   = catalog::GetTableFileIds(table_id);
+        const page::Id         page_count = fst::GetPageCount(file_ids.fst);
+        std::vector<page::Id>  pages      = statistics::SamplePages(page_count);
+        statistics::Builder    builder{type.Size(), page_count, pages.size()};
+
+        IterScan iter{file_ids, Type{type}, {}, false, nullptr};
+        iter.SetPages(std::move(pages));
+        iter.Open();
+        for (;;)
+        {
+            std::optional<Value> value = iter.Next();
+            if (!value)
+            {
+                break;
+            }
+            builder.Add(std::move(*value));
+        }
+        iter.Close();
+
+        catalog::SetStatistics(table_id, builder.Build());
+    }
+}
+
+static void ExecuteExplain(const ExplainQuery& statement)
+{
+    unsigned int                              count = 0;
+    std::chrono::duration<double, std::milli> time_delta{};
+    if (statement.analyze)
+    {
+        const Query& query = statement.query;
+        temp::ResetStats();
+        const auto time_start = std::chrono::high_resolution_clock::now();
+        query.iter->Open();
+        while ((!query.limit || count < *query.limit) && query.iter->Next())
+        {
+            count++;
+        }
+        query.iter->Close();
+        time_delta = std::chrono::high_resolution_clock::now() - time_start;
+    }
+
+    for (const std::string& line : explain::Format(statement.plan))
+    {
+        std::printf("%s\n", line.c_str());
+    }
+    if (statement.analyze)
+    {
+        std::printf("(%u rows in %.1lf ms)\n", count, time_delta.count());
+    }
+    std::printf("\n");
+}
+
+static void ExecutePrepare(const PrepareStatement& statement)
+{
+    prepare::AddStatement(statement.name, {.source          = statement.source,
+                                           .parameter_count = statement.parameter_count});
+}
+
+static void ExecuteExecute(const ExecutePrepared& statement)
+{
+    ExecutePlan(statement.source, statement.parameters,
+                [](const Statement& statement) { ExecuteStatement(statement); });
+}
+
+static void ExecuteDeallocate(const DeallocatePrepared& statement)
+{
+    prepare::RemoveStatement(statement.name);
+}
+
+static void ExecuteCopy(const CopyTable& statement)
+{
+    load::Load(statement.table_id, statement.type, statement.indexes, statement.file_name,
+               statement.format);
+}
+
 void ExecuteStatement(const Statement& statement)
 {
     std::visit(Overload{[](const CreateTable& statement) { ExecuteCreateTable(statement); },
+                        [](const CreateIndex& statement) { ExecuteCreateIndex(statement); },
                         [](const DropTable& statement) { ExecuteDropTable(statement); },
                         [](const InsertValue& statement) { ExecuteInsertValue(statement); },
+                        [](const InsertQuery& statement) { ExecuteInsertQuery(statement); },
                         [](const Query& statement) { ExecuteQuery(statement); },
                         [](const TruncateTable& statement) { ExecuteTruncate(statement); },
-                        [](const DeleteConditional& statement) { ExecuteDelete(statement); }},
+                        [](const DeleteConditional& statement) { ExecuteDelete(statement); },
+                        [](const AnalyzeTables& statement) { ExecuteAnalyze(statement); },
+                        [](const ExplainQuery& statement) { ExecuteExplain(statement); },
+                        [](const PrepareStatement& statement) { ExecutePrepare(statement); },
+                        [](const ExecutePrepared& statement) { ExecuteExecute(statement); },
+                        [](const DeallocatePrepared& statement) { ExecuteDeallocate(statement); },
+                        [](const CopyTable& statement) { ExecuteCopy(statement); }},
                statement);
 }
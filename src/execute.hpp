@@ -5,5 +5,6 @@
 #include <string>
 #include <vector>
 
-[[nodiscard]] std::vector<Value> ExecuteIinternalStatement(const std::string& source);
+[[nodiscard]] std::vector<Value> ExecuteIinternalStatement(const std::string& source,
+                                                           const Value&       parameters = {});
 void                             ExecuteStatement(const Statement& statement);
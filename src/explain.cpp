@@ -0,0 +1,162 @@
+#include "explain.hpp"
+#include "buffer.hpp"
+#include "common.hpp"
+#include "iter.hpp"
+#include "page.hpp"
+#include "temp.hpp"
+#include "value.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace explain
+{
+// adds what happened between its construction and destruction to counters
+class Measurement
+{
+public:
+    explicit Measurement(Counters& counters)
+        : counters_{counters}, time_start_{std::chrono::steady_clock::now()},
+          buffer_start_{buffer::GetStats()}, spilled_start_{temp::GetStats().bytes_spilled}
+    {
+    }
+
+    Measurement(const Measurement&)            = delete;
+    Measurement& operator=(const Measurement&) = delete;
+    Measurement(Measurement&&)                 = delete;
+    Measurement& operator=(Measurement&&)      = delete;
+
+    ~Measurement()
+    {
+        const buffer::Stats buffer_end  = buffer::GetStats();
+        const U64           spilled_end = temp::GetStats().bytes_spilled;
+        counters_.time += std::chrono::steady_clock::now() - time_start_;
+        counters_.pins += buffer_end.pins - buffer_start_.pins;
+        counters_.hits += buffer_end.hits - buffer_start_.hits;
+        counters_.misses += buffer_end.misses - buffer_start_.misses;
+        counters_.temp_pages += (spilled_end - spilled_start_) / page::kSize;
+    }
+
+private:
+    Counters& counters_; // NOLINT(cppcoreguidelines-avoid-const-or-ref-data-members)
+
+    const std::chrono::steady_clock::time_point time_start_;
+    const buffer::Stats                         buffer_start_;
+    const U64                                   spilled_start_;
+};
+
+IterInstrument::IterInstrument(Iter&& parent)
+    : IterBase{parent->type}, parent_{std::move(parent)},
+      counters_{std::make_shared<Counters>()}
+{
+    estimate = parent_->estimate;
+}
+
+void IterInstrument::Open()
+{
+    const Measurement measurement{*counters_};
+    counters_->loops++;
+    parent_->Open();
+}
+
+void IterInstrument::Restart()
+{
+    const Measurement measurement{*counters_};
+    counters_->loops++;
+    parent_->Restart();
+}
+
+void IterInstrument::Close()
+{
+    const Measurement measurement{*counters_};
+    parent_->Close();
+}
+
+std::optional<Value> IterInstrument::Next()
+{
+    const Measurement    measurement{*counters_};
+    std::optional<Value> value = parent_->Next();
+    counters_->rows += value ? 1 : 0;
+    return value;
+}
+
+void IterInstrument::SetLimit(std::size_t count)
+{
+    parent_->SetLimit(count);
+}
+
+std::string IterInstrument::GetName() const
+{
+    return parent_->GetName();
+}
+
+std::vector<Iter*> IterInstrument::GetInputs()
+{
+    return parent_->GetInputs();
+}
+
+Node Describe(Iter& iter, bool analyze)
+{
+    Node node{
+        .name = iter->GetName(), .estimate = iter->estimate, .counters = nullptr, .inputs = {}};
+    for (Iter* input : iter->GetInputs())
+    {
+        node.inputs.push_back(Describe(*input, analyze));
+    }
+    if (analyze)
+    {
+        auto instrument = std::make_unique<IterInstrument>(std::move(iter));
+        node.counters   = instrument->GetCounters();
+        iter            = std::move(instrument);
+    }
+    return node;
+}
+
+[[nodiscard]] static std::string FormatReal(double value, int precision)
+{
+    std::array<char, 32> buffer{};
+    std::ignore = std::snprintf(buffer.data(), buffer.size(), "%.*f", precision, value);
+    return buffer.data();
+}
+
+static void Format(const Node& node, std::size_t depth, std::vector<std::string>& lines)
+{
+    std::string line = std::string(depth * 2, ' ') + node.name;
+    if (node.estimate)
+    {
+        line += "  (estimated rows=" + FormatReal(node.estimate->rows, 0) +
+                " cost=" + FormatReal(node.estimate->cost, 1) + ")";
+    }
+    if (const auto& counters = node.counters)
+    {
+        const std::chrono::duration<double, std::milli> time = counters->time;
+        line += "  (actual rows=" + std::to_string(counters->rows) +
+                " loops=" + std::to_string(counters->loops) +
+                " time=" + FormatReal(time.count(), 3) + " ms" +
+                " pins=" + std::to_string(counters->pins) +
+                " hits=" + std::to_string(counters->hits) +
+                " misses=" + std::to_string(counters->misses) +
+                " temp pages=" + std::to_string(counters->temp_pages) + ")";
+    }
+    lines.push_back(std::move(line));
+    for (const Node& input : node.inputs)
+    {
+        Format(input, depth + 1, lines);
+    }
+}
+
+std::vector<std::string> Format(const Node& node)
+{
+    std::vector<std::string> lines;
+    Format(node, 0, lines);
+    return lines;
+}
+} // namespace explain
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "common.hpp"
+#include "iter.hpp"
+#include "optimizer.hpp"
+#include "value.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// EXPLAIN shows the tree of operators of query with estimates of planner. EXPLAIN ANALYZE wraps
+// each operator by an iterator which measures its calls, operators of other queries are not
+// wrapped, so they are not slowed down.
+namespace explain
+{
+// measured during calls of operator, so they include its inputs
+struct Counters
+{
+    U64                      rows  = 0;
+    U64                      loops = 0; // opens and restarts
+    std::chrono::nanoseconds time{};
+    U64                      pins = 0, hits = 0, misses = 0; // of buffer
+    U64                      temp_pages = 0; // written, by worker threads too
+};
+
+class IterInstrument : public IterBase
+{
+public:
+    explicit IterInstrument(Iter&& parent);
+    ~IterInstrument() override = default;
+
+    void                 Open() override;
+    void                 Restart() override;
+    void                 Close() override;
+    std::optional<Value> Next() override;
+    void                 SetLimit(std::size_t count) override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
+
+    [[nodiscard]] std::shared_ptr<const Counters> GetCounters() const
+    {
+        return counters_;
+    }
+
+private:
+    Iter                      parent_;
+    std::shared_ptr<Counters> counters_; // kept by plan, operators may free their inputs early
+};
+
+struct Node
+{
+    std::string                        name;
+    std::optional<optimizer::Estimate> estimate;
+    std::shared_ptr<const Counters>    counters; // null if not analyzed
+    std::vector<Node>                  inputs;
+};
+
+// describes tree of operators, which are wrapped by IterInstrument if analyze is set
+[[nodiscard]] Node Describe(Iter& iter, bool analyze);
+
+// one line per operator, inputs are indented below it
+[[nodiscard]] std::vector<std::string> Format(const Node& node);
+} // namespace explain
@@ -10,6 +10,7 @@ ColumnValue Expr::Eval(const Value* value) const
     return std::visit(
         Overload{
             [](const Expr::DataConstant& expr) { return expr.value; },
+            [](const Expr::DataParameter& expr) { return expr.values->at(expr.index); },
             [&value](const Expr::DataColumn& expr)
             {
                 ASSERT(value);
@@ -71,6 +72,15 @@ ColumnValue Expr::Eval(const Value* value) const
                 }
                 return expr.negated ? Bool::kTrue : Bool::kFalse;
             },
+            [&value](const Expr::DataInSet& expr) -> ColumnValue
+            {
+                const Bool found = expr.list.Find(expr.expr->Eval(value));
+                if (found == Bool::kUnknown || !expr.negated)
+                {
+                    return found;
+                }
+                return found == Bool::kTrue ? Bool::kFalse : Bool::kTrue;
+            },
             [&value](const Expr::DataFunction& expr)
             {
                 ASSERT(value);
@@ -2,6 +2,7 @@
 
 #include "common.hpp"
 #include "error.hpp"
+#include "in_list.hpp"
 #include "op.hpp"
 #include "type.hpp"
 #include "value.hpp"
@@ -21,6 +22,12 @@ struct Expr
     {
         ColumnValue value;
     };
+    // values are shared by parameters of statement and are set before each execution
+    struct DataParameter
+    {
+        unsigned int                 index;
+        std::shared_ptr<const Value> values;
+    };
     struct DataColumn
     {
         ColumnId column_id;
@@ -52,13 +59,20 @@ struct Expr
         std::vector<ExprPtr> list;
         bool                 negated;
     };
+    // IN with constant list, created by constant folding
+    struct DataInSet
+    {
+        ExprPtr expr;
+        InList  list;
+        bool    negated;
+    };
     struct DataFunction
     {
         ColumnId column_id;
     };
 
-    using Data = std::variant<DataConstant, DataColumn, DataCast, DataOp1, DataOp2, DataBetween,
-                              DataIn, DataFunction>;
+    using Data = std::variant<DataConstant, DataParameter, DataColumn, DataCast, DataOp1, DataOp2,
+                              DataBetween, DataIn, DataInSet, DataFunction>;
 
     Data                      data;
     std::optional<ColumnType> type;
@@ -150,7 +150,7 @@ page::Id GetPageCount(catalog::FileId file_id)
     return page::Id{page_head->pages};
 }
 
-static page::Id Append(catalog::FileId file_id, page::Offset value)
+page::Id Append(catalog::FileId file_id, page::Offset value)
 {
     const buffer::Pin<PageHead> page_head{file_id, page::Id{}};
     if (page_head->pages % kEntriesPerPage == 0)
@@ -8,6 +8,7 @@ namespace fst
 void                      Init(catalog::FileId file_id);
 page::Id                  GetPageCount(catalog::FileId file_id);
 std::pair<page::Id, bool> FindOrAppend(catalog::FileId file_id, page::Offset size);
+page::Id                  Append(catalog::FileId file_id, page::Offset size); // caller writes page
 void                      Update(catalog::FileId file_id, page::Id page_id, page::Offset size);
 void                      Test();
 } // namespace fst
@@ -0,0 +1,71 @@
+#include "in_list.hpp"
+
+#include <utility>
+
+template <typename T> static InListSet<T> CreateSet(std::vector<ColumnValue>& values)
+{
+    std::vector<T> elements;
+    elements.reserve(values.size());
+    for (ColumnValue& value : values)
+    {
+        if (value.index() != 0)
+        {
+            elements.push_back(std::get<T>(std::move(value)));
+        }
+    }
+    return InListSet<T>{std::move(elements)};
+}
+
+InList::InList(std::vector<ColumnValue> values)
+{
+    std::optional<ColumnType> type;
+    for (const ColumnValue& value : values)
+    {
+        if (value.index() == 0)
+        {
+            has_null_ = true;
+        }
+        else if (!type)
+        {
+            type = ColumnValueToType(value);
+        }
+    }
+    if (!type)
+    {
+        return;
+    }
+    switch (*type)
+    {
+    case ColumnType::kBoolean:
+        set_ = CreateSet<ColumnValueBoolean>(values);
+        break;
+    case ColumnType::kInteger:
+        set_ = CreateSet<ColumnValueInteger>(values);
+        break;
+    case ColumnType::kReal:
+        set_ = CreateSet<ColumnValueReal>(values);
+        break;
+    case ColumnType::kVarchar:
+        set_ = CreateSet<ColumnValueVarchar>(values);
+        break;
+    }
+}
+
+Bool InList::Find(const ColumnValue& value) const
+{
+    if (value.index() == 0)
+    {
+        return Bool::kUnknown;
+    }
+    const bool found = std::visit(Overload{
+                                      [](const std::monostate&) { return false; },
+                                      [&value]<typename T>(const InListSet<T>& set)
+                                      { return set.Contains(std::get<T>(value)); },
+                                  },
+                                  set_);
+    if (found)
+    {
+        return Bool::kTrue;
+    }
+    return has_null_ ? Bool::kUnknown : Bool::kFalse;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "common.hpp"
+#include "value.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <variant>
+#include <vector>
+
+// Set of constant values of an IN list, built once at compile time.
+// Short lists are scanned without branches (the loop is vectorized by the compiler), longer lists
+// are stored in an open addressing hash table, so lookup is O(1) independently of the list size.
+
+template <typename T> class InListSet
+{
+public:
+    explicit InListSet(std::vector<T> values)
+    {
+        if (values.size() <= kLinearMaxSize)
+        {
+            slots_ = std::move(values);
+            return;
+        }
+        std::size_t capacity = 1;
+        while (capacity < values.size() * 2)
+        {
+            capacity *= 2;
+        }
+        slots_.resize(capacity);
+        used_.resize(capacity);
+        mask_ = capacity - 1;
+        for (T& value : values)
+        {
+            std::size_t slot = Hash(value) & mask_;
+            while (used_[slot] != 0 && !(slots_[slot] == value))
+            {
+                slot = (slot + 1) & mask_;
+            }
+            used_[slot]  = 1;
+            slots_[slot] = std::move(value);
+        }
+    }
+
+    [[nodiscard]] bool Contains(const T& value) const
+    {
+        if (used_.empty())
+        {
+            bool found = false;
+            for (const T& element : slots_)
+            {
+                found |= element == value;
+            }
+            return found;
+        }
+        std::size_t slot = Hash(value) & mask_;
+        while (used_[slot] != 0)
+        {
+            if (slots_[slot] == value)
+            {
+                return true;
+            }
+            slot = (slot + 1) & mask_;
+        }
+        return false;
+    }
+
+private:
+    static constexpr std::size_t kLinearMaxSize = 16;
+
+    static std::size_t Hash(const ColumnValueBoolean& value)
+    {
+        return static_cast<std::size_t>(value);
+    }
+    static std::size_t Hash(const ColumnValueInteger& value)
+    {
+        return HashMix(static_cast<U64>(value));
+    }
+    static std::size_t Hash(const ColumnValueReal& value)
+    {
+        // -0.0 and 0.0 are equal, so they must have the same hash
+        return HashMix(std::bit_cast<U64>(value == 0 ? ColumnValueReal{0} : value));
+    }
+    static std::size_t Hash(const ColumnValueVarchar& value)
+    {
+        return std::hash<ColumnValueVarchar>{}(value);
+    }
+
+    std::vector<T>  slots_;
+    std::vector<U8> used_; // empty for short lists
+    std::size_t     mask_ = 0;
+};
+
+class InList
+{
+public:
+    explicit InList(std::vector<ColumnValue> values);
+
+    // returns UNKNOWN if the value is NULL or if it is not found and the list contains NULL
+    [[nodiscard]] Bool Find(const ColumnValue& value) const;
+
+private:
+    using Set = std::variant<std::monostate, InListSet<ColumnValueBoolean>,
+                             InListSet<ColumnValueInteger>, InListSet<ColumnValueReal>,
+                             InListSet<ColumnValueVarchar>>;
+
+    Set  set_;
+    bool has_null_ = false;
+};
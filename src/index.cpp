@@ -1,3 +1,4 @@
+#include "index.hpp"
 #include "buffer.hpp"
 #include "catalog.hpp"
 #include "common.hpp"
@@ -11,6 +12,10 @@
 #include <cstring>
 #include <optional>
 #include <utility>
+#include <vector>
+
+namespace btree
+{
 
 static int CompareKeys(const Type& key_type, auto key_l, const auto& key_r)
 {
@@ -25,9 +30,6 @@ static int CompareKeys(const Type& key_type, auto key_l, const auto& key_r)
     return 0;
 }
 
-// row id
-using RID = unsigned int; // TODO
-
 struct Header
 {
     bool is_leaf;
@@ -39,7 +41,7 @@ struct LeafHeader
     page::Id prev;
     page::Id next;
 };
-using LeafEntryInfo = RID;
+using LeafEntryInfo = ColumnValueInteger; // row id
 using Leaf          = page::Slotted<LeafHeader, LeafEntryInfo>;
 
 struct InnerHeader
@@ -82,7 +84,8 @@ private:
 };
 
 static std::pair<page::Id, Value> Split(const buffer::Pin<Leaf>& page, const Type& key_type,
-                                        const Value& key, RID rid, page::EntryId index);
+                                        const Value& key, LeafEntryInfo row_id,
+                                        page::EntryId index);
 static std::pair<page::Id, Value> Split(const buffer::Pin<Inner>& page, const Type& key_type,
                                         const Value& key, page::Id page_id, page::EntryId index);
 
@@ -101,7 +104,8 @@ static std::pair<page::Id, Value> Insert(const auto& page, const Type& key_type,
 }
 
 static std::pair<page::Id, Value> Split(const buffer::Pin<Leaf>& page, const Type& key_type,
-                                        const Value& key, RID rid, page::EntryId index)
+                                        const Value& key, LeafEntryInfo row_id,
+                                        page::EntryId index)
 {
     const buffer::Pin<FileHeader> header{page.GetFileId(), page::Id{}};
 
@@ -139,13 +143,13 @@ static std::pair<page::Id, Value> Split(const buffer::Pin<Leaf>& page, const Typ
 
     if (index < entry_count_l)
     {
-        const auto result = Insert(page, key_type, key, rid, index);
+        const auto result = Insert(page, key_type, key, row_id, index);
         ASSERT(result.first == 0);
     }
     else
     {
         const auto new_index = index - entry_count_l;
-        const auto result    = Insert(new_page, key_type, key, rid, new_index);
+        const auto result    = Insert(new_page, key_type, key, row_id, new_index);
         ASSERT(result.first == 0);
     }
 
@@ -200,7 +204,7 @@ static std::pair<page::Id, Value> Split(const buffer::Pin<Inner>& page, const Ty
     return std::make_pair(new_page.GetPageId(), std::move(new_key));
 }
 
-[[maybe_unused]] static void Init(catalog::FileId file_id)
+void Init(catalog::FileId file_id)
 {
     const buffer::Pin<FileHeader> header{file_id, page::Id{}, true};
     header->Init();
@@ -210,56 +214,22 @@ static std::pair<page::Id, Value> Split(const buffer::Pin<Inner>& page, const Ty
     header->SetRoot(root.GetPageId());
 }
 
-template <typename Page>
-static auto FindLowerEntry(buffer::Pin<const Page>& page, const Type& key_type, const Value& key)
+bool IsKeySizeValid(const Value& key)
 {
-    const auto iter =
-        std::lower_bound(page->cbegin(), page->cend(), key,
-                         [&page, &key_type](const typename Page::Slot& slot, const Value& key)
-                         {
-                             return CompareKeys(key_type, page->GetEntry(slot), key) < 0; // TODO
-                         });
-    const auto index = static_cast<page::EntryId>(iter - page->cbegin());
-    if constexpr (std::is_same_v<Page, Leaf>)
-    {
-        if (index < page->get_entry_count() &&
-            CompareKeys(key_type, page->GetEntry(index), key) == 0)
-        {
-            return std::optional<page::EntryId>(index);
-        }
-        return std::optional<page::EntryId>();
-    }
-    if constexpr (std::is_same_v<Page, Inner>)
-    {
-        const bool equal = index < page->get_entry_count() &&
-                           CompareKeys(key_type, page->GetEntry(index), key) == 0;
-        const page::EntryId entry_id{equal ? index + 1 : index};
-        return entry_id > 0 ? page->GetEntryInfo(entry_id - 1) : page->get_header().leftmost_child;
-    }
-    UNREACHABLE();
+    static constexpr page::Offset kKeySizeMax = page::kSize / 8;
+    return row::CalculateLayout(key).size <= kKeySizeMax;
 }
 
+// index of first entry not less than key
 template <typename Page>
-static auto FindUpperEntry(buffer::Pin<const Page>& page, const Type& key_type, const Value& key)
+static page::EntryId FindLowerEntry(const buffer::Pin<const Page>& page, const Type& key_type,
+                                    const Value& key)
 {
     const auto iter =
-        std::upper_bound(page->cbegin(), page->cend(), key,
-                         [&page, &key_type](const Value& key, const typename Page::Slot& slot)
-                         { return CompareKeys(key_type, page->GetEntry(slot), key) > 0; });
-    const auto index = static_cast<page::EntryId>(iter - page->cbegin());
-    if constexpr (std::is_same_v<Page, Leaf>)
-    {
-        if (index > 0 && CompareKeys(key_type, page->GetEntry(index - 1), key) == 0)
-        {
-            return std::optional<page::EntryId>(index - 1);
-        }
-        return std::optional<page::EntryId>();
-    }
-    if constexpr (std::is_same_v<Page, Inner>)
-    {
-        return index > 0 ? page->GetEntryInfo(index - 1) : page->get_header().leftmost_child;
-    }
-    UNREACHABLE();
+        std::lower_bound(page->Cbegin(), page->Cend(), key,
+                         [&page, &key_type](const typename Page::Slot& slot, const Value& key)
+                         { return CompareKeys(key_type, page->GetEntry(slot), key) < 0; });
+    return static_cast<page::EntryId>(iter - page->Cbegin());
 }
 
 template <typename Page>
@@ -274,20 +244,21 @@ static page::EntryId FindInsertEntry(const buffer::Pin<Page>& page, const Type&
 }
 
 static std::pair<page ::Id, Value> InsertRecursive(catalog::FileId file_id, page::Id page_id,
-                                                   const Type& key_type, const Value& key, RID rid)
+                                                   const Type& key_type, const Value& key,
+                                                   LeafEntryInfo row_id)
 {
     buffer::Pin<Header> page{file_id, page_id};
     if (page->is_leaf)
     {
         const buffer::Pin<Leaf> leaf  = std::move(page);
         const page::EntryId     index = FindInsertEntry(leaf, key_type, key);
-        return Insert(leaf, key_type, key, rid, index);
+        return Insert(leaf, key_type, key, row_id, index);
     }
     const buffer::Pin<Inner> inner = std::move(page);
     const page::EntryId      index = FindInsertEntry(inner, key_type, key);
     const auto               child =
         index > 0 ? inner->GetEntryInfo(index - 1) : inner->GetHeader().leftmost_child;
-    auto overflow = InsertRecursive(file_id, child, key_type, key, rid);
+    auto overflow = InsertRecursive(file_id, child, key_type, key, row_id);
     if (overflow.first != 0)
     {
         return Insert(inner, key_type, overflow.second, overflow.first, index);
@@ -295,11 +266,11 @@ static std::pair<page ::Id, Value> InsertRecursive(catalog::FileId file_id, page
     return {};
 }
 
-[[maybe_unused]] static void Insert(catalog::FileId file_id, const Type& key_type, const Value& key,
-                                    RID rid)
+void Insert(catalog::FileId file_id, const Type& key_type, const Value& key,
+            ColumnValueInteger row_id)
 {
     const buffer::Pin<FileHeader> header{file_id, page::Id{}};
-    const auto overflow = InsertRecursive(file_id, header->GetRoot(), key_type, key, rid);
+    const auto overflow = InsertRecursive(file_id, header->GetRoot(), key_type, key, row_id);
     if (overflow.first != 0)
     {
         const buffer::Pin<Inner> inner{file_id, header->Alloc(), true};
@@ -310,6 +281,45 @@ static std::pair<page ::Id, Value> InsertRecursive(catalog::FileId file_id, page
         header->SetRoot(inner.GetPageId());
     }
 }
+
+void Find(catalog::FileId file_id, const Type& key_type, const Value& key,
+          std::vector<ColumnValueInteger>& row_ids_out)
+{
+    // equal keys may be split among more leaves, so descend to the leftmost of them
+    const buffer::Pin<const FileHeader> header{file_id, page::Id{}};
+    buffer::Pin<const Header>           page{file_id, header->GetRoot()};
+    while (!page->is_leaf)
+    {
+        const buffer::Pin<const Inner> inner = std::move(page);
+        const page::EntryId            index = FindLowerEntry(inner, key_type, key);
+        const page::Id                 child =
+            index > 0 ? inner->GetEntryInfo(index - 1) : inner->GetHeader().leftmost_child;
+        page = buffer::Pin<const Header>{file_id, child};
+    }
+    buffer::Pin<const Leaf> leaf  = std::move(page);
+    page::EntryId           index = FindLowerEntry(leaf, key_type, key);
+    for (;;)
+    {
+        if (index == leaf->GetEntryCount())
+        {
+            const page::Id next = leaf->GetHeader().next;
+            if (next == 0)
+            {
+                return;
+            }
+            leaf  = buffer::Pin<const Leaf>{file_id, next};
+            index = page::EntryId{};
+            continue;
+        }
+        if (CompareKeys(key_type, leaf->GetEntry(index), key) != 0)
+        {
+            return;
+        }
+        row_ids_out.push_back(leaf->GetEntryInfo(index++));
+    }
+}
+
+} // namespace btree
 /*
 #include <map>
 
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "catalog.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include <vector>
+
+// B+tree index, maps keys to row ids, duplicate keys are allowed
+namespace btree
+{
+void Init(catalog::FileId file_id);
+
+// keys must be small enough, so that each node can be split
+[[nodiscard]] bool IsKeySizeValid(const Value& key);
+
+void Insert(catalog::FileId file_id, const Type& key_type, const Value& key,
+            ColumnValueInteger row_id);
+
+// appends row ids of all entries with equal key
+void Find(catalog::FileId file_id, const Type& key_type, const Value& key,
+          std::vector<ColumnValueInteger>& row_ids_out);
+} // namespace btree
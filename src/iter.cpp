@@ -1,15 +1,24 @@
 #include "iter.hpp"
 #include "buffer.hpp"
+#include "catalog.hpp"
 #include "common.hpp"
 #include "expr.hpp"
+#include "fst.hpp"
+#include "index.hpp"
+#include "os.hpp"
 #include "page.hpp"
 #include "row.hpp"
 #include "row_id.hpp"
+#include "temp.hpp"
 #include "type.hpp"
 #include "value.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <memory>
 #include <optional>
+#include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -28,6 +37,11 @@ void IterProject::Close()
     parent_->Close();
 }
 
+void IterProject::SetLimit(std::size_t count)
+{
+    parent_->SetLimit(count);
+}
+
 std::optional<Value> IterProject::Next()
 {
     std::optional<Value> value = parent_->Next();
@@ -38,6 +52,16 @@ std::optional<Value> IterProject::Next()
     return MapValue(std::move(*value), columns_);
 }
 
+std::string IterProject::GetName() const
+{
+    return "Project";
+}
+
+std::vector<Iter*> IterProject::GetInputs()
+{
+    return {&parent_};
+}
+
 Type IterProject::MapType(const Type& type, const std::vector<ColumnId>& columns)
 {
     Type new_type;
@@ -73,6 +97,11 @@ void IterExpr::Close()
     parent_->Close();
 }
 
+void IterExpr::SetLimit(std::size_t count)
+{
+    parent_->SetLimit(count);
+}
+
 std::optional<Value> IterExpr::Next()
 {
     const std::optional<Value> value = parent_->Next();
@@ -88,10 +117,23 @@ std::optional<Value> IterExpr::Next()
     return result;
 }
 
+std::string IterExpr::GetName() const
+{
+    return "Evaluate";
+}
+
+std::vector<Iter*> IterExpr::GetInputs()
+{
+    return {&parent_};
+}
+
 void IterScan::Open()
 {
-    page_id_  = {};
-    entry_id_ = {};
+    page_count_ =
+        pages_ ? static_cast<page::Id>(pages_->size()) : fst::GetPageCount(file_ids_.fst);
+    page_index_ = 0;
+    entry_id_   = {};
+    row_count_  = 0;
 }
 
 void IterScan::Restart()
@@ -104,21 +146,36 @@ void IterScan::Close()
     page_ = buffer::Pin<const page::Slotted<>>{};
 }
 
+void IterScan::SetLimit(std::size_t count)
+{
+    limit_ = count;
+}
+
+void IterScan::SetPages(std::vector<page::Id>&& pages)
+{
+    pages_ = std::move(pages);
+}
+
 std::optional<Value> IterScan::Next()
 {
+    if (limit_ && row_count_ == *limit_)
+    {
+        return std::nullopt;
+    }
     for (;;)
     {
         if (entry_id_ == 0)
         {
-            if (page_id_ == page_count_)
+            if (page_index_ == page_count_.Get())
             {
                 return std::nullopt;
             }
-            page_ = buffer::Pin<const page::Slotted<>>{file_id_, page_id_};
+            page_id_ = pages_ ? (*pages_)[page_index_] : static_cast<page::Id>(page_index_);
+            page_    = buffer::Pin<const page::Slotted<>>{file_ids_.dat, page_id_};
         }
         if (entry_id_ == page_->GetEntryCount())
         {
-            page_id_++;
+            page_index_++;
             entry_id_ = page::EntryId{};
             continue;
         }
@@ -128,14 +185,94 @@ std::optional<Value> IterScan::Next()
         {
             continue;
         }
-        auto value = row::Read(type, entry);
+        auto value = row::Read(type, columns_, entry);
+        if (filter_ && std::get<ColumnValueBoolean>(filter_->Eval(&value)) != Bool::kTrue)
+        {
+            continue;
+        }
         if (emit_row_id_)
         {
             const auto row_id = PackRowId(page_id_, curr_entry_id);
             value.emplace_back(row_id); // TODO: is it safe? does not match type, hidden column
         }
+        if (limit_ && ++row_count_ == *limit_)
+        {
+            page_ = buffer::Pin<const page::Slotted<>>{}; // not needed any more
+        }
+        return value;
+    }
+}
+
+std::string IterScan::GetName() const
+{
+    std::string name = "Scan " + catalog::GetFileName(file_ids_.dat);
+    if (filter_)
+    {
+        name += " with filter";
+    }
+    return name;
+}
+
+void IterScanIndex::Open()
+{
+    key_value_ = key_->Eval(nullptr);
+    row_ids_.clear();
+    row_index_ = 0;
+    if (key_value_.index() != 0)
+    {
+        btree::Find(file_index_, key_type_, {key_value_}, row_ids_);
+        std::ranges::sort(row_ids_); // ordered by page
+    }
+}
+
+void IterScanIndex::Restart()
+{
+    row_index_ = 0;
+}
+
+void IterScanIndex::Close()
+{
+    page_ = buffer::Pin<const page::Slotted<>>{};
+    row_ids_.clear();
+}
+
+std::optional<Value> IterScanIndex::Next()
+{
+    while (row_index_ < row_ids_.size())
+    {
+        const auto [page_id, entry_id] = UnpackRowId(row_ids_[row_index_++]);
+        if (page_.GetPage() == nullptr || page_.GetPageId() != page_id)
+        {
+            page_ = buffer::Pin<const page::Slotted<>>{file_data_, page_id};
+        }
+        const U8* const entry = page_->GetEntry(entry_id);
+        if (entry == nullptr)
+        {
+            continue; // deleted row
+        }
+        Value value = row::Read(type, columns_, entry);
+        if (value[key_column_.Get()] != key_value_)
+        {
+            continue;
+        }
+        if (filter_ && std::get<ColumnValueBoolean>(filter_->Eval(&value)) != Bool::kTrue)
+        {
+            continue;
+        }
         return value;
     }
+    return std::nullopt;
+}
+
+std::string IterScanIndex::GetName() const
+{
+    std::string name = "Index Scan " + catalog::GetFileName(file_data_) + " using " +
+                       catalog::GetFileName(file_index_);
+    if (filter_)
+    {
+        name += " with filter";
+    }
+    return name;
 }
 
 void IterScanTemp::Open()
@@ -180,48 +317,199 @@ std::optional<Value> IterScanTemp::Next()
     }
 }
 
+std::string IterScanTemp::GetName() const
+{
+    return "Scan Temporary File";
+}
+
+void IterMaterialize::Open()
+{
+    parent_->Open();
+    complete_  = false;
+    rows_size_ = 0;
+    row_index_ = 0;
+    rows_.clear();
+    output_.reset();
+    file_.reset();
+}
+
+void IterMaterialize::Restart()
+{
+    while (!complete_)
+    {
+        std::ignore = Next();
+    }
+    row_index_ = 0;
+    if (file_)
+    {
+        input_.Init(*file_, page::Id{}, page_count_);
+    }
+}
+
+void IterMaterialize::Close()
+{
+    parent_->Close();
+    rows_.clear();
+    output_.reset();
+    file_.reset();
+}
+
+std::optional<Value> IterMaterialize::Next()
+{
+    if (!complete_)
+    {
+        std::optional<Value> value = parent_->Next();
+        if (!value)
+        {
+            Complete();
+            return std::nullopt;
+        }
+        Store(*value);
+        return value;
+    }
+    if (row_index_ < rows_.size())
+    {
+        return rows_[row_index_++];
+    }
+    if (file_)
+    {
+        page::Offset    size = 0;
+        const U8* const row  = input_.Next(size);
+        if (row != nullptr)
+        {
+            return row::Read(type, row);
+        }
+    }
+    return std::nullopt;
+}
+
+std::string IterMaterialize::GetName() const
+{
+    return "Materialize";
+}
+
+std::vector<Iter*> IterMaterialize::GetInputs()
+{
+    return {&parent_};
+}
+
+void IterMaterialize::Store(const Value& value)
+{
+    if (!file_)
+    {
+        rows_size_ += ValueMemorySize(value);
+        if (rows_size_ <= temp::kWorkMemory)
+        {
+            rows_.push_back(value);
+            return;
+        }
+        file_.emplace();
+        output_.emplace(*file_);
+    }
+    output_->Append(value, type.GetAlign());
+}
+
+void IterMaterialize::Complete()
+{
+    complete_ = true;
+    if (output_)
+    {
+        page_count_ = output_->EndSection().second;
+        output_.reset();
+    }
+}
+
 void IterJoinCross::Open()
 {
     iter_l_->Open();
     iter_r_->Open();
-    value_l_ = iter_l_->Next();
+    done_l_ = false;
+    value_r_.reset();
+    NextBlock();
 }
 
 void IterJoinCross::Restart()
 {
     iter_l_->Restart();
     iter_r_->Restart();
-    value_l_ = iter_l_->Next();
+    done_l_ = false;
+    value_r_.reset();
+    NextBlock();
+}
+
+void IterJoinCross::SetLimit(std::size_t count)
+{
+    limit_ = count;
+    iter_l_->SetLimit(count);
 }
 
 void IterJoinCross::Close()
 {
     iter_l_->Close();
     iter_r_->Close();
+    block_l_.clear();
 }
 
 std::optional<Value> IterJoinCross::Next()
 {
     for (;;)
     {
-        if (!value_l_)
+        if (value_r_ && block_index_ < block_l_.size())
+        {
+            const Value& value_l = block_l_[block_index_++];
+            Value        value;
+            value.reserve(value_l.size() + value_r_->size());
+            value.insert(value.end(), value_l.begin(), value_l.end());
+            value.insert(value.end(), value_r_->begin(), value_r_->end());
+            return value;
+        }
+        if (block_l_.empty())
         {
             return std::nullopt;
         }
-        std::optional<Value> value_r = iter_r_->Next();
-        if (!value_r)
+        block_index_ = 0;
+        value_r_     = iter_r_->Next();
+        if (!value_r_)
         {
+            if (!NextBlock())
+            {
+                return std::nullopt;
+            }
             iter_r_->Restart();
-            value_l_ = iter_l_->Next();
-            continue;
         }
-        Value value;
-        value.insert(value.end(), value_l_->begin(), value_l_->end());
-        value.insert(value.end(), value_r->begin(), value_r->end());
-        return value;
     }
 }
 
+std::string IterJoinCross::GetName() const
+{
+    return "Nested Loop Join";
+}
+
+std::vector<Iter*> IterJoinCross::GetInputs()
+{
+    return {&iter_l_, &iter_r_};
+}
+
+// returns false if there are no more left rows
+bool IterJoinCross::NextBlock()
+{
+    block_l_.clear();
+    block_index_           = 0;
+    std::size_t block_size = 0;
+    while (!done_l_ && block_size < temp::kWorkMemory && (!limit_ || block_l_.size() < *limit_))
+    {
+        std::optional<Value> value = iter_l_->Next();
+        if (!value)
+        {
+            done_l_ = true;
+            break;
+        }
+        block_size += ValueMemorySize(*value);
+        block_l_.push_back(std::move(*value));
+    }
+    return !block_l_.empty();
+}
+
 void IterJoinQualified::Open()
 {
     parent_->Open();
@@ -255,6 +543,16 @@ std::optional<Value> IterJoinQualified::Next()
     }
 }
 
+std::string IterJoinQualified::GetName() const
+{
+    return "Join Filter";
+}
+
+std::vector<Iter*> IterJoinQualified::GetInputs()
+{
+    return {&parent_};
+}
+
 void IterFilter::Open()
 {
     parent_->Open();
@@ -287,3 +585,13 @@ std::optional<Value> IterFilter::Next()
         return value;
     }
 }
+
+std::string IterFilter::GetName() const
+{
+    return "Filter";
+}
+
+std::vector<Iter*> IterFilter::GetInputs()
+{
+    return {&parent_};
+}
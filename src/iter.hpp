@@ -4,17 +4,24 @@
 #include "catalog.hpp"
 #include "common.hpp"
 #include "expr.hpp"
-#include "fst.hpp"
+#include "optimizer.hpp"
 #include "os.hpp"
 #include "page.hpp"
+#include "temp.hpp"
 #include "type.hpp"
 #include "value.hpp"
 
+#include <cstddef>
 #include <memory>
 #include <optional>
+#include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+struct IterBase;
+using Iter = std::unique_ptr<IterBase>;
+
 struct IterBase
 {
     explicit IterBase(Type type) noexcept : type{std::move(type)}
@@ -27,10 +34,27 @@ struct IterBase
     virtual void                               Close()   = 0;
     [[nodiscard]] virtual std::optional<Value> Next()    = 0;
 
-    Type type;
-};
+    // At most count rows will be read after each open or restart, so that operators can stop
+    // reading ahead. Operators which return at most one row per row of parent pass it on.
+    virtual void SetLimit(std::size_t count)
+    {
+        std::ignore = count;
+    }
 
-using Iter = std::unique_ptr<IterBase>;
+    // shown by EXPLAIN, inputs are the iterators owned by operator which were created with it
+    [[nodiscard]] virtual std::string        GetName() const = 0;
+    [[nodiscard]] virtual std::vector<Iter*> GetInputs()
+    {
+        return {};
+    }
+
+    Type                               type;
+    std::optional<optimizer::Estimate> estimate; // set by planner for scans and joins
+
+    // each is a list of columns by which rows are emitted in ascending order, without NULLs, set
+    // by operators whose output is known to be sorted
+    std::vector<std::vector<ColumnId>> sorted_by;
+};
 
 class IterProject : public IterBase
 {
@@ -46,6 +70,9 @@ public:
     void                 Restart() override;
     void                 Close() override;
     std::optional<Value> Next() override;
+    void                 SetLimit(std::size_t count) override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
 
 private:
     static Type  MapType(const Type& type, const std::vector<ColumnId>& columns);
@@ -68,18 +95,24 @@ public:
     void                 Restart() override;
     void                 Close() override;
     std::optional<Value> Next() override;
+    void                 SetLimit(std::size_t count) override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
 
 private:
     Iter                       parent_;
     const std::vector<ExprPtr> exprs_;
 };
 
+// Reads only the given columns of table, all of them if there are none, type is of the columns
+// read. Rows for which filter is not true are skipped.
 class IterScan : public IterBase
 {
 public:
-    IterScan(catalog::FileIds file_ids, Type&& type, bool emit_row_id)
-        : IterBase{std::move(type)}, emit_row_id_{emit_row_id}, file_id_{file_ids.dat},
-          page_count_{fst::GetPageCount(file_ids.fst)}
+    IterScan(catalog::FileIds file_ids, Type&& type, std::vector<ColumnId>&& columns,
+             bool emit_row_id, ExprPtr&& filter)
+        : IterBase{std::move(type)}, columns_{std::move(columns)}, emit_row_id_{emit_row_id},
+          filter_{std::move(filter)}, file_ids_{file_ids}
     {
     }
     ~IterScan() override = default;
@@ -88,16 +121,67 @@ public:
     void                 Restart() override;
     void                 Close() override;
     std::optional<Value> Next() override;
+    void                 SetLimit(std::size_t count) override;
+    std::string          GetName() const override;
+
+    // reads only the given pages in their order, instead of all pages of table
+    void SetPages(std::vector<page::Id>&& pages);
 
 private:
-    const bool emit_row_id_;
+    const std::vector<ColumnId> columns_;
+    const bool                  emit_row_id_;
+    const ExprPtr               filter_;
 
-    const catalog::FileId file_id_;
-    const page::Id        page_count_;
+    const catalog::FileIds               file_ids_;
+    page::Id                             page_count_; // read at open, plan may be executed again
+    std::optional<std::vector<page::Id>> pages_;      // all pages are read if not set
 
+    std::size_t   page_index_; // of pages read
     page::Id      page_id_;
     page::EntryId entry_id_;
 
+    std::optional<std::size_t> limit_;
+    std::size_t                row_count_ = 0; // since open
+
+    buffer::Pin<const page::Slotted<>> page_;
+};
+
+// Reads rows of table whose column is equal to key, by searching index on the column. Key is
+// evaluated at open, the found row ids are sorted, so that each page of table is read only once.
+// Column of rows is compared with key again, since entries of index are not removed with rows.
+class IterScanIndex : public IterBase
+{
+public:
+    IterScanIndex(catalog::FileId file_data, Type&& type, std::vector<ColumnId>&& columns,
+                  catalog::FileId file_index, ColumnId key_column, ExprPtr&& key,
+                  ExprPtr&& filter)
+        : IterBase{std::move(type)}, columns_{std::move(columns)}, file_data_{file_data},
+          file_index_{file_index}, key_column_{key_column}, key_{std::move(key)},
+          filter_{std::move(filter)}
+    {
+        key_type_.Push(IterBase::type.At(key_column_.Get()));
+    }
+    ~IterScanIndex() override = default;
+
+    void                 Open() override;
+    void                 Restart() override;
+    void                 Close() override;
+    std::optional<Value> Next() override;
+    std::string          GetName() const override;
+
+private:
+    const std::vector<ColumnId> columns_;
+    const catalog::FileId       file_data_;
+    const catalog::FileId       file_index_;
+    const ColumnId              key_column_; // of rows read
+    const ExprPtr               key_;
+    const ExprPtr               filter_;
+    Type                        key_type_;
+
+    ColumnValue                     key_value_;
+    std::vector<ColumnValueInteger> row_ids_;
+    std::size_t                     row_index_ = 0;
+
     buffer::Pin<const page::Slotted<>> page_;
 };
 
@@ -115,6 +199,7 @@ public:
     void                 Restart() override;
     void                 Close() override;
     std::optional<Value> Next() override;
+    std::string          GetName() const override;
 
 private:
     const os::TempFile file_;
@@ -126,11 +211,48 @@ private:
     buffer::Buffer<page::Slotted<>> page_;
 };
 
+// Stores rows of parent during the first pass, so that restart does not evaluate parent again.
+// Rows are kept in memory up to work memory, the rest is spilled to temporary file.
+class IterMaterialize : public IterBase
+{
+public:
+    explicit IterMaterialize(Iter&& parent) : IterBase{parent->type}, parent_{std::move(parent)}
+    {
+    }
+    ~IterMaterialize() override = default;
+
+    void                 Open() override;
+    void                 Restart() override;
+    void                 Close() override;
+    std::optional<Value> Next() override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
+
+private:
+    void Store(const Value& value);
+    void Complete();
+
+    Iter parent_;
+    bool complete_ = false; // all rows of parent are stored
+
+    std::vector<Value> rows_;
+    std::size_t        rows_size_ = 0;
+    std::size_t        row_index_ = 0;
+
+    std::optional<os::TempFile> file_;
+    std::optional<temp::Output> output_;
+    page::Id                    page_count_;
+    temp::Input                 input_;
+};
+
+// Block nested loop: left rows are read in blocks, right input is read once per block.
+// Right input is materialized, so it is evaluated only once.
 class IterJoinCross : public IterBase
 {
 public:
     IterJoinCross(Iter&& iter_l, Iter&& iter_r, Type&& type)
-        : IterBase{std::move(type)}, iter_l_{std::move(iter_l)}, iter_r_{std::move(iter_r)}
+        : IterBase{std::move(type)}, iter_l_{std::move(iter_l)},
+          iter_r_{std::make_unique<IterMaterialize>(std::move(iter_r))}
     {
     }
     ~IterJoinCross() override = default;
@@ -139,10 +261,22 @@ public:
     void                 Restart() override;
     void                 Close() override;
     std::optional<Value> Next() override;
+    void                 SetLimit(std::size_t count) override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
 
 private:
-    Iter                 iter_l_, iter_r_;
-    std::optional<Value> value_l_;
+    bool NextBlock();
+
+    Iter iter_l_, iter_r_;
+
+    // first right row is joined with block of left rows, more of them are not needed
+    std::optional<std::size_t> limit_;
+
+    std::vector<Value>   block_l_;
+    std::size_t          block_index_ = 0;
+    bool                 done_l_      = false;
+    std::optional<Value> value_r_;
 };
 
 class IterJoinQualified : public IterBase
@@ -161,6 +295,8 @@ public:
     void                 Restart() override;
     void                 Close() override;
     std::optional<Value> Next() override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
 
 private:
     Iter          parent_;
@@ -180,6 +316,8 @@ public:
     void                 Restart() override;
     void                 Close() override;
     std::optional<Value> Next() override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
 
 private:
     Iter          parent_;
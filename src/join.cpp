@@ -0,0 +1,783 @@
+#include "join.hpp"
+#include "buffer.hpp"
+#include "catalog.hpp"
+#include "common.hpp"
+#include "expr.hpp"
+#include "index.hpp"
+#include "iter.hpp"
+#include "os.hpp"
+#include "page.hpp"
+#include "row.hpp"
+#include "row_id.hpp"
+#include "sort.hpp"
+#include "statistics.hpp"
+#include "temp.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+static Value EvalKeys(const std::vector<ExprPtr>& exprs, const Value& value)
+{
+    Value key;
+    key.reserve(exprs.size());
+    for (const ExprPtr& expr : exprs)
+    {
+        key.push_back(expr->Eval(&value));
+    }
+    return key;
+}
+
+// NULL is never equal to anything
+static bool IsKeyNull(const ColumnValue& value)
+{
+    if (value.index() == 0)
+    {
+        return true;
+    }
+    const auto* boolean = std::get_if<ColumnValueBoolean>(&value);
+    return boolean && *boolean == Bool::kUnknown;
+}
+
+static bool IsKeyNull(const Value& key)
+{
+    return std::ranges::any_of(key, [](const ColumnValue& value) { return IsKeyNull(value); });
+}
+
+IterJoinHash::IterJoinHash(Iter&& iter_l, Iter&& iter_r, JoinKeys&& keys, ExprPtr&& residual,
+                           bool build_left, Type&& type)
+    : IterBase{std::move(type)}, iter_build_{build_left ? std::move(iter_l) : std::move(iter_r)},
+      iter_probe_{build_left ? std::move(iter_r) : std::move(iter_l)},
+      keys_build_{build_left ? std::move(keys.exprs_l) : std::move(keys.exprs_r)},
+      keys_probe_{build_left ? std::move(keys.exprs_r) : std::move(keys.exprs_l)},
+      residual_{std::move(residual)}, build_left_{build_left}
+{
+    ASSERT(!keys_build_.empty() && keys_build_.size() == keys_probe_.size());
+}
+
+void IterJoinHash::Open()
+{
+    iter_build_->Open();
+    iter_probe_->Open();
+    Start();
+}
+
+void IterJoinHash::Restart()
+{
+    if (!spilled_)
+    {
+        // hash table is kept, only probe input is read again
+        iter_probe_->Restart();
+        probe_.Init(iter_probe_.get());
+        probe_value_ = std::nullopt;
+        matches_     = nullptr;
+        return;
+    }
+    iter_build_->Restart();
+    iter_probe_->Restart();
+    Start();
+}
+
+void IterJoinHash::Close()
+{
+    iter_build_->Close();
+    iter_probe_->Close();
+    table_.clear();
+    passes_.clear();
+    pass_.reset();
+    matches_ = nullptr;
+}
+
+std::optional<Value> IterJoinHash::Next()
+{
+    for (;;)
+    {
+        if (matches_ && match_index_ < matches_->size())
+        {
+            const Value& value_build = (*matches_)[match_index_++];
+            const Value& value_l     = build_left_ ? value_build : *probe_value_;
+            const Value& value_r     = build_left_ ? *probe_value_ : value_build;
+            Value        value;
+            value.reserve(value_l.size() + value_r.size());
+            value.insert(value.end(), value_l.begin(), value_l.end());
+            value.insert(value.end(), value_r.begin(), value_r.end());
+            if (residual_ &&
+                std::get<ColumnValueBoolean>(residual_->Eval(&value)) != Bool::kTrue)
+            {
+                continue;
+            }
+            return value;
+        }
+        matches_     = nullptr;
+        probe_value_ = probe_.Next();
+        if (!probe_value_)
+        {
+            if (!NextPass())
+            {
+                return std::nullopt;
+            }
+            continue;
+        }
+        const Value key = EvalKeys(keys_probe_, *probe_value_);
+        if (IsKeyNull(key))
+        {
+            continue;
+        }
+        const auto iter = table_.find(key);
+        if (iter != table_.end())
+        {
+            matches_     = &iter->second;
+            match_index_ = 0;
+        }
+    }
+}
+
+std::string IterJoinHash::GetName() const
+{
+    return build_left_ ? "Hash Join (build left)" : "Hash Join (build right)";
+}
+
+std::vector<Iter*> IterJoinHash::GetInputs()
+{
+    if (build_left_)
+    {
+        return {&iter_build_, &iter_probe_};
+    }
+    return {&iter_probe_, &iter_build_};
+}
+
+void IterJoinHash::Start()
+{
+    passes_.clear();
+    pass_.reset();
+    spilled_     = false;
+    probe_value_ = std::nullopt;
+    matches_     = nullptr;
+
+    build_.Init(iter_build_.get());
+    probe_.Init(iter_probe_.get());
+    if (!Build(build_, probe_, 0))
+    {
+        NextPass();
+    }
+}
+
+bool IterJoinHash::NextPass()
+{
+    if (!spilled_)
+    {
+        // table is kept for Restart, which reads only probe input again
+        return false;
+    }
+    table_.clear();
+    table_size_ = 0;
+    while (!passes_.empty())
+    {
+        pass_.reset();
+        pass_.emplace(std::move(passes_.back()));
+        passes_.pop_back();
+        build_.Init(pass_->build, iter_build_->type);
+        probe_.Init(pass_->probe, iter_probe_->type);
+        if (Build(build_, probe_, pass_->level))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// returns false if input was spilled to partitions instead
+bool IterJoinHash::Build(Reader& build, Reader& probe, unsigned int level)
+{
+    table_.clear();
+    table_size_ = 0;
+    for (;;)
+    {
+        std::optional<Value> value = build.Next();
+        if (!value)
+        {
+            return true;
+        }
+        Value key = EvalKeys(keys_build_, *value);
+        if (IsKeyNull(key))
+        {
+            continue;
+        }
+        table_size_ += ValueMemorySize(key) + ValueMemorySize(*value);
+        table_[std::move(key)].push_back(std::move(*value));
+        if (table_size_ > temp::kWorkMemory && level < temp::kPartitionLevelMax)
+        {
+            Spill(build, probe, level);
+            return false;
+        }
+    }
+}
+
+void IterJoinHash::Spill(Reader& build, Reader& probe, unsigned int level)
+{
+    spilled_ = true;
+
+    std::vector<Partition> partitions_build(temp::kPartitionCount);
+    std::vector<Partition> partitions_probe(temp::kPartitionCount);
+
+    const auto write_partitions =
+        [level](std::vector<Partition>& partitions, const Type& type,
+                const std::vector<ExprPtr>& keys, Reader& reader, Table* table)
+    {
+        const page::Offset        align = type.GetAlign();
+        std::vector<temp::Output> outputs;
+        outputs.reserve(temp::kPartitionCount);
+        for (Partition& partition : partitions)
+        {
+            outputs.emplace_back(partition.file);
+        }
+        if (table)
+        {
+            for (const auto& [key, values] : *table)
+            {
+                temp::Output& output = outputs[temp::GetPartition(key, level)];
+                for (const Value& value : values)
+                {
+                    output.Append(value, align);
+                }
+            }
+            table->clear();
+        }
+        for (;;)
+        {
+            const std::optional<Value> value = reader.Next();
+            if (!value)
+            {
+                break;
+            }
+            const Value key = EvalKeys(keys, *value);
+            if (IsKeyNull(key))
+            {
+                continue;
+            }
+            outputs[temp::GetPartition(key, level)].Append(*value, align);
+        }
+        for (unsigned int i = 0; i < temp::kPartitionCount; i++)
+        {
+            partitions[i].page_count = outputs[i].EndSection().second;
+        }
+    };
+    write_partitions(partitions_build, iter_build_->type, keys_build_, build, &table_);
+    write_partitions(partitions_probe, iter_probe_->type, keys_probe_, probe, nullptr);
+    table_size_ = 0;
+
+    for (unsigned int i = 0; i < temp::kPartitionCount; i++)
+    {
+        if (partitions_build[i].page_count > 0 && partitions_probe[i].page_count > 0)
+        {
+            passes_.push_back({.build = std::move(partitions_build[i]),
+                               .probe = std::move(partitions_probe[i]),
+                               .level = level + 1});
+        }
+    }
+}
+
+void IterJoinHash::Reader::Init(IterBase* iter)
+{
+    iter_ = iter;
+    type_ = nullptr;
+}
+
+void IterJoinHash::Reader::Init(const Partition& partition, const Type& type)
+{
+    iter_ = nullptr;
+    type_ = &type;
+    input_.Init(partition.file, page::Id{}, partition.page_count);
+}
+
+std::optional<Value> IterJoinHash::Reader::Next()
+{
+    if (iter_)
+    {
+        return iter_->Next();
+    }
+    page::Offset    size = 0;
+    const U8* const row  = input_.Next(size);
+    if (row == nullptr)
+    {
+        return std::nullopt;
+    }
+    return row::Read(*type_, row);
+}
+
+// both values have the same type, and they are not NULL
+static int CompareKeyColumns(const ColumnValue& value_l, const ColumnValue& value_r)
+{
+    return std::visit(
+        Overload{
+            [](const ColumnValueNull&) -> int { UNREACHABLE(); },
+            [](const ColumnValueBoolean&) -> int { UNREACHABLE(); },
+            [&value_r](const ColumnValueVarchar& value)
+            { return CompareStrings(value, std::get<ColumnValueVarchar>(value_r)); },
+            [&value_r]<typename T>(const T& value)
+            {
+                const T& other = std::get<T>(value_r);
+                if (value < other)
+                {
+                    return -1;
+                }
+                if (value > other)
+                {
+                    return +1;
+                }
+                return 0;
+            },
+        },
+        value_l);
+}
+
+// columns of keys shifted by offset, or none if some key is not a column
+static std::vector<ColumnId> GetKeyColumns(const std::vector<ExprPtr>& keys, ColumnId offset)
+{
+    std::vector<ColumnId> columns;
+    for (const ExprPtr& key : keys)
+    {
+        const auto* const column = std::get_if<Expr::DataColumn>(&key->data);
+        if (column == nullptr)
+        {
+            return {};
+        }
+        columns.push_back(column->column_id + offset);
+    }
+    return columns;
+}
+
+IterJoinMerge::IterJoinMerge(Iter&& iter_l, Iter&& iter_r, JoinKeys&& keys, ExprPtr&& residual,
+                             Type&& type)
+    : IterBase{std::move(type)}, column_count_l_{iter_l->type.Size()},
+      column_count_r_{iter_r->type.Size()}, key_count_{keys.exprs_l.size()},
+      iter_l_{std::move(iter_l)}, iter_r_{std::move(iter_r)}, residual_{std::move(residual)}
+{
+    ASSERT(key_count_ > 0);
+    // keys of both inputs are equal in output
+    for (std::vector<ColumnId> columns :
+         {GetKeyColumns(keys.exprs_l, ColumnId{}),
+          GetKeyColumns(keys.exprs_r, ColumnId{static_cast<ColumnId::Type>(column_count_l_)})})
+    {
+        if (!columns.empty())
+        {
+            sorted_by.push_back(std::move(columns));
+        }
+    }
+    iter_l_ = CreateSortedIter(std::move(iter_l_), std::move(keys.exprs_l));
+    iter_r_ = CreateSortedIter(std::move(iter_r_), std::move(keys.exprs_r));
+}
+
+bool IterJoinMerge::IsPreferred(const JoinKeys& keys, const IterBase& iter_l,
+                                const IterBase& iter_r, U64 page_count_l, U64 page_count_r)
+{
+    // sorting is not defined for booleans
+    const auto is_sortable = [](const ExprPtr& expr)
+    { return expr->type && *expr->type != ColumnType::kBoolean; };
+    if (!std::ranges::all_of(keys.exprs_l, is_sortable) ||
+        !std::ranges::all_of(keys.exprs_r, is_sortable))
+    {
+        return false;
+    }
+    if (IsSortedBy(iter_l, keys.exprs_l) && IsSortedBy(iter_r, keys.exprs_r))
+    {
+        return true; // inputs are merged without sorting
+    }
+    const U64 page_count_min = std::min(page_count_l, page_count_r);
+    return page_count_min * page::kSize > temp::kWorkMemory * temp::kPartitionCount;
+}
+
+void IterJoinMerge::Open()
+{
+    iter_l_->Open();
+    iter_r_->Open();
+    Start();
+}
+
+void IterJoinMerge::Restart()
+{
+    iter_l_->Restart();
+    iter_r_->Restart();
+    Start();
+}
+
+void IterJoinMerge::Close()
+{
+    iter_l_->Close();
+    iter_r_->Close();
+    ClearGroup();
+}
+
+std::optional<Value> IterJoinMerge::Next()
+{
+    for (;;)
+    {
+        if (!group_r_.empty())
+        {
+            if (const Value* const value_r = NextInGroup())
+            {
+                Value value;
+                value.reserve(column_count_l_ + column_count_r_);
+                value.insert(value.end(), value_l_->begin(),
+                             value_l_->begin() + static_cast<std::ptrdiff_t>(column_count_l_));
+                value.insert(value.end(), value_r->begin(),
+                             value_r->begin() + static_cast<std::ptrdiff_t>(column_count_r_));
+                if (residual_ &&
+                    std::get<ColumnValueBoolean>(residual_->Eval(&value)) != Bool::kTrue)
+                {
+                    continue;
+                }
+                return value;
+            }
+            // next left row may have the same key, then the group is joined again
+            value_l_ = NextValue(*iter_l_, column_count_l_);
+            if (value_l_ && CompareKeys(*value_l_, group_r_.front()) == 0)
+            {
+                RestartGroup();
+                continue;
+            }
+            ClearGroup();
+        }
+        if (!value_l_ || !value_r_)
+        {
+            return std::nullopt;
+        }
+        const int result = CompareKeys(*value_l_, *value_r_);
+        if (result < 0)
+        {
+            value_l_ = NextValue(*iter_l_, column_count_l_);
+            continue;
+        }
+        if (result > 0)
+        {
+            value_r_ = NextValue(*iter_r_, column_count_r_);
+            continue;
+        }
+        do
+        {
+            AddToGroup(std::move(*value_r_));
+            value_r_ = NextValue(*iter_r_, column_count_r_);
+        } while (value_r_ && CompareKeys(*value_l_, *value_r_) == 0);
+        RestartGroup();
+    }
+}
+
+std::string IterJoinMerge::GetName() const
+{
+    return "Merge Join";
+}
+
+std::vector<Iter*> IterJoinMerge::GetInputs()
+{
+    return {&iter_l_, &iter_r_};
+}
+
+// rows of iter are ascending by keys, if they are its first sorted columns
+bool IterJoinMerge::IsSortedBy(const IterBase& iter, const std::vector<ExprPtr>& keys)
+{
+    const std::vector<ColumnId> columns = GetKeyColumns(keys, ColumnId{});
+    if (columns.empty())
+    {
+        return false;
+    }
+    return std::ranges::any_of(iter.sorted_by,
+                               [&columns](const std::vector<ColumnId>& sorted_by)
+                               {
+                                   return columns.size() <= sorted_by.size() &&
+                                          std::equal(columns.begin(), columns.end(),
+                                                     sorted_by.begin());
+                               });
+}
+
+Iter IterJoinMerge::CreateSortedIter(Iter&& iter, std::vector<ExprPtr>&& keys)
+{
+    const bool           sorted = IsSortedBy(*iter, keys);
+    Type                 type   = iter->type;
+    std::vector<ExprPtr> exprs;
+    for (ColumnId column_id{}; column_id < type.Size(); column_id++)
+    {
+        exprs.push_back(std::make_unique<Expr>(Expr::DataColumn{column_id},
+                                               type.At(column_id.Get())));
+    }
+    OrderBy order_by;
+    for (ExprPtr& key : keys)
+    {
+        ASSERT(key->type);
+        order_by.columns.push_back(
+            {.column_id = ColumnId{static_cast<ColumnId::Type>(exprs.size())}, .asc = true});
+        type.Push(*key->type);
+        exprs.push_back(std::move(key));
+    }
+    iter = std::make_unique<IterExpr>(std::move(iter), std::move(exprs), std::move(type));
+    if (sorted)
+    {
+        return iter;
+    }
+    return std::make_unique<IterSort>(std::move(iter), std::move(order_by));
+}
+
+void IterJoinMerge::Start()
+{
+    ClearGroup();
+    value_l_ = NextValue(*iter_l_, column_count_l_);
+    value_r_ = NextValue(*iter_r_, column_count_r_);
+}
+
+void IterJoinMerge::AddToGroup(Value&& value)
+{
+    if (!group_file_)
+    {
+        group_size_ += ValueMemorySize(value);
+        if (group_r_.empty() || group_size_ <= temp::kWorkMemory)
+        {
+            group_r_.push_back(std::move(value));
+            return;
+        }
+        group_file_.emplace();
+        group_output_.emplace(*group_file_);
+    }
+    group_output_->Append(value, iter_r_->type.GetAlign());
+}
+
+void IterJoinMerge::RestartGroup()
+{
+    group_index_ = 0;
+    if (group_output_)
+    {
+        group_page_count_ = group_output_->EndSection().second;
+        group_output_.reset();
+    }
+    if (group_file_)
+    {
+        group_input_.Init(*group_file_, page::Id{}, group_page_count_);
+    }
+}
+
+void IterJoinMerge::ClearGroup()
+{
+    group_r_.clear();
+    group_size_  = 0;
+    group_index_ = 0;
+    group_output_.reset(); // before its file
+    group_file_.reset();
+}
+
+const Value* IterJoinMerge::NextInGroup()
+{
+    if (group_index_ < group_r_.size())
+    {
+        return &group_r_[group_index_++];
+    }
+    if (group_file_)
+    {
+        page::Offset    size = 0;
+        const U8* const row  = group_input_.Next(size);
+        if (row != nullptr)
+        {
+            group_value_ = row::Read(iter_r_->type, row);
+            return &group_value_;
+        }
+    }
+    return nullptr;
+}
+
+// skips rows with NULL keys, they would not match anyway
+std::optional<Value> IterJoinMerge::NextValue(IterBase& iter, std::size_t column_count) const
+{
+    for (;;)
+    {
+        std::optional<Value> value = iter.Next();
+        if (!value)
+        {
+            return std::nullopt;
+        }
+        const bool is_null =
+            std::any_of(value->begin() + static_cast<std::ptrdiff_t>(column_count), value->end(),
+                        [](const ColumnValue& column_value) { return IsKeyNull(column_value); });
+        if (!is_null)
+        {
+            return value;
+        }
+    }
+}
+
+int IterJoinMerge::CompareKeys(const Value& value_l, const Value& value_r) const
+{
+    for (std::size_t i = 0; i < key_count_; i++)
+    {
+        const int result =
+            CompareKeyColumns(value_l[column_count_l_ + i], value_r[column_count_r_ + i]);
+        if (result != 0)
+        {
+            return result;
+        }
+    }
+    return 0;
+}
+
+IterJoinIndex::IterJoinIndex(Iter&& iter_outer, catalog::FileId file_inner, Type&& type_inner,
+                             std::vector<ColumnId>&& columns_inner, catalog::FileId file_index,
+                             JoinKeys&& keys, std::size_t key_index, ExprPtr&& residual,
+                             bool outer_left, Type&& type)
+    : IterBase{std::move(type)}, iter_outer_{std::move(iter_outer)}, file_inner_{file_inner},
+      file_index_{file_index}, type_inner_{std::move(type_inner)},
+      columns_inner_{std::move(columns_inner)},
+      keys_outer_{outer_left ? std::move(keys.exprs_l) : std::move(keys.exprs_r)},
+      keys_inner_{outer_left ? std::move(keys.exprs_r) : std::move(keys.exprs_l)},
+      key_index_{key_index}, residual_{std::move(residual)}, outer_left_{outer_left}
+{
+    ASSERT(key_index_ < keys_outer_.size() && keys_outer_.size() == keys_inner_.size());
+    const auto* column = std::get_if<Expr::DataColumn>(&keys_inner_[key_index_]->data);
+    ASSERT(column);
+    key_type_.Push(type_inner_.At(column->column_id.Get()));
+}
+
+double IterJoinIndex::EstimateLookupPageCount(
+    const std::optional<statistics::Table>& statistics_inner, ColumnId column_inner)
+{
+    // upper levels of index stay in buffer pool, its leaf and a page per matching row are read
+    double rows_per_key = 1; // index is assumed to be on unique column if it is not analyzed
+    if (statistics_inner && statistics_inner->row_count > 0)
+    {
+        const statistics::Column& column   = statistics_inner->columns.at(column_inner.Get());
+        const double              distinct = std::max(column.distinct_count, 1.0);
+        rows_per_key = static_cast<double>(statistics_inner->row_count) *
+                       (1 - column.null_fraction) / distinct;
+    }
+    return 1 + rows_per_key;
+}
+
+bool IterJoinIndex::IsPreferred(double row_count_outer, U64 page_count_inner,
+                                const std::optional<statistics::Table>& statistics_inner,
+                                ColumnId                                 column_inner)
+{
+    return row_count_outer * EstimateLookupPageCount(statistics_inner, column_inner) <
+           static_cast<double>(page_count_inner);
+}
+
+void IterJoinIndex::Open()
+{
+    iter_outer_->Open();
+    outer_done_ = false;
+    ClearBatch();
+}
+
+void IterJoinIndex::Restart()
+{
+    iter_outer_->Restart();
+    outer_done_ = false;
+    ClearBatch();
+}
+
+void IterJoinIndex::Close()
+{
+    iter_outer_->Close();
+    ClearBatch();
+}
+
+std::optional<Value> IterJoinIndex::Next()
+{
+    for (;;)
+    {
+        if (probe_index_ == probes_.size())
+        {
+            if (!NextBatch())
+            {
+                return std::nullopt;
+            }
+            continue;
+        }
+        const Probe& probe             = probes_[probe_index_++];
+        const auto [page_id, entry_id] = UnpackRowId(probe.row_id);
+        if (page_.GetPage() == nullptr || page_.GetPageId() != page_id)
+        {
+            page_ = buffer::Pin<const page::Slotted<>>{file_inner_, page_id};
+        }
+        const U8* const entry = page_->GetEntry(entry_id);
+        if (entry == nullptr)
+        {
+            continue; // deleted row, index entries are not removed
+        }
+        const Value  value_inner = row::Read(type_inner_, columns_inner_, entry);
+        const Value& value_outer = batch_[probe.outer_index];
+        if (!ValueEqual(EvalKeys(keys_inner_, value_inner), batch_keys_[probe.outer_index]))
+        {
+            continue;
+        }
+        const Value& value_l = outer_left_ ? value_outer : value_inner;
+        const Value& value_r = outer_left_ ? value_inner : value_outer;
+        Value        value;
+        value.reserve(value_l.size() + value_r.size());
+        value.insert(value.end(), value_l.begin(), value_l.end());
+        value.insert(value.end(), value_r.begin(), value_r.end());
+        if (residual_ && std::get<ColumnValueBoolean>(residual_->Eval(&value)) != Bool::kTrue)
+        {
+            continue;
+        }
+        return value;
+    }
+}
+
+std::string IterJoinIndex::GetName() const
+{
+    return "Index Join " + catalog::GetFileName(file_inner_) + " using " +
+           catalog::GetFileName(file_index_);
+}
+
+std::vector<Iter*> IterJoinIndex::GetInputs()
+{
+    return {&iter_outer_};
+}
+
+void IterJoinIndex::ClearBatch()
+{
+    page_ = buffer::Pin<const page::Slotted<>>{};
+    batch_.clear();
+    batch_keys_.clear();
+    probes_.clear();
+    probe_index_ = 0;
+}
+
+// returns false if there are no more outer rows with matches
+bool IterJoinIndex::NextBatch()
+{
+    ClearBatch();
+    std::vector<ColumnValueInteger> row_ids;
+    std::size_t                     batch_size = 0;
+    while (!outer_done_ && batch_size < temp::kWorkMemory)
+    {
+        std::optional<Value> value = iter_outer_->Next();
+        if (!value)
+        {
+            outer_done_ = true;
+            break;
+        }
+        Value key = EvalKeys(keys_outer_, *value);
+        if (IsKeyNull(key))
+        {
+            continue;
+        }
+        row_ids.clear();
+        btree::Find(file_index_, key_type_, {key[key_index_]}, row_ids);
+        if (row_ids.empty())
+        {
+            continue;
+        }
+        for (const ColumnValueInteger row_id : row_ids)
+        {
+            probes_.push_back({.row_id = row_id, .outer_index = batch_.size()});
+        }
+        batch_size += ValueMemorySize(*value) + ValueMemorySize(key) +
+                      (row_ids.size() * sizeof(Probe));
+        batch_.push_back(std::move(*value));
+        batch_keys_.push_back(std::move(key));
+    }
+    // row ids are ordered by page
+    std::ranges::sort(probes_, {}, &Probe::row_id);
+    return !probes_.empty();
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "catalog.hpp"
+#include "common.hpp"
+#include "expr.hpp"
+#include "iter.hpp"
+#include "os.hpp"
+#include "page.hpp"
+#include "sort.hpp"
+#include "statistics.hpp"
+#include "temp.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// equi-join keys, expressions are evaluated on rows of their own input
+struct JoinKeys
+{
+    std::vector<ExprPtr> exprs_l, exprs_r;
+};
+
+// Rows of the build input are stored in hash table by key, rows of the probe input are looked up.
+// If the build input does not fit in work memory, both inputs are partitioned by key hash to
+// temporary files and pairs of partitions are joined one by one (grace hash join).
+class IterJoinHash : public IterBase
+{
+public:
+    IterJoinHash(Iter&& iter_l, Iter&& iter_r, JoinKeys&& keys, ExprPtr&& residual,
+                 bool build_left, Type&& type);
+    ~IterJoinHash() override = default;
+
+    void                 Open() override;
+    void                 Restart() override;
+    void                 Close() override;
+    std::optional<Value> Next() override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
+
+private:
+    using Table = std::unordered_map<Value, std::vector<Value>, ValueHasher, ValueEqualTo>;
+
+    struct Partition
+    {
+        os::TempFile file;
+        page::Id     page_count;
+    };
+
+    struct Pass
+    {
+        Partition    build, probe;
+        unsigned int level;
+    };
+
+    // reads rows either from input iterator or from partition
+    class Reader
+    {
+    public:
+        void                 Init(IterBase* iter);
+        void                 Init(const Partition& partition, const Type& type);
+        std::optional<Value> Next();
+
+    private:
+        IterBase*   iter_ = nullptr;
+        const Type* type_ = nullptr;
+        temp::Input input_;
+    };
+
+    void Start();
+    bool NextPass();
+    bool Build(Reader& build, Reader& probe, unsigned int level);
+    void Spill(Reader& build, Reader& probe, unsigned int level);
+
+    Iter                       iter_build_, iter_probe_;
+    const std::vector<ExprPtr> keys_build_, keys_probe_;
+    const ExprPtr              residual_;
+    const bool                 build_left_;
+
+    Table       table_;
+    std::size_t table_size_ = 0;
+    bool        spilled_    = false;
+
+    std::vector<Pass>   passes_;
+    std::optional<Pass> pass_;
+    Reader              build_, probe_;
+
+    std::optional<Value>      probe_value_;
+    const std::vector<Value>* matches_     = nullptr;
+    std::size_t               match_index_ = 0;
+};
+
+// Both inputs are sorted by key (key expressions are appended as hidden columns first), unless
+// they are already sorted by it, then they are merged. Rows of the right input with equal key are
+// buffered up to work memory and the rest is spilled, so that they can be joined with all rows of
+// the left input with the same key. Output is sorted by key columns of both inputs.
+class IterJoinMerge : public IterBase
+{
+public:
+    IterJoinMerge(Iter&& iter_l, Iter&& iter_r, JoinKeys&& keys, ExprPtr&& residual, Type&& type);
+    ~IterJoinMerge() override = default;
+
+    void                 Open() override;
+    void                 Restart() override;
+    void                 Close() override;
+    std::optional<Value> Next() override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
+
+    // used if both inputs are already sorted by key, or if hash join would have to partition
+    // inputs more than once
+    [[nodiscard]] static bool IsPreferred(const JoinKeys& keys, const IterBase& iter_l,
+                                          const IterBase& iter_r, U64 page_count_l,
+                                          U64 page_count_r);
+
+private:
+    static bool IsSortedBy(const IterBase& iter, const std::vector<ExprPtr>& keys);
+    static Iter CreateSortedIter(Iter&& iter, std::vector<ExprPtr>&& keys);
+
+    void                 Start();
+    std::optional<Value> NextValue(IterBase& iter, std::size_t column_count) const;
+    int                  CompareKeys(const Value& value_l, const Value& value_r) const;
+
+    void         AddToGroup(Value&& value);
+    void         RestartGroup(); // also completes spilled rows of group
+    void         ClearGroup();
+    const Value* NextInGroup();
+
+    const std::size_t column_count_l_, column_count_r_;
+    const std::size_t key_count_;
+
+    Iter          iter_l_, iter_r_;
+    const ExprPtr residual_;
+
+    std::optional<Value> value_l_, value_r_;
+
+    // rows of right input with the key of current left row, the first one is always in memory
+    std::vector<Value>          group_r_;
+    std::size_t                 group_size_  = 0;
+    std::size_t                 group_index_ = 0;
+    std::optional<os::TempFile> group_file_;
+    std::optional<temp::Output> group_output_;
+    page::Id                    group_page_count_;
+    temp::Input                 group_input_;
+    Value                       group_value_; // last row read from file
+};
+
+// For each row of the outer input, rows of the inner table are looked up in index on one of the
+// key columns. Outer rows are read in batches and the found row ids are sorted, so that each page
+// of the inner table is read only once per batch.
+class IterJoinIndex : public IterBase
+{
+public:
+    IterJoinIndex(Iter&& iter_outer, catalog::FileId file_inner, Type&& type_inner,
+                  std::vector<ColumnId>&& columns_inner, catalog::FileId file_index,
+                  JoinKeys&& keys, std::size_t key_index, ExprPtr&& residual, bool outer_left,
+                  Type&& type);
+    ~IterJoinIndex() override = default;
+
+    void                 Open() override;
+    void                 Restart() override;
+    void                 Close() override;
+    std::optional<Value> Next() override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
+
+    // pages read by lookup of one key, rows per key are taken from statistics of inner table
+    // if it is analyzed
+    [[nodiscard]] static double
+    EstimateLookupPageCount(const std::optional<statistics::Table>& statistics_inner,
+                            ColumnId                                 column_inner);
+
+    // used if index lookups are cheaper than reading the whole inner table
+    [[nodiscard]] static bool IsPreferred(double row_count_outer, U64 page_count_inner,
+                                          const std::optional<statistics::Table>& statistics_inner,
+                                          ColumnId                                 column_inner);
+
+private:
+    struct Probe
+    {
+        ColumnValueInteger row_id;
+        std::size_t        outer_index;
+    };
+
+    void ClearBatch();
+    bool NextBatch();
+
+    Iter                       iter_outer_;
+    const catalog::FileId      file_inner_, file_index_;
+    const Type                  type_inner_;    // of columns read
+    const std::vector<ColumnId> columns_inner_; // of table which are read, all if empty
+    Type                        key_type_;
+    const std::vector<ExprPtr> keys_outer_, keys_inner_;
+    const std::size_t          key_index_;
+    const ExprPtr              residual_;
+    const bool                 outer_left_;
+
+    std::vector<Value> batch_, batch_keys_; // outer rows and their keys
+    std::vector<Probe> probes_;
+    std::size_t        probe_index_ = 0;
+    bool               outer_done_  = false;
+
+    buffer::Pin<const page::Slotted<>> page_;
+};
@@ -169,6 +169,10 @@ Token Lexer::NextToken()
         {
             return {Token::kKeywordTable, SourceText{std::move(identifier), text_begin, ptr_}};
         }
+        if (identifier == "INDEX")
+        {
+            return {Token::kKeywordIndex, SourceText{std::move(identifier), text_begin, ptr_}};
+        }
         if (identifier == "DEFAULT")
         {
             return {Token::kKeywordDefault, SourceText{std::move(identifier), text_begin, ptr_}};
@@ -338,6 +342,31 @@ Token Lexer::NextToken()
         {
             return {Token::kKeywordSet, SourceText{std::move(identifier), text_begin, ptr_}};
         }
+        if (identifier == "ANALYZE")
+        {
+            return {Token::kKeywordAnalyze, SourceText{std::move(identifier), text_begin, ptr_}};
+        }
+        if (identifier == "EXPLAIN")
+        {
+            return {Token::kKeywordExplain, SourceText{std::move(identifier), text_begin, ptr_}};
+        }
+        if (identifier == "PREPARE")
+        {
+            return {Token::kKeywordPrepare, SourceText{std::move(identifier), text_begin, ptr_}};
+        }
+        if (identifier == "EXECUTE")
+        {
+            return {Token::kKeywordExecute, SourceText{std::move(identifier), text_begin, ptr_}};
+        }
+        if (identifier == "DEALLOCATE")
+        {
+            return {Token::kKeywordDeallocate,
+                    SourceText{std::move(identifier), text_begin, ptr_}};
+        }
+        if (identifier == "COPY")
+        {
+            return {Token::kKeywordCopy, SourceText{std::move(identifier), text_begin, ptr_}};
+        }
         if (identifier == "TRUE")
         {
             return {Token::kConstant, Token::DataConstant{Bool::kTrue},
@@ -405,6 +434,21 @@ Token Lexer::NextToken()
         }
         return {Token::kIdentifier, SourceText{std::move(identifier), text_begin, ptr_}};
     }
+    if (*ptr_ == '$')
+    {
+        static constexpr unsigned int kBase  = 10;
+        static constexpr unsigned int kMax   = 1000;
+        unsigned int                  number = 0;
+        while (IsDigit(*++ptr_))
+        {
+            number = std::min(number * kBase + (*ptr_ - '0'), kMax + 1);
+        }
+        if (number == 0 || number > kMax)
+        {
+            throw ClientError{"invalid parameter", SourceText{text_begin, ptr_}};
+        }
+        return {Token::kParameter, Token::DataParameter{number - 1}, SourceText{text_begin, ptr_}};
+    }
     if (IsDigit(*ptr_))
     {
         static constexpr U64 kBase = 10;
@@ -0,0 +1,601 @@
+#include "load.hpp"
+#include "buffer.hpp"
+#include "catalog.hpp"
+#include "common.hpp"
+#include "error.hpp"
+#include "fst.hpp"
+#include "index.hpp"
+#include "os.hpp"
+#include "page.hpp"
+#include "row.hpp"
+#include "row_id.hpp"
+#include "temp.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace load
+{
+constexpr std::size_t  kChunkSize      = std::size_t{1} << 20; // read from file at once
+constexpr unsigned int kBatchPageCount = 256;                  // written to data file at once
+
+// part of file in memory, which grows if a row does not fit in it
+class Input
+{
+public:
+    explicit Input(const std::string& file_name)
+        : stream_{file_name, std::ios::binary}, data_(kChunkSize)
+    {
+        if (!stream_)
+        {
+            throw ClientError{"failed to open file: " + file_name};
+        }
+    }
+
+    [[nodiscard]] const char* Begin() const
+    {
+        return data_.data() + begin_;
+    }
+    [[nodiscard]] const char* End() const
+    {
+        return data_.data() + end_;
+    }
+    [[nodiscard]] bool IsEof() const
+    {
+        return eof_;
+    }
+
+    void Consume(const char* ptr)
+    {
+        ASSERT(Begin() <= ptr && ptr <= End());
+        begin_ = static_cast<std::size_t>(ptr - data_.data());
+    }
+
+    // keeps data not consumed, pointers to it are invalidated
+    void Fill()
+    {
+        ASSERT(!eof_);
+        std::memmove(data_.data(), Begin(), end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+        if (end_ == data_.size())
+        {
+            data_.resize(data_.size() * 2);
+        }
+        stream_.read(data_.data() + end_, static_cast<std::streamsize>(data_.size() - end_));
+        if (stream_.bad())
+        {
+            throw ClientError{"failed to read file"};
+        }
+        const auto count = static_cast<std::size_t>(stream_.gcount());
+        end_ += count;
+        eof_ = count == 0;
+    }
+
+private:
+    std::ifstream     stream_;
+    std::vector<char> data_;
+    std::size_t       begin_{};
+    std::size_t       end_{};
+    bool              eof_ = false;
+};
+
+[[nodiscard]] static std::string RowText(unsigned long row)
+{
+    return " in row " + std::to_string(row);
+}
+
+// Lines without quotes are split by memchr, which compares many characters at once. Lines with
+// quotes are parsed by characters, quoted fields may contain commas, newlines and "" for quote.
+class CsvReader
+{
+public:
+    CsvReader(const std::string& file_name, const Type& type)
+        : input_{file_name}, type_{type}, unquoted_(type.Size())
+    {
+        fields_.reserve(type.Size());
+    }
+
+    [[nodiscard]] bool Next(Value& value)
+    {
+        for (;;)
+        {
+            const char* const begin = input_.Begin();
+            const char* const end   = input_.End();
+            const auto* line_end =
+                static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+            if (line_end == nullptr && !input_.IsEof())
+            {
+                input_.Fill();
+                continue;
+            }
+            if (begin == end)
+            {
+                return false;
+            }
+            if (line_end == nullptr)
+            {
+                line_end = end; // last line
+            }
+
+            const char* record_end = nullptr;
+            if (std::memchr(begin, '"', line_end - begin) == nullptr)
+            {
+                SplitLine(begin, line_end);
+                record_end = line_end;
+            }
+            else
+            {
+                record_end = SplitQuoted(begin, end);
+                if (record_end == nullptr)
+                {
+                    input_.Fill();
+                    continue;
+                }
+            }
+            row_++;
+            MakeValue(value);
+            input_.Consume(record_end == end ? end : record_end + 1);
+            return true;
+        }
+    }
+
+private:
+    struct Field
+    {
+        std::string_view text;
+        bool             quoted;
+    };
+
+    void AddField(std::string_view text, bool quoted)
+    {
+        if (fields_.size() == type_.Size())
+        {
+            throw ClientError{"column number mismatch" + RowText(row_ + 1)};
+        }
+        fields_.push_back({.text = text, .quoted = quoted});
+    }
+
+    void SplitLine(const char* begin, const char* end)
+    {
+        if (begin < end && end[-1] == '\r')
+        {
+            end--;
+        }
+        fields_.clear();
+        for (;;)
+        {
+            const auto* comma = static_cast<const char*>(std::memchr(begin, ',', end - begin));
+            AddField({begin, comma == nullptr ? end : comma}, false);
+            if (comma == nullptr)
+            {
+                break;
+            }
+            begin = comma + 1;
+        }
+    }
+
+    // returns end of record (newline or end of data), or null if more data is needed
+    [[nodiscard]] const char* SplitQuoted(const char* ptr, const char* end)
+    {
+        const bool eof = input_.IsEof();
+        fields_.clear();
+        for (;;)
+        {
+            if (ptr < end && *ptr == '"')
+            {
+                if (fields_.size() == type_.Size())
+                {
+                    throw ClientError{"column number mismatch" + RowText(row_ + 1)};
+                }
+                std::string& text = unquoted_[fields_.size()];
+                text.clear();
+                ptr++;
+                for (;;)
+                {
+                    const auto* quote = static_cast<const char*>(std::memchr(ptr, '"', end - ptr));
+                    if (quote == nullptr || (quote + 1 == end && !eof))
+                    {
+                        if (eof)
+                        {
+                            throw ClientError{"unterminated quoted field" + RowText(row_ + 1)};
+                        }
+                        return nullptr;
+                    }
+                    text.append(ptr, quote);
+                    ptr = quote + 1;
+                    if (ptr == end || *ptr != '"')
+                    {
+                        break;
+                    }
+                    text += '"';
+                    ptr++;
+                }
+                AddField(text, true);
+            }
+            else
+            {
+                const char* field_end = ptr;
+                while (field_end < end && *field_end != ',' && *field_end != '\n')
+                {
+                    field_end++;
+                }
+                if (field_end == end && !eof)
+                {
+                    return nullptr;
+                }
+                const bool cr = field_end < end && *field_end == '\n' && field_end > ptr &&
+                                field_end[-1] == '\r';
+                AddField({ptr, cr ? field_end - 1 : field_end}, false);
+                ptr = field_end;
+            }
+
+            if (ptr == end)
+            {
+                return eof ? end : nullptr;
+            }
+            if (*ptr == ',')
+            {
+                ptr++;
+                continue;
+            }
+            if (*ptr == '\r' && ptr + 1 < end && ptr[1] == '\n')
+            {
+                ptr++;
+            }
+            if (*ptr == '\n')
+            {
+                return ptr;
+            }
+            throw ClientError{"unexpected character after quoted field" + RowText(row_ + 1)};
+        }
+    }
+
+    void MakeValue(Value& value) const
+    {
+        if (fields_.size() != type_.Size())
+        {
+            throw ClientError{"column number mismatch" + RowText(row_)};
+        }
+        value.resize(type_.Size());
+        for (std::size_t i = 0; i < type_.Size(); i++)
+        {
+            const Field& field = fields_[i];
+            if (field.text.empty() && !field.quoted)
+            {
+                value[i] = ColumnValueNull{};
+                continue;
+            }
+            const char* const begin = field.text.data();
+            const char* const end   = begin + field.text.size();
+            switch (type_.At(i))
+            {
+            case ColumnType::kBoolean:
+                break;
+            case ColumnType::kInteger:
+            {
+                ColumnValueInteger integer{};
+                const auto [ptr, error] = std::from_chars(begin, end, integer);
+                if (error != std::errc{} || ptr != end)
+                {
+                    throw ClientError{"invalid INTEGER" + RowText(row_)};
+                }
+                value[i] = integer;
+                continue;
+            }
+            case ColumnType::kReal:
+            {
+                ColumnValueReal real{};
+                const auto [ptr, error] = std::from_chars(begin, end, real);
+                if (error != std::errc{} || ptr != end)
+                {
+                    throw ClientError{"invalid REAL" + RowText(row_)};
+                }
+                value[i] = real;
+                continue;
+            }
+            case ColumnType::kVarchar:
+            {
+                value[i] = ColumnValueVarchar{field.text};
+                continue;
+            }
+            }
+            UNREACHABLE();
+        }
+    }
+
+    Input       input_;
+    const Type& type_;
+
+    std::vector<Field>       fields_;   // of current record
+    std::vector<std::string> unquoted_; // text of quoted fields, for each column
+    unsigned long            row_ = 0;
+};
+
+class BinaryReader
+{
+public:
+    BinaryReader(const std::string& file_name, const Type& type)
+        : input_{file_name}, type_{type}
+    {
+    }
+
+    [[nodiscard]] bool Next(Value& value)
+    {
+        if (input_.Begin() == input_.End())
+        {
+            input_.Fill();
+            if (input_.IsEof())
+            {
+                return false;
+            }
+        }
+        row_++;
+        value.resize(type_.Size());
+        for (std::size_t i = 0; i < type_.Size(); i++)
+        {
+            const auto flag = static_cast<unsigned char>(*Take(1));
+            if (flag == 0)
+            {
+                value[i] = ColumnValueNull{};
+                continue;
+            }
+            if (flag != 1)
+            {
+                throw ClientError{"invalid NULL flag" + RowText(row_)};
+            }
+            switch (type_.At(i))
+            {
+            case ColumnType::kBoolean:
+                break;
+            case ColumnType::kInteger:
+            {
+                ColumnValueInteger integer{};
+                std::memcpy(&integer, Take(sizeof(integer)), sizeof(integer));
+                value[i] = integer;
+                continue;
+            }
+            case ColumnType::kReal:
+            {
+                ColumnValueReal real{};
+                std::memcpy(&real, Take(sizeof(real)), sizeof(real));
+                value[i] = real;
+                continue;
+            }
+            case ColumnType::kVarchar:
+            {
+                U32 size{};
+                std::memcpy(&size, Take(sizeof(size)), sizeof(size));
+                value[i] = ColumnValueVarchar{Take(size), size};
+                continue;
+            }
+            }
+            UNREACHABLE();
+        }
+        return true;
+    }
+
+private:
+    // returned pointer is valid until next call
+    [[nodiscard]] const char* Take(std::size_t size)
+    {
+        while (static_cast<std::size_t>(input_.End() - input_.Begin()) < size)
+        {
+            input_.Fill();
+            if (input_.IsEof())
+            {
+                throw ClientError{"unexpected end of file" + RowText(row_)};
+            }
+        }
+        const char* const ptr = input_.Begin();
+        input_.Consume(ptr + size);
+        return ptr;
+    }
+
+    Input         input_;
+    const Type&   type_;
+    unsigned long row_ = 0;
+};
+
+// Fills pages in memory and writes them past the end of data file. They are added to free space
+// tree in the same order at commit, so their ids are known before they are written, and until
+// then they are not part of table and are overwritten by the next pages appended. Entries of
+// indexes are kept in temporary file until commit as well. Pages of the file are flushed from
+// buffer pool first, so that none of them is cached.
+class PageWriter
+{
+public:
+    PageWriter(catalog::TableId table_id, const Type& type,
+               const std::vector<catalog::Index>& indexes)
+        : type_{type},
+          indexes_{indexes},
+          file_ids_{catalog::GetTableFileIds(table_id)},
+          file_{catalog::GetFileName(file_ids_.dat)},
+          pages_{buffer::FrameId{kBatchPageCount}},
+          page_id_begin_{fst::GetPageCount(file_ids_.fst)},
+          page_id_{page_id_begin_}
+    {
+        buffer::Flush(file_ids_.dat);
+        free_sizes_.reserve(kBatchPageCount);
+        if (!indexes_.empty())
+        {
+            // keys of all indexes followed by row id
+            for (const catalog::Index& index : indexes_)
+            {
+                entry_type_.Push(type_.At(index.column_id.Get()));
+            }
+            entry_type_.Push(ColumnType::kInteger);
+            entries_file_.emplace();
+            entries_output_.emplace(*entries_file_);
+        }
+    }
+
+    void Insert(const Value& value)
+    {
+        for (const catalog::Index& index : indexes_)
+        {
+            if (!btree::IsKeySizeValid({value[index.column_id.Get()]}))
+            {
+                throw ClientError{"index key too long"};
+            }
+        }
+
+        const row::Prefix  prefix = row::CalculateLayout(value);
+        const page::Offset align  = type_.GetAlign();
+        U8*                row    = nullptr;
+        if (!free_sizes_.empty())
+        {
+            row = GetPage(free_sizes_.size() - 1)->Insert(align, prefix.size, {},
+                                                           &free_sizes_.back());
+        }
+        if (row == nullptr)
+        {
+            if (free_sizes_.size() == kBatchPageCount)
+            {
+                Finish();
+            }
+            page::Slotted<>* const page = GetPage(free_sizes_.size());
+            page->Init({});
+            page::Offset free_size{};
+            row = page->Insert(align, prefix.size, {}, &free_size);
+            if (row == nullptr)
+            {
+                throw ClientError{"row too long"};
+            }
+            free_sizes_.push_back(free_size);
+        }
+        row::Write(prefix, value, row);
+
+        if (entries_output_)
+        {
+            const auto page_index = static_cast<unsigned int>(free_sizes_.size() - 1);
+            Value      entry;
+            entry.reserve(indexes_.size() + 1);
+            for (const catalog::Index& index : indexes_)
+            {
+                entry.push_back(value[index.column_id.Get()]);
+            }
+            entry.emplace_back(PackRowId(page::Id{page_id_.Get() + page_index},
+                                         GetPage(page_index)->GetEntryCount() - 1));
+            entries_output_->Append(entry, entry_type_.GetAlign());
+        }
+    }
+
+    // adds pages and entries of indexes to table, must be called after last row
+    void Commit()
+    {
+        Finish();
+        page::Id page_id_expected = page_id_begin_;
+        for (const page::Offset free_size : written_free_sizes_)
+        {
+            const page::Id page_id = fst::Append(file_ids_.fst, free_size);
+            ASSERT(page_id == page_id_expected);
+            page_id_expected++;
+        }
+        if (!entries_output_)
+        {
+            return;
+        }
+        const auto [page_begin, page_end] = entries_output_->EndSection();
+        temp::Input input;
+        input.Init(*entries_file_, page_begin, page_end);
+        page::Offset size{};
+        while (const U8* const row = input.Next(size))
+        {
+            const Value              entry  = row::Read(entry_type_, row);
+            const ColumnValueInteger row_id = std::get<ColumnValueInteger>(entry.back());
+            for (std::size_t i = 0; i < indexes_.size(); i++)
+            {
+                if (entry[i].index() == 0)
+                {
+                    continue; // NULL never matches
+                }
+                Type key_type;
+                key_type.Push(entry_type_.At(i));
+                btree::Insert(indexes_[i].file_id, key_type, {entry[i]}, row_id);
+            }
+        }
+    }
+
+private:
+    // writes pages filled so far
+    void Finish()
+    {
+        if (free_sizes_.empty())
+        {
+            return;
+        }
+        const auto page_count = static_cast<unsigned int>(free_sizes_.size());
+        file_.Write(page_id_, page_count, pages_.GetFrame(buffer::FrameId{}));
+        written_free_sizes_.insert(written_free_sizes_.end(), free_sizes_.begin(),
+                                   free_sizes_.end());
+        page_id_ = page::Id{page_id_.Get() + page_count};
+        free_sizes_.clear();
+    }
+
+    [[nodiscard]] page::Slotted<>* GetPage(std::size_t index)
+    {
+        return static_cast<page::Slotted<>*>(
+            pages_.GetFrame(buffer::FrameId{static_cast<U32>(index)}));
+    }
+
+    const Type&                        type_;
+    const std::vector<catalog::Index>& indexes_;
+    const catalog::FileIds             file_ids_;
+    const os::File                     file_;
+
+    buffer::Buffer<>          pages_;
+    const page::Id            page_id_begin_;      // of first page loaded
+    page::Id                  page_id_;            // of first page in memory
+    std::vector<page::Offset> free_sizes_;         // of pages in memory
+    std::vector<page::Offset> written_free_sizes_; // of pages written to file
+
+    Type                        entry_type_;
+    std::optional<os::TempFile> entries_file_;
+    std::optional<temp::Output> entries_output_;
+};
+
+// rows are added to table only after all of them are read, so that none are loaded on error
+template <typename Reader>
+static void LoadRows(Reader& reader, PageWriter& writer)
+{
+    Value value;
+    while (reader.Next(value))
+    {
+        writer.Insert(value);
+    }
+    writer.Commit();
+}
+
+void Load(catalog::TableId table_id, const Type& type, const std::vector<catalog::Index>& indexes,
+          const std::string& file_name, Format format)
+{
+    switch (format)
+    {
+    case Format::kCsv:
+    {
+        CsvReader  reader{file_name, type};
+        PageWriter writer{table_id, type, indexes};
+        LoadRows(reader, writer);
+        return;
+    }
+    case Format::kBinary:
+    {
+        BinaryReader reader{file_name, type};
+        PageWriter   writer{table_id, type, indexes};
+        LoadRows(reader, writer);
+        return;
+    }
+    }
+    UNREACHABLE();
+}
+} // namespace load
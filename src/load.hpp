@@ -0,0 +1,25 @@
+#pragma once
+
+#include "catalog.hpp"
+#include "type.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// bulk loading of files into tables (COPY)
+namespace load
+{
+enum class Format : std::uint8_t
+{
+    kCsv,    // fields separated by commas and quoted by '"' if needed, empty field is NULL
+    kBinary, // for each column 0 for NULL, or 1 followed by value in native byte order (INTEGER
+             // and REAL in 8 bytes, VARCHAR as 4 byte length followed by characters)
+};
+
+// File is read in large chunks and rows are written to new pages, which are filled in memory and
+// appended to data file in batches without going through buffer pool. No rows are loaded if there
+// is an error, they become part of table only after the whole file is read.
+void Load(catalog::TableId table_id, const Type& type, const std::vector<catalog::Index>& indexes,
+          const std::string& file_name, Format format);
+} // namespace load
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Tournament tree for k-way merge. Leaves are inputs, each inner node keeps the loser of the match
+// between the winners of its subtrees, and the overall winner is kept aside. When the current row
+// of the winner changes, only the matches on its path to the root are replayed, so that each
+// output row costs about log2(k) comparisons.
+//
+// Less compares current rows of two inputs, exhausted inputs must be greater than all others.
+
+template <typename Less>
+    requires std::predicate<Less&, std::size_t, std::size_t>
+class LoserTree
+{
+public:
+    LoserTree(std::size_t count, Less less) : count_{count}, less_{std::move(less)}, nodes_(count)
+    {
+        ASSERT(count > 0);
+        winner_ = count_ > 1 ? Build(1) : 0;
+    }
+
+    [[nodiscard]] std::size_t GetWinner() const
+    {
+        return winner_;
+    }
+
+    // current row of the winner has changed
+    void Update()
+    {
+        std::size_t winner = winner_;
+        for (std::size_t node = (winner + count_) / 2; node > 0; node /= 2)
+        {
+            if (less_(nodes_[node], winner))
+            {
+                std::swap(nodes_[node], winner);
+            }
+        }
+        winner_ = winner;
+    }
+
+private:
+    // leaves are nodes from count to 2 * count - 1
+    std::size_t Build(std::size_t node)
+    {
+        if (node >= count_)
+        {
+            return node - count_;
+        }
+        const std::size_t winner_l = Build(node * 2);
+        const std::size_t winner_r = Build((node * 2) + 1);
+        if (less_(winner_r, winner_l))
+        {
+            nodes_[node] = winner_l;
+            return winner_r;
+        }
+        nodes_[node] = winner_r;
+        return winner_l;
+    }
+
+    const std::size_t        count_;
+    Less                     less_;
+    std::vector<std::size_t> nodes_; // losers, the first one is not used
+    std::size_t              winner_;
+};
@@ -6,24 +6,28 @@
 #include "execute.hpp"
 #include "lexer.hpp"
 #include "parse.hpp"
+#include "scheduler.hpp"
 #include "token.hpp"
 
 #include <cctype>
 #include <cstdio>
+#include <cstdlib>
 #include <exception>
 #include <fstream>
 #include <iostream>
 #include <iterator>
 #include <string>
 
-static std::string Trim(const std::string& text);
-static void        ParseAndExecuteStatement(const std::string& source);
-static void        ParseAndExecuteFile(const std::string& file_name);
+static scheduler::Options GetSchedulerOptions();
+static std::string        Trim(const std::string& text);
+static void               ParseAndExecuteStatement(const std::string& source);
+static void               ParseAndExecuteFile(const std::string& file_name);
 
 int main(int argc, const char** argv)
 {
     buffer::Init();
     catalog::Init();
+    scheduler::Init(GetSchedulerOptions());
 
     if (argc > 1)
     {
@@ -49,9 +53,25 @@ int main(int argc, const char** argv)
         }
     }
 
+    scheduler::Destroy();
     buffer::Destroy();
 }
 
+// DATABASE_WORKERS sets number of worker threads, DATABASE_PIN=1 pins them to cpus
+static scheduler::Options GetSchedulerOptions()
+{
+    scheduler::Options options;
+    if (const char* workers = std::getenv("DATABASE_WORKERS"))
+    {
+        options.worker_count = std::strtoul(workers, nullptr, 10);
+    }
+    if (const char* pin = std::getenv("DATABASE_PIN"))
+    {
+        options.pin = std::string{pin} == "1";
+    }
+    return options;
+}
+
 static std::string Trim(const std::string& text)
 {
     std::size_t begin = 0;
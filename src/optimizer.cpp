@@ -0,0 +1,131 @@
+#include "optimizer.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <numeric>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace optimizer
+{
+// cheapest join of a set of relations found so far
+struct Best
+{
+    Estimate    estimate;
+    RelationSet left, right;
+};
+
+// appends plan of set of relations after plans of its inputs, returns its index
+static std::size_t Emit(const std::vector<std::optional<Best>>& best, RelationSet relations,
+                        std::vector<Plan>& plans)
+{
+    if (std::has_single_bit(relations))
+    {
+        return std::countr_zero(relations);
+    }
+    const Best&       node  = *best[relations];
+    const std::size_t left  = Emit(best, node.left, plans);
+    const std::size_t right = Emit(best, node.right, plans);
+    plans.push_back(
+        {.relations = relations, .estimate = node.estimate, .left = left, .right = right});
+    return plans.size() - 1;
+}
+
+static void OrderExhaustive(std::vector<Plan>& plans, const JoinEstimator& estimator)
+{
+    const RelationSet                all = (RelationSet{1} << plans.size()) - 1;
+    std::vector<std::optional<Best>> best(all + 1);
+
+    const auto get_plan = [&plans, &best](RelationSet relations) -> Plan
+    {
+        if (std::has_single_bit(relations))
+        {
+            return plans[std::countr_zero(relations)];
+        }
+        return {.relations = relations, .estimate = best[relations]->estimate};
+    };
+
+    // subsets of a set are smaller numbers, so they are planned before it
+    for (RelationSet relations = 1; relations <= all; relations++)
+    {
+        if (std::has_single_bit(relations))
+        {
+            continue;
+        }
+        std::optional<Best>& node = best[relations];
+        for (RelationSet left = (relations - 1) & relations; left != 0;
+             left             = (left - 1) & relations)
+        {
+            const RelationSet right    = relations ^ left;
+            const Estimate    estimate = estimator(get_plan(left), get_plan(right));
+            if (!node || estimate.cost < node->estimate.cost)
+            {
+                node = Best{.estimate = estimate, .left = left, .right = right};
+            }
+        }
+    }
+    std::ignore = Emit(best, all, plans);
+}
+
+static void OrderGreedy(std::vector<Plan>& plans, const JoinEstimator& estimator)
+{
+    std::vector<std::size_t> roots(plans.size());
+    std::iota(roots.begin(), roots.end(), 0);
+    while (roots.size() > 1)
+    {
+        std::optional<Plan> best;
+        std::size_t         best_i = 0;
+        std::size_t         best_j = 0;
+        for (std::size_t i = 0; i < roots.size(); i++)
+        {
+            for (std::size_t j = 0; j < roots.size(); j++)
+            {
+                if (i == j)
+                {
+                    continue;
+                }
+                const Plan&    left     = plans[roots[i]];
+                const Plan&    right    = plans[roots[j]];
+                const Estimate estimate = estimator(left, right);
+                // smallest result, the cheaper order of inputs
+                if (!best || std::tie(estimate.rows, estimate.cost) <
+                                 std::tie(best->estimate.rows, best->estimate.cost))
+                {
+                    best   = Plan{.relations = left.relations | right.relations,
+                                  .estimate  = estimate,
+                                  .left      = roots[i],
+                                  .right     = roots[j]};
+                    best_i = i;
+                    best_j = j;
+                }
+            }
+        }
+        plans.push_back(*best); // NOLINT(bugprone-unchecked-optional-access)
+        roots.erase(roots.begin() + static_cast<std::ptrdiff_t>(std::max(best_i, best_j)));
+        roots.erase(roots.begin() + static_cast<std::ptrdiff_t>(std::min(best_i, best_j)));
+        roots.push_back(plans.size() - 1);
+    }
+}
+
+std::vector<Plan> OrderJoins(const std::vector<Estimate>& relations, const JoinEstimator& estimator)
+{
+    ASSERT(!relations.empty() && relations.size() <= kRelationCountMax);
+    std::vector<Plan> plans;
+    for (std::size_t i = 0; i < relations.size(); i++)
+    {
+        plans.push_back({.relations = RelationSet{1} << i, .estimate = relations[i]});
+    }
+    if (relations.size() <= kExhaustiveCountMax)
+    {
+        OrderExhaustive(plans, estimator);
+    }
+    else
+    {
+        OrderGreedy(plans, estimator);
+    }
+    return plans;
+}
+} // namespace optimizer
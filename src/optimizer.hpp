@@ -0,0 +1,48 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Join order enumeration, independent of how joins are costed. Relations are numbered from zero
+// and sets of them are bit masks. Few relations are ordered exhaustively by dynamic programming
+// over their subsets (bushy trees included), more of them greedily by joining the pair of plans
+// with the smallest result until one plan is left.
+namespace optimizer
+{
+using RelationSet = U64;
+
+constexpr std::size_t kRelationCountMax   = 64;
+constexpr std::size_t kExhaustiveCountMax = 10; // subsets are enumerated in 3^n steps
+
+struct Estimate
+{
+    double rows;
+    double cost; // including cost of inputs
+};
+
+// node of join tree, leaves are relations
+struct Plan
+{
+    RelationSet relations;
+    Estimate    estimate;
+    std::size_t left  = 0; // indexes of inputs in plans, not used by leaves
+    std::size_t right = 0;
+
+    [[nodiscard]] bool IsLeaf() const
+    {
+        return std::has_single_bit(relations);
+    }
+};
+
+// estimates join of plans of disjoint sets of relations, left one is outer input
+using JoinEstimator = std::function<Estimate(const Plan& left, const Plan& right)>;
+
+// Returns the cheapest join tree found, in which inputs precede joins, the first plans are
+// leaves in order of relations and the last one is the root.
+[[nodiscard]] std::vector<Plan> OrderJoins(const std::vector<Estimate>& relations,
+                                           const JoinEstimator&         estimator);
+} // namespace optimizer
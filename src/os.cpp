@@ -4,6 +4,8 @@
 #include "page.hpp"
 
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/fcntl.h>
 #include <sys/random.h>
 #include <sys/stat.h>
@@ -14,6 +16,7 @@
 #include <cstddef>
 #include <cstdio>
 #include <string>
+#include <thread>
 #include <utility>
 
 namespace os
@@ -43,43 +46,38 @@ static void FileClose(int fd) noexcept
     }
 }
 
-static void FileSeek(int fd, page::Id page_id)
+// reads and writes are positioned, so that file can be shared between threads
+static off_t GetOffset(page::Id page_id)
 {
-    const auto offset = static_cast<off_t>(page_id.Get()) * page::kSize;
-    if (::lseek(fd, offset, SEEK_SET) != offset)
-    {
-        throw ServerError{"lseek", std::to_string(fd), errno};
-    }
+    return static_cast<off_t>(page_id.Get()) * page::kSize;
 }
 
 static void FileRead(int fd, page::Id page_id, void* buffer)
 {
-    FileSeek(fd, page_id);
     const std::size_t bytes          = page::kSize;
-    const ssize_t     bytes_returned = ::read(fd, buffer, bytes);
+    const ssize_t     bytes_returned = ::pread(fd, buffer, bytes, GetOffset(page_id));
     if (bytes_returned < 0)
     {
-        throw ServerError{"read", std::to_string(fd), errno};
+        throw ServerError{"pread", std::to_string(fd), errno};
     }
     if (std::cmp_less(bytes_returned, bytes))
     {
-        throw ServerError{"less bytes returned in read(" + std::to_string(fd) +
+        throw ServerError{"less bytes returned in pread(" + std::to_string(fd) +
                           "): " + std::to_string(bytes_returned) + " < " + std::to_string(bytes)};
     }
 }
 
-static void FileWrite(int fd, page::Id page_id, const void* buffer)
+static void FileWrite(int fd, page::Id page_id, const void* buffer, unsigned int page_count = 1)
 {
-    FileSeek(fd, page_id);
-    const std::size_t bytes          = page::kSize;
-    const ssize_t     bytes_returned = ::write(fd, buffer, bytes);
+    const std::size_t bytes          = static_cast<std::size_t>(page_count) * page::kSize;
+    const ssize_t     bytes_returned = ::pwrite(fd, buffer, bytes, GetOffset(page_id));
     if (bytes_returned < 0)
     {
-        throw ServerError{"write", std::to_string(fd), errno};
+        throw ServerError{"pwrite", std::to_string(fd), errno};
     }
     if (std::cmp_less(bytes_returned, bytes))
     {
-        throw ServerError{"less bytes returned in write(" + std::to_string(fd) +
+        throw ServerError{"less bytes returned in pwrite(" + std::to_string(fd) +
                           "): " + std::to_string(bytes_returned) + " < " + std::to_string(bytes)};
     }
 }
@@ -164,6 +162,11 @@ void File::Write(page::Id page_id, const void* buffer) const
     FileWrite(fd_, page_id, buffer);
 }
 
+void File::Write(page::Id page_id, unsigned int page_count, const void* buffer) const
+{
+    FileWrite(fd_, page_id, buffer, page_count);
+}
+
 TempFile::TempFile() : fd_{FileCreateTemp()}
 {
 }
@@ -204,4 +207,31 @@ unsigned int Random()
     }
     return value;
 }
+
+void PinThread(std::thread& thread, unsigned int cpu_index)
+{
+    cpu_set_t available;
+    CPU_ZERO(&available);
+    if (::sched_getaffinity(0, sizeof(available), &available) < 0)
+    {
+        throw ServerError{"sched_getaffinity", errno};
+    }
+    const int count = CPU_COUNT(&available);
+    int       index = static_cast<int>(cpu_index % static_cast<unsigned int>(count));
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &available) && index-- == 0)
+        {
+            CPU_SET(cpu, &cpus);
+            break;
+        }
+    }
+    const int err = ::pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+    if (err != 0)
+    {
+        throw ServerError{"pthread_setaffinity_np", err};
+    }
+}
 } // namespace os
@@ -5,6 +5,7 @@
 
 #include <optional>
 #include <string>
+#include <thread>
 
 namespace os
 {
@@ -27,6 +28,7 @@ public:
 
     void Read(page::Id page_id, void* buffer) const;
     void Write(page::Id page_id, const void* buffer) const;
+    void Write(page::Id page_id, unsigned int page_count, const void* buffer) const; // consecutive
 
 private:
     const int fd_;
@@ -62,4 +64,7 @@ private:
 };
 
 [[nodiscard]] unsigned int Random();
+
+// pins thread to one of the cpus available to the process, they are used in order
+void PinThread(std::thread& thread, unsigned int cpu_index);
 } // namespace os
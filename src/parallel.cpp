@@ -0,0 +1,285 @@
+#include "parallel.hpp"
+#include "buffer.hpp"
+#include "catalog.hpp"
+#include "common.hpp"
+#include "expr.hpp"
+#include "fst.hpp"
+#include "os.hpp"
+#include "page.hpp"
+#include "row.hpp"
+#include "scheduler.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace parallel
+{
+static constexpr unsigned int kWorkerCountMax     = 16;
+static constexpr unsigned int kWorkerPageCountMin = 64; // smaller tables are not worth a thread
+static constexpr unsigned int kMorselPageCount    = 16;
+
+unsigned int GetWorkerCount(page::Id page_count)
+{
+    return std::max(1U, std::min({scheduler::GetWorkerCount(), kWorkerCountMax,
+                                  page_count.Get() / kWorkerPageCountMin}));
+}
+
+static std::string PrepareFile(catalog::FileId file_id)
+{
+    buffer::WriteBack(file_id);
+    return catalog::GetFileName(file_id);
+}
+
+Morsels::Morsels(catalog::FileIds file_ids)
+    : file_name_{PrepareFile(file_ids.dat)}, page_count_{fst::GetPageCount(file_ids.fst)}
+{
+}
+
+bool Morsels::Next(page::Id& begin_out, page::Id& end_out)
+{
+    const page::Id::Type begin = next_.fetch_add(kMorselPageCount);
+    if (begin >= page_count_.Get())
+    {
+        return false;
+    }
+    begin_out = page::Id{begin};
+    end_out   = page::Id{std::min(begin + kMorselPageCount, page_count_.Get())};
+    return true;
+}
+
+Reader::Reader(const std::string& file_name, const Type& type,
+               const std::vector<ColumnId>& columns)
+    : type_{type}, columns_{columns}, file_{file_name}, page_id_{}, page_end_{}
+{
+}
+
+void Reader::Seek(page::Id begin, page::Id end)
+{
+    page_id_  = begin;
+    page_end_ = end;
+    if (page_id_ < page_end_)
+    {
+        file_.Read(page_id_, page_.Get());
+    }
+    entry_id_ = page::EntryId{};
+}
+
+std::optional<Value> Reader::Next()
+{
+    for (;;)
+    {
+        if (page_id_ == page_end_)
+        {
+            return std::nullopt;
+        }
+        if (entry_id_ == page_->GetEntryCount())
+        {
+            page_id_++;
+            if (page_id_ < page_end_)
+            {
+                file_.Read(page_id_, page_.Get());
+            }
+            entry_id_ = page::EntryId{};
+            continue;
+        }
+        const U8* const entry = page_->GetEntry(entry_id_++);
+        if (entry == nullptr)
+        {
+            continue;
+        }
+        return row::Read(type_, columns_, entry);
+    }
+}
+} // namespace parallel
+
+static constexpr unsigned int kTasksPerWorker = 2; // bounds queue of results
+
+IterGather::IterGather(catalog::FileIds file_ids, Type&& table_type,
+                       std::vector<ColumnId>&& columns, ExprPtr&& filter,
+                       std::vector<ExprPtr>&& exprs, Type&& type, unsigned int worker_count)
+    : IterBase{std::move(type)}, file_ids_{file_ids}, table_type_{std::move(table_type)},
+      columns_{std::move(columns)}, filter_{std::move(filter)}, exprs_{std::move(exprs)},
+      worker_count_{worker_count}
+{
+    ASSERT(worker_count_ > 0);
+}
+
+IterGather::~IterGather()
+{
+    Stop();
+}
+
+void IterGather::Open()
+{
+    Start();
+}
+
+void IterGather::Restart()
+{
+    Stop();
+    Start();
+}
+
+void IterGather::Close()
+{
+    Stop();
+}
+
+void IterGather::SetLimit(std::size_t count)
+{
+    limit_ = count;
+}
+
+std::optional<Value> IterGather::Next()
+{
+    if (limit_ && returned_ == *limit_)
+    {
+        return std::nullopt;
+    }
+    for (;;)
+    {
+        if (batch_index_ < batch_.size())
+        {
+            Value value = std::move(batch_[batch_index_++]);
+            if (limit_ && ++returned_ == *limit_)
+            {
+                Stop();
+            }
+            return value;
+        }
+        std::unique_lock lock{mutex_};
+        Submit();
+        ready_.wait(lock, [this] { return !queue_.empty() || running_ == 0 || error_; });
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+        if (queue_.empty())
+        {
+            if (done_ || IsLimitReached())
+            {
+                return std::nullopt;
+            }
+            continue;
+        }
+        batch_ = std::move(queue_.front());
+        queue_.pop_front();
+        batch_index_ = 0;
+    }
+}
+
+std::string IterGather::GetName() const
+{
+    return "Gather " + catalog::GetFileName(file_ids_.dat) + " (" + std::to_string(worker_count_) +
+           " workers)";
+}
+
+void IterGather::Start()
+{
+    morsels_.emplace(file_ids_);
+    tasks_.emplace();
+    queue_.clear();
+    batch_.clear();
+    batch_index_ = 0;
+    running_     = 0;
+    done_        = false;
+    error_       = nullptr;
+    produced_    = 0;
+    returned_    = 0;
+}
+
+void IterGather::Stop()
+{
+    tasks_.reset(); // cancels and waits for running tasks
+    morsels_.reset();
+    queue_.clear();
+}
+
+bool IterGather::IsLimitReached() const
+{
+    return limit_ && produced_.load(std::memory_order_relaxed) >= *limit_;
+}
+
+// mutex must be locked
+void IterGather::Submit()
+{
+    while (!done_ && !IsLimitReached() &&
+           running_ + queue_.size() < worker_count_ * kTasksPerWorker)
+    {
+        running_++;
+        tasks_->Submit([this] { Run(); });
+    }
+}
+
+void IterGather::Run()
+{
+    std::vector<Value> rows;
+    std::exception_ptr error;
+    bool               done = false;
+    try
+    {
+        page::Id begin;
+        page::Id end;
+        if (morsels_->Next(begin, end))
+        {
+            parallel::Reader reader{morsels_->GetFileName(), table_type_, columns_};
+            reader.Seek(begin, end);
+            while (!tasks_->IsCancelled() && !IsLimitReached())
+            {
+                std::optional<Value> value = reader.Next();
+                if (!value)
+                {
+                    break;
+                }
+                if (filter_ && std::get<ColumnValueBoolean>(filter_->Eval(&*value)) != Bool::kTrue)
+                {
+                    continue;
+                }
+                produced_.fetch_add(1, std::memory_order_relaxed);
+                if (exprs_.empty())
+                {
+                    rows.push_back(std::move(*value));
+                    continue;
+                }
+                Value result;
+                result.reserve(exprs_.size());
+                for (const ExprPtr& expr : exprs_)
+                {
+                    result.push_back(expr->Eval(&*value));
+                }
+                rows.push_back(std::move(result));
+            }
+        }
+        else
+        {
+            done = true;
+        }
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    {
+        const std::lock_guard lock{mutex_};
+        running_--;
+        done_ = done_ || done;
+        if (error && !error_)
+        {
+            error_ = error;
+        }
+        if (!rows.empty())
+        {
+            queue_.push_back(std::move(rows));
+        }
+    }
+    ready_.notify_one();
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "catalog.hpp"
+#include "common.hpp"
+#include "expr.hpp"
+#include "fst.hpp"
+#include "iter.hpp"
+#include "os.hpp"
+#include "page.hpp"
+#include "scheduler.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// scans of large tables split between worker threads
+namespace parallel
+{
+// returns 1 if the table is too small to be split between workers of scheduler
+[[nodiscard]] unsigned int GetWorkerCount(page::Id page_count);
+
+// Pages of table are claimed by workers in small ranges (morsels) from a shared counter, so that
+// faster workers take more of them. Workers read pages directly from the file, not through buffer.
+class Morsels
+{
+public:
+    // must be created by the main thread, pages modified in buffer are written first
+    explicit Morsels(catalog::FileIds file_ids);
+
+    [[nodiscard]] bool Next(page::Id& begin_out, page::Id& end_out);
+
+    [[nodiscard]] const std::string& GetFileName() const
+    {
+        return file_name_;
+    }
+
+private:
+    const std::string           file_name_;
+    const page::Id              page_count_;
+    std::atomic<page::Id::Type> next_ = 0;
+};
+
+// reads rows of a range of pages, only the given columns if there are some
+class Reader
+{
+public:
+    Reader(const std::string& file_name, const Type& type, const std::vector<ColumnId>& columns);
+
+    void                 Seek(page::Id begin, page::Id end);
+    std::optional<Value> Next();
+
+private:
+    const Type& type_; // NOLINT(cppcoreguidelines-avoid-const-or-ref-data-members)
+    const std::vector<ColumnId>&
+        columns_; // NOLINT(cppcoreguidelines-avoid-const-or-ref-data-members)
+
+    const os::File                        file_;
+    const buffer::Buffer<page::Slotted<>> page_;
+
+    page::Id      page_id_, page_end_;
+    page::EntryId entry_id_;
+};
+} // namespace parallel
+
+// Each morsel of table is read by a task of scheduler, which filters and projects its rows and
+// passes them to the main thread through a queue. New tasks are submitted only as results are
+// consumed, so that the queue is bounded. Order of rows is not preserved.
+class IterGather : public IterBase
+{
+public:
+    IterGather(catalog::FileIds file_ids, Type&& table_type, std::vector<ColumnId>&& columns,
+               ExprPtr&& filter, std::vector<ExprPtr>&& exprs, Type&& type,
+               unsigned int worker_count);
+    ~IterGather() override;
+
+    IterGather(const IterGather&)            = delete;
+    IterGather& operator=(const IterGather&) = delete;
+    IterGather(IterGather&&)                 = delete;
+    IterGather& operator=(IterGather&&)      = delete;
+
+    void                 Open() override;
+    void                 Restart() override;
+    void                 Close() override;
+    std::optional<Value> Next() override;
+    void                 SetLimit(std::size_t count) override;
+    std::string          GetName() const override;
+
+private:
+    void Start();
+    void Stop();
+    void Submit();
+    void Run(); // runs in worker thread, reads one morsel
+
+    [[nodiscard]] bool IsLimitReached() const;
+
+    const catalog::FileIds      file_ids_;
+    const Type                  table_type_; // of columns read
+    const std::vector<ColumnId> columns_;    // of table which are read, all if empty
+    const ExprPtr               filter_;
+    const std::vector<ExprPtr> exprs_; // projection, rows are passed as they are if empty
+    const unsigned int         worker_count_;
+
+    // tasks stop once enough rows are produced, tasks are cancelled once the last one is returned
+    std::optional<std::size_t> limit_;
+    std::atomic<std::size_t>   produced_ = 0;
+    std::size_t                returned_ = 0;
+
+    std::optional<parallel::Morsels>    morsels_;
+    std::optional<scheduler::TaskGroup> tasks_;
+
+    std::mutex                     mutex_;
+    std::condition_variable        ready_;
+    std::deque<std::vector<Value>> queue_;
+    unsigned int                   running_ = 0;     // submitted tasks which have not finished
+    bool                           done_    = false; // all morsels were claimed
+    std::exception_ptr             error_;
+
+    std::vector<Value> batch_;
+    std::size_t        batch_index_ = 0;
+};
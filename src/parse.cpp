@@ -128,6 +128,12 @@ static AstExprPtr ParseExprPrimary(Lexer& lexer, ExprContext context, int prec)
         return std::make_unique<AstExpr>(
             AstExpr{.data = AstExpr::DataConstant{std::move(value)}, .text = text});
     }
+    if (lexer.Accept(Token::kParameter))
+    {
+        auto [index, text] = lexer.StepToken().Take<Token::DataParameter>();
+        return std::make_unique<AstExpr>(
+            AstExpr{.data = AstExpr::DataParameter{index}, .text = std::move(text)});
+    }
     if (lexer.Accept(Token::kIdentifier))
     {
         auto [column, text] = ParseColumn(lexer);
@@ -561,7 +567,6 @@ static AstQuery ParseQuery(Lexer& lexer)
 
 static AstCreateTable ParseCreateTable(Lexer& lexer)
 {
-    lexer.ExpectStep(Token::kKeywordCreate);
     lexer.ExpectStep(Token::kKeywordTable);
     SourceText name = lexer.ExpectStep(Token::kIdentifier).GetText();
     lexer.ExpectStep(Token::kLParen);
@@ -583,6 +588,19 @@ static AstCreateTable ParseCreateTable(Lexer& lexer)
     return {.name = std::move(name), .columns = std::move(columns)};
 }
 
+static AstCreateIndex ParseCreateIndex(Lexer& lexer)
+{
+    // TODO: UNIQUE, multiple columns
+    lexer.ExpectStep(Token::kKeywordIndex);
+    SourceText name = lexer.ExpectStep(Token::kIdentifier).GetText();
+    lexer.ExpectStep(Token::kKeywordOn);
+    SourceText table = lexer.ExpectStep(Token::kIdentifier).GetText();
+    lexer.ExpectStep(Token::kLParen);
+    SourceText column = lexer.ExpectStep(Token::kIdentifier).GetText();
+    lexer.ExpectStep(Token::kRParen);
+    return {.name = std::move(name), .table = std::move(table), .column = std::move(column)};
+}
+
 static AstDropTable ParseDropTable(Lexer& lexer)
 {
     // TODO: CASCADE | RESTRICT
@@ -592,21 +610,30 @@ static AstDropTable ParseDropTable(Lexer& lexer)
     return {.name = std::move(name)};
 }
 
-static AstInsertValue ParseInsertValue(Lexer& lexer)
+static AstStatement ParseInsert(Lexer& lexer)
 {
     lexer.ExpectStep(Token::kKeywordInsert);
     lexer.ExpectStep(Token::kKeywordInto);
     SourceText table = lexer.ExpectStep(Token::kIdentifier).GetText();
+    if (lexer.Accept(Token::kKeywordSelect))
+    {
+        return AstInsertQuery{.table = std::move(table), .query = ParseQuery(lexer)};
+    }
     lexer.ExpectStep(Token::kKeywordValues);
-    lexer.ExpectStep(Token::kLParen);
-    std::vector<AstExprPtr> exprs;
+    std::vector<std::vector<AstExprPtr>> rows;
     do
     {
-        exprs.push_back(
-            ParseExpr(lexer, ExprContext{.accept_aggregate = false, .inside_aggregate = false}));
+        lexer.ExpectStep(Token::kLParen);
+        std::vector<AstExprPtr> exprs;
+        do
+        {
+            exprs.push_back(ParseExpr(
+                lexer, ExprContext{.accept_aggregate = false, .inside_aggregate = false}));
+        } while (lexer.AcceptStep(Token::kComma));
+        lexer.ExpectStep(Token::kRParen);
+        rows.push_back(std::move(exprs));
     } while (lexer.AcceptStep(Token::kComma));
-    lexer.ExpectStep(Token::kRParen);
-    return {.table = std::move(table), .exprs = std::move(exprs)};
+    return AstInsertValue{.table = std::move(table), .rows = std::move(rows)};
 }
 
 static AstUpdate ParseUpdate(Lexer& lexer)
@@ -652,10 +679,102 @@ static AstDelete ParseDelete(Lexer& lexer)
     return {.table = std::move(table), .condition_opt = std::move(condition_opt)};
 }
 
+static AstAnalyze ParseAnalyze(Lexer& lexer)
+{
+    lexer.ExpectStep(Token::kKeywordAnalyze);
+    std::optional<SourceText> table;
+    if (lexer.Accept(Token::kIdentifier))
+    {
+        table = lexer.ExpectStep(Token::kIdentifier).GetText();
+    }
+    return {.table = std::move(table)};
+}
+
+static AstExplain ParseExplain(Lexer& lexer)
+{
+    lexer.ExpectStep(Token::kKeywordExplain);
+    const bool analyze = lexer.AcceptStep(Token::kKeywordAnalyze);
+    return {.query = ParseQuery(lexer), .analyze = analyze};
+}
+
+static AstPrepare ParsePrepare(Lexer& lexer)
+{
+    lexer.ExpectStep(Token::kKeywordPrepare);
+    SourceText name = lexer.ExpectStep(Token::kIdentifier).GetText();
+    lexer.ExpectStep(Token::kKeywordAs);
+    const SourceText   text_begin = lexer.GetToken().GetText();
+    const AstStatement statement  = ParseStatement(lexer);
+    const SourceText   text_end   = lexer.GetToken().GetText();
+    SourceText         text{text_begin, text_end};
+    if (!std::holds_alternative<AstInsertValue>(statement) &&
+        !std::holds_alternative<AstInsertQuery>(statement) &&
+        !std::holds_alternative<AstQuery>(statement) &&
+        !std::holds_alternative<AstDelete>(statement))
+    {
+        throw ClientError{"statement cannot be prepared", std::move(text)};
+    }
+    return {.name = std::move(name), .statement = std::move(text)};
+}
+
+static AstExecute ParseExecute(Lexer& lexer)
+{
+    lexer.ExpectStep(Token::kKeywordExecute);
+    SourceText              name = lexer.ExpectStep(Token::kIdentifier).GetText();
+    std::vector<AstExprPtr> args;
+    if (lexer.AcceptStep(Token::kLParen))
+    {
+        do
+        {
+            args.push_back(ParseExpr(
+                lexer, ExprContext{.accept_aggregate = false, .inside_aggregate = false}));
+        } while (lexer.AcceptStep(Token::kComma));
+        lexer.ExpectStep(Token::kRParen);
+    }
+    return {.name = std::move(name), .args = std::move(args)};
+}
+
+static AstDeallocate ParseDeallocate(Lexer& lexer)
+{
+    lexer.ExpectStep(Token::kKeywordDeallocate);
+    return {.name = lexer.ExpectStep(Token::kIdentifier).GetText()};
+}
+
+static AstCopy ParseCopy(Lexer& lexer)
+{
+    lexer.ExpectStep(Token::kKeywordCopy);
+    SourceText table = lexer.ExpectStep(Token::kIdentifier).GetText();
+    lexer.ExpectStep(Token::kKeywordFrom);
+    lexer.Expect(Token::kConstant);
+    auto [value, text] = lexer.StepToken().Take<Token::DataConstant>();
+    auto* file_name    = std::get_if<ColumnValueVarchar>(&value);
+    if (file_name == nullptr)
+    {
+        throw ClientError{"file name expected", std::move(text)};
+    }
+    std::optional<SourceText> format;
+    if (lexer.AcceptStep(Token::kLParen))
+    {
+        SourceText option = lexer.ExpectStep(Token::kIdentifier).GetText();
+        if (option.Get() != "FORMAT")
+        {
+            throw ClientError{"unknown option", std::move(option)};
+        }
+        format = lexer.ExpectStep(Token::kIdentifier).GetText();
+        lexer.ExpectStep(Token::kRParen);
+    }
+    return {.table     = std::move(table),
+            .file_name = std::move(*file_name),
+            .format    = std::move(format)};
+}
+
 AstStatement ParseStatement(Lexer& lexer)
 {
-    if (lexer.Accept(Token::kKeywordCreate))
+    if (lexer.AcceptStep(Token::kKeywordCreate))
     {
+        if (lexer.Accept(Token::kKeywordIndex))
+        {
+            return ParseCreateIndex(lexer);
+        }
         return ParseCreateTable(lexer);
     }
     if (lexer.Accept(Token::kKeywordDrop))
@@ -664,7 +783,7 @@ AstStatement ParseStatement(Lexer& lexer)
     }
     if (lexer.Accept(Token::kKeywordInsert))
     {
-        return ParseInsertValue(lexer);
+        return ParseInsert(lexer);
     }
     if (lexer.Accept(Token::kKeywordSelect))
     {
@@ -678,5 +797,29 @@ AstStatement ParseStatement(Lexer& lexer)
     {
         return ParseDelete(lexer);
     }
+    if (lexer.Accept(Token::kKeywordAnalyze))
+    {
+        return ParseAnalyze(lexer);
+    }
+    if (lexer.Accept(Token::kKeywordExplain))
+    {
+        return ParseExplain(lexer);
+    }
+    if (lexer.Accept(Token::kKeywordPrepare))
+    {
+        return ParsePrepare(lexer);
+    }
+    if (lexer.Accept(Token::kKeywordExecute))
+    {
+        return ParseExecute(lexer);
+    }
+    if (lexer.Accept(Token::kKeywordDeallocate))
+    {
+        return ParseDeallocate(lexer);
+    }
+    if (lexer.Accept(Token::kKeywordCopy))
+    {
+        return ParseCopy(lexer);
+    }
     lexer.Unexpected();
 }
@@ -0,0 +1,162 @@
+#include "prepare.hpp"
+#include "ast.hpp"
+#include "cache.hpp"
+#include "catalog.hpp"
+#include "compile.hpp"
+#include "error.hpp"
+#include "lexer.hpp"
+#include "parse.hpp"
+#include "token.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace prepare
+{
+struct Key
+{
+    std::string                            source;
+    std::vector<std::optional<ColumnType>> types; // of parameter values
+
+    bool operator==(const Key& other) const = default;
+};
+} // namespace prepare
+
+namespace std
+{
+template <> struct hash<prepare::Key>
+{
+    std::size_t operator()(const prepare::Key& key) const
+    {
+        static constexpr std::size_t kMultiplier = 31;
+        std::size_t                  hash        = std::hash<std::string>{}(key.source);
+        for (const std::optional<ColumnType> type : key.types)
+        {
+            hash = hash * kMultiplier + std::hash<std::optional<ColumnType>>{}(type);
+        }
+        return hash;
+    }
+};
+} // namespace std
+
+namespace prepare
+{
+[[nodiscard]] static std::shared_ptr<Plan> CompilePlan(const Key& key)
+{
+    auto plan             = std::make_shared<Plan>();
+    plan->source          = key.source;
+    plan->catalog_version = catalog::GetVersion();
+
+    const Parameters parameters{.types  = key.types,
+                                .values = std::make_shared<Value>(key.types.size())};
+    try
+    {
+        Lexer        lexer{plan->source};
+        AstStatement ast = ParseStatement(lexer);
+        lexer.Expect(Token::kEnd);
+        plan->statement = CompileStatement(ast, parameters);
+    }
+    catch (ClientError& error)
+    {
+        error.SetSource(plan->source); // e.g. type of parameter does not match
+        throw;
+    }
+    plan->parameters = parameters.values;
+    return plan;
+}
+
+struct Loader
+{
+    [[nodiscard]] std::shared_ptr<Plan> operator()(const Key& key) const
+    {
+        return CompilePlan(key);
+    }
+};
+
+static Cache<Key, std::shared_ptr<Plan>, Loader> plans{kPlanCountMax, Loader{}};
+
+static std::unordered_map<std::string, Prepared> statements;
+
+[[nodiscard]] static Key MakeKey(const std::string& source, const Value& parameters)
+{
+    Key key{.source = source, .types = {}};
+    key.types.reserve(parameters.size());
+    for (const ColumnValue& parameter : parameters)
+    {
+        key.types.push_back(ColumnValueToType(parameter));
+    }
+    return key;
+}
+
+std::shared_ptr<Plan> GetPlan(const std::string& source, const Value& parameters)
+{
+    const Key             key  = MakeKey(source, parameters);
+    std::shared_ptr<Plan> plan = plans.Get(key); // copied, since loads may evict it
+    if (plan->catalog_version != catalog::GetVersion())
+    {
+        plans.Remove(key);
+        plan = plans.Get(key);
+    }
+    if (plan->running)
+    {
+        return CompilePlan(key);
+    }
+    return plan;
+}
+
+void RemovePlan(const std::string& source, const Value& parameters)
+{
+    plans.Remove(MakeKey(source, parameters));
+}
+
+std::pair<std::string, unsigned int> Normalize(const std::string& source)
+{
+    std::string  normalized;
+    unsigned int parameter_count = 0;
+    Lexer        lexer{source};
+    while (!lexer.Accept(Token::kEnd))
+    {
+        const Token token = lexer.StepToken();
+        if (token.GetTag() == Token::kParameter)
+        {
+            parameter_count =
+                std::max(parameter_count, token.GetData<Token::DataParameter>() + 1);
+        }
+        if (!normalized.empty())
+        {
+            normalized += ' ';
+        }
+        normalized += token.GetText().Get();
+    }
+    return {std::move(normalized), parameter_count};
+}
+
+std::optional<Prepared> FindStatement(const std::string& name)
+{
+    const auto iter = statements.find(name);
+    if (iter == statements.end())
+    {
+        return std::nullopt;
+    }
+    return iter->second;
+}
+
+void AddStatement(std::string name, Prepared prepared)
+{
+    statements.insert_or_assign(std::move(name), std::move(prepared));
+}
+
+void RemoveStatement(const std::string& name)
+{
+    statements.erase(name);
+}
+} // namespace prepare
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "compile.hpp"
+#include "value.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+// Statements with parameters ($1, $2, ...) are compiled once for each combination of types of
+// parameter values, and their plans are kept in LRU cache by normalized text. Catalog statements
+// and prepared statements use the cache. Plans are compiled again once catalog version changes,
+// since they depend on tables, indexes and statistics.
+namespace prepare
+{
+constexpr std::size_t kPlanCountMax = 256;
+
+struct Plan
+{
+    std::string            source; // statement keeps pointers to it for error reports
+    Statement              statement;
+    std::shared_ptr<Value> parameters; // read by statement, set before each execution
+    unsigned int           catalog_version = 0;
+    bool                   running         = false;
+};
+
+// compiles plan only if it is not cached, or if cached one is running (statement is executed
+// again by itself, e.g. when catalog is read during its execution)
+[[nodiscard]] std::shared_ptr<Plan> GetPlan(const std::string& source, const Value& parameters);
+void RemovePlan(const std::string& source, const Value& parameters);
+
+// joins tokens by single spaces, returns number of parameters too
+[[nodiscard]] std::pair<std::string, unsigned int> Normalize(const std::string& source);
+
+struct Prepared
+{
+    std::string  source; // normalized
+    unsigned int parameter_count;
+};
+
+[[nodiscard]] std::optional<Prepared> FindStatement(const std::string& name);
+void                                  AddStatement(std::string name, Prepared prepared);
+void                                  RemoveStatement(const std::string& name);
+} // namespace prepare
@@ -4,9 +4,13 @@
 #include "type.hpp"
 #include "value.hpp"
 
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <utility>
 #include <variant>
+#include <vector>
 
 namespace row
 {
@@ -99,41 +103,62 @@ template <typename T> static const T* GetColumn(const U8* row, ColumnPrefix pref
     return reinterpret_cast<const T*>(row + prefix.offset);
 }
 
+static void ReadColumn(ColumnType type, ColumnId column_id, const U8* row, Value& value)
+{
+    const ColumnPrefix prefix = GetPrefix(row, column_id);
+    if (prefix.offset == 0)
+    {
+        value.emplace_back(ColumnValueNull{});
+        return;
+    }
+    switch (type)
+    {
+    case ColumnType::kBoolean:
+    {
+        value.emplace_back(*GetColumn<ColumnValueBoolean>(row, prefix));
+        break;
+    }
+    case ColumnType::kInteger:
+    {
+        value.emplace_back(*GetColumn<ColumnValueInteger>(row, prefix));
+        break;
+    }
+    case ColumnType::kReal:
+    {
+        value.emplace_back(*GetColumn<ColumnValueReal>(row, prefix));
+        break;
+    }
+    case ColumnType::kVarchar:
+    {
+        const char* const begin = GetColumn<char>(row, prefix);
+        value.emplace_back(ColumnValueVarchar{begin, prefix.size});
+        break;
+    }
+    }
+}
+
 Value Read(const Type& type, const U8* row)
 {
     Value value; // TODO: reserve
     for (ColumnId column_id{}; column_id < type.Size(); column_id++)
     {
-        const ColumnPrefix prefix = GetPrefix(row, column_id);
-        if (prefix.offset == 0)
-        {
-            value.emplace_back(ColumnValueNull{});
-            continue;
-        }
-        switch (type.At(column_id.Get()))
-        {
-        case ColumnType::kBoolean:
-        {
-            value.emplace_back(*GetColumn<ColumnValueBoolean>(row, prefix));
-            break;
-        }
-        case ColumnType::kInteger:
-        {
-            value.emplace_back(*GetColumn<ColumnValueInteger>(row, prefix));
-            break;
-        }
-        case ColumnType::kReal:
-        {
-            value.emplace_back(*GetColumn<ColumnValueReal>(row, prefix));
-            break;
-        }
-        case ColumnType::kVarchar:
-        {
-            const char* const begin = GetColumn<char>(row, prefix);
-            value.emplace_back(ColumnValueVarchar{begin, prefix.size});
-            break;
-        }
-        }
+        ReadColumn(type.At(column_id.Get()), column_id, row, value);
+    }
+    return value;
+}
+
+Value Read(const Type& type, const std::vector<ColumnId>& columns, const U8* row)
+{
+    if (columns.empty())
+    {
+        return Read(type, row);
+    }
+    ASSERT(type.Size() == columns.size());
+    Value value;
+    value.reserve(columns.size());
+    for (std::size_t i = 0; i < columns.size(); i++)
+    {
+        ReadColumn(type.At(i), columns[i], row, value);
     }
     return value;
 }
@@ -249,4 +274,77 @@ int Compare(const Type& type, ColumnId column, const U8* row_l, const Value& row
     }
     UNREACHABLE();
 }
-} // namespace row
\ No newline at end of file
+
+static void AppendBigEndian(U64 bits, std::vector<U8>& key)
+{
+    for (int shift = 56; shift >= 0; shift -= 8)
+    {
+        key.push_back(static_cast<U8>(bits >> shift));
+    }
+}
+
+void AppendKey(const Type& type, ColumnId column, bool asc, const U8* row, std::vector<U8>& key)
+{
+    static constexpr U64 kSignBit = U64{1} << 63;
+
+    const std::size_t  begin  = key.size();
+    const ColumnPrefix prefix = GetPrefix(row, column);
+    if (prefix.offset == 0)
+    {
+        key.push_back(1);
+    }
+    else
+    {
+        key.push_back(0);
+        switch (type.At(column.Get()))
+        {
+        case ColumnType::kBoolean:
+        {
+            UNREACHABLE();
+        }
+        case ColumnType::kInteger:
+        {
+            // two's complement with flipped sign bit orders as unsigned
+            const auto bits = std::bit_cast<U64>(*GetColumn<ColumnValueInteger>(row, prefix));
+            AppendBigEndian(bits ^ kSignBit, key);
+            break;
+        }
+        case ColumnType::kReal:
+        {
+            // negative values have all bits flipped, so that greater magnitude orders first
+            ColumnValueReal column_value = *GetColumn<ColumnValueReal>(row, prefix);
+            if (column_value == 0)
+            {
+                column_value = 0; // negative zero equals zero
+            }
+            const auto bits = std::bit_cast<U64>(column_value);
+            AppendBigEndian((bits & kSignBit) != 0 ? ~bits : bits ^ kSignBit, key);
+            break;
+        }
+        case ColumnType::kVarchar:
+        {
+            // zero bytes are escaped, so that the terminator orders before any continuation
+            const U8* const column_value = GetColumn<U8>(row, prefix);
+            for (page::Offset i = 0; i < prefix.size; i++)
+            {
+                key.push_back(column_value[i]);
+                if (column_value[i] == 0)
+                {
+                    key.push_back(0xFF);
+                }
+            }
+            key.push_back(0);
+            key.push_back(0);
+            break;
+        }
+        }
+    }
+    if (!asc)
+    {
+        for (std::size_t i = begin; i < key.size(); i++)
+        {
+            key[i] = ~key[i];
+        }
+    }
+}
+} // namespace row
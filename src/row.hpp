@@ -26,6 +26,14 @@ struct Prefix
 void                Write(const Prefix& prefix, const Value& value, U8* row);
 [[nodiscard]] Value Read(const Type& type, const U8* row);
 
+// reads only the given columns of row in their order, all of them if none are given,
+// type is of the columns read
+[[nodiscard]] Value Read(const Type& type, const std::vector<ColumnId>& columns, const U8* row);
+
 [[nodiscard]] int Compare(const Type& type, ColumnId column, const U8* row_l, const U8* row_r);
 [[nodiscard]] int Compare(const Type& type, ColumnId column, const U8* row_l, const Value& row_r);
+
+// Appends column to key, so that keys of rows compare by memcmp in the same order as Compare does.
+// Nulls are greater than other values, all bytes are inverted for descending order.
+void AppendKey(const Type& type, ColumnId column, bool asc, const U8* row, std::vector<U8>& key);
 } // namespace row
@@ -0,0 +1,282 @@
+#include "scheduler.hpp"
+#include "common.hpp"
+#include "os.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace scheduler
+{
+struct Worker
+{
+    unsigned int     index = 0;
+    std::thread      thread;
+    std::mutex       mutex;
+    std::deque<Task> tasks;
+
+    std::atomic<U64> task_count = 0, steal_count = 0, busy_ns = 0;
+};
+
+static std::vector<std::unique_ptr<Worker>> workers;
+static std::atomic<unsigned int>            next_worker = 0; // for tasks submitted outside of pool
+
+static std::mutex                  sleep_mutex;
+static std::condition_variable     sleep_cv;
+static std::atomic<std::ptrdiff_t> queued   = 0; // tasks in all deques
+static bool                        stopping = false;
+
+static thread_local Worker* current_worker = nullptr;
+
+static void Push(Task&& task)
+{
+    Worker* worker = current_worker;
+    if (worker == nullptr)
+    {
+        const unsigned int index = next_worker.fetch_add(1, std::memory_order_relaxed);
+        worker                   = workers[index % workers.size()].get();
+    }
+    {
+        const std::lock_guard lock{worker->mutex};
+        worker->tasks.push_back(std::move(task));
+    }
+    {
+        const std::lock_guard lock{sleep_mutex};
+        queued++;
+    }
+    sleep_cv.notify_one();
+}
+
+// own tasks are taken from back, tasks of other workers from front
+static std::optional<Task> Pop(Worker* self)
+{
+    if (self != nullptr)
+    {
+        const std::lock_guard lock{self->mutex};
+        if (!self->tasks.empty())
+        {
+            Task task = std::move(self->tasks.back());
+            self->tasks.pop_back();
+            queued--;
+            return task;
+        }
+    }
+    const std::size_t start = self != nullptr ? self->index + 1 : 0;
+    for (std::size_t i = 0; i < workers.size(); i++)
+    {
+        Worker& victim = *workers[(start + i) % workers.size()];
+        if (&victim == self)
+        {
+            continue;
+        }
+        const std::lock_guard lock{victim.mutex};
+        if (!victim.tasks.empty())
+        {
+            Task task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            if (self != nullptr)
+            {
+                self->steal_count++;
+            }
+            return task;
+        }
+    }
+    return std::nullopt;
+}
+
+static void Execute(Worker* self, const Task& task)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    task();
+    if (self != nullptr)
+    {
+        const auto busy = std::chrono::steady_clock::now() - begin;
+        self->busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count();
+        self->task_count++;
+    }
+}
+
+static void RunWorker(Worker& worker)
+{
+    current_worker = &worker;
+    for (;;)
+    {
+        const std::optional<Task> task = Pop(&worker);
+        if (task)
+        {
+            Execute(&worker, *task);
+            continue;
+        }
+        std::unique_lock lock{sleep_mutex};
+        sleep_cv.wait(lock, [] { return stopping || queued > 0; });
+        if (stopping)
+        {
+            return;
+        }
+    }
+}
+
+void Init(const Options& options)
+{
+    ASSERT(workers.empty());
+    unsigned int worker_count = options.worker_count;
+    if (worker_count == 0)
+    {
+        worker_count = std::max(1U, std::thread::hardware_concurrency());
+    }
+    stopping = false;
+    for (unsigned int i = 0; i < worker_count; i++)
+    {
+        auto worker   = std::make_unique<Worker>();
+        worker->index = i;
+        workers.push_back(std::move(worker));
+    }
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        worker->thread = std::thread{[&worker = *worker] { RunWorker(worker); }};
+        if (options.pin)
+        {
+            os::PinThread(worker->thread, worker->index);
+        }
+    }
+}
+
+void Destroy()
+{
+    ASSERT(queued == 0);
+    {
+        const std::lock_guard lock{sleep_mutex};
+        stopping = true;
+    }
+    sleep_cv.notify_all();
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        worker->thread.join();
+    }
+    workers.clear();
+}
+
+unsigned int GetWorkerCount()
+{
+    return workers.size();
+}
+
+std::vector<WorkerStats> GetStats()
+{
+    std::vector<WorkerStats> stats;
+    stats.reserve(workers.size());
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        stats.push_back({
+            .tasks  = worker->task_count,
+            .steals = worker->steal_count,
+            .busy   = std::chrono::nanoseconds{worker->busy_ns},
+        });
+    }
+    return stats;
+}
+
+TaskGroup::~TaskGroup()
+{
+    Cancel();
+    WaitAll();
+}
+
+void TaskGroup::Submit(Task&& task)
+{
+    {
+        const std::lock_guard lock{mutex_};
+        pending_++;
+    }
+    Push([this, task = std::move(task)] { Run(task); });
+}
+
+void TaskGroup::Cancel()
+{
+    cancelled_ = true;
+}
+
+void TaskGroup::Wait()
+{
+    for (;;)
+    {
+        {
+            const std::lock_guard lock{mutex_};
+            if (pending_ == 0)
+            {
+                break;
+            }
+        }
+        const std::optional<Task> task = Pop(current_worker);
+        if (!task)
+        {
+            WaitAll();
+            break;
+        }
+        Execute(current_worker, *task);
+    }
+    const std::lock_guard lock{mutex_};
+    if (error_)
+    {
+        std::rethrow_exception(error_);
+    }
+}
+
+void TaskGroup::Run(const Task& task)
+{
+    if (!IsCancelled())
+    {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            const std::lock_guard lock{mutex_};
+            if (!error_)
+            {
+                error_ = std::current_exception();
+            }
+            cancelled_ = true;
+        }
+    }
+    // notified under lock, waiting thread may destroy the group as soon as it is released
+    const std::lock_guard lock{mutex_};
+    if (--pending_ == 0)
+    {
+        done_.notify_all();
+    }
+}
+
+void TaskGroup::WaitAll()
+{
+    std::unique_lock lock{mutex_};
+    done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+void ParallelFor(unsigned int count, const std::function<void(unsigned int)>& task)
+{
+    if (count == 1)
+    {
+        task(0);
+        return;
+    }
+    TaskGroup tasks;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        tasks.Submit([&task, i] { task(i); });
+    }
+    tasks.Wait();
+}
+} // namespace scheduler
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Pool of worker threads shared by all parallel operators. Each worker has its own deque of tasks,
+// it runs its newest tasks first and steals the oldest tasks of other workers when it runs out.
+namespace scheduler
+{
+struct Options
+{
+    unsigned int worker_count = 0;     // hardware concurrency if zero
+    bool         pin          = false; // pins each worker to one cpu
+};
+
+struct WorkerStats
+{
+    U64                      tasks  = 0;
+    U64                      steals = 0; // tasks taken from deques of other workers
+    std::chrono::nanoseconds busy{};
+};
+
+void Init(const Options& options);
+void Destroy(); // all task groups must be finished
+
+[[nodiscard]] unsigned int             GetWorkerCount();
+[[nodiscard]] std::vector<WorkerStats> GetStats();
+
+using Task = std::function<void()>;
+
+// Tasks of one operator. If a task throws, the group is cancelled: tasks which have not started
+// yet are skipped and running tasks should check IsCancelled() regularly. Destroying the group
+// cancels it and waits for running tasks, so that operators can be closed early.
+class TaskGroup
+{
+public:
+    TaskGroup() = default;
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&)            = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    TaskGroup(TaskGroup&&)                 = delete;
+    TaskGroup& operator=(TaskGroup&&)      = delete;
+
+    void Submit(Task&& task);
+    void Cancel();
+
+    [[nodiscard]] bool IsCancelled() const
+    {
+        return cancelled_.load(std::memory_order_relaxed);
+    }
+
+    // runs queued tasks while waiting, rethrows the first exception thrown by a task
+    void Wait();
+
+private:
+    void Run(const Task& task);
+    void WaitAll();
+
+    std::atomic<bool>       cancelled_ = false;
+    std::mutex              mutex_;
+    std::condition_variable done_;
+    unsigned int            pending_ = 0;
+    std::exception_ptr      error_;
+};
+
+// runs task for each index from 0 to count and waits, calling thread runs it alone if count is 1
+void ParallelFor(unsigned int count, const std::function<void(unsigned int)>& task);
+} // namespace scheduler
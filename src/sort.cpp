@@ -2,184 +2,86 @@
 #include "buffer.hpp"
 #include "common.hpp"
 #include "iter.hpp"
+#include "loser_tree.hpp"
 #include "os.hpp"
 #include "page.hpp"
+#include "parallel.hpp"
 #include "row.hpp"
+#include "scheduler.hpp"
+#include "temp.hpp"
 #include "type.hpp"
 #include "value.hpp"
 
 #include <algorithm>
-#include <array>
+#include <cstddef>
 #include <cstring>
-#include <iterator>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
+#include <vector>
 
 // TODO: should temp files use buffer?
-// TODO: don't create temp files for small sorts (like column lookup)
 
 // K-way merge sort
 
-static constexpr unsigned int kKWay = 2; // TODO
+// each input of a merge and its output use one page of work memory, tasks merge at the same time
+static std::size_t GetFanIn(unsigned int task_count)
+{
+    return std::max<std::size_t>(2, (temp::kWorkMemory / page::kSize / task_count) - 1);
+}
 
-static bool CompareRows(const Type& type, const OrderBy& order_by, const U8* row_l, const U8* row_r)
+static void EncodeKey(const Type& type, const OrderBy& order_by, const U8* row,
+                      std::vector<U8>& key)
 {
-    if (row_r == nullptr)
-    {
-        return true;
-    }
-    if (row_l == nullptr)
-    {
-        return false;
-    }
     for (const OrderBy::Column& column : order_by.columns)
     {
-        const int result = row::Compare(type, column.column_id, row_l, row_r);
-        if (result < 0)
-        {
-            return column.asc;
-        }
-        if (result > 0)
-        {
-            return !column.asc;
-        }
+        row::AppendKey(type, column.column_id, column.asc, row, key);
     }
-    return true;
 }
 
-static void SortPage(const Type& type, const OrderBy& order_by, page::Slotted<>* page)
+// first bytes of key as big-endian integer, shorter keys are padded with zeros
+static U64 GetKeyPrefix(const U8* key, std::size_t size)
 {
-    // TODO: pipeline does not emit clang-tidy warning for ranges modernize
-    std::sort(page->Begin(), page->End(),
-              [&type, &order_by, page](const page::Slotted<>::Slot& slot_l,
-                                       const page::Slotted<>::Slot& slot_r)
-              {
-                  const U8* entry_l = page->GetEntry(slot_l);
-                  const U8* entry_r = page->GetEntry(slot_r);
-                  return CompareRows(type, order_by, entry_l, entry_r);
-              });
-}
-
-static std::optional<unsigned int> NextInput(const Type& type, const OrderBy& order_by,
-                                             const std::array<const U8*, kKWay>& rows)
-{
-    const auto compare = [&type, &order_by](const U8* row_l, const U8* row_r)
-    { return CompareRows(type, order_by, row_l, row_r); };
-    const auto* iter = std::ranges::min_element(rows, compare);
-    if (*iter == nullptr)
+    U64 prefix = 0;
+    for (std::size_t i = 0; i < sizeof(U64); i++)
     {
-        return std::nullopt;
+        prefix = (prefix << 8U) | (i < size ? key[i] : 0U);
     }
-    return static_cast<unsigned int>(std::distance(rows.begin(), iter));
+    return prefix;
 }
 
-class Input
+static bool IsLess(U64 prefix_l, const U8* key_l, std::size_t size_l, U64 prefix_r, const U8* key_r,
+                   std::size_t size_r)
 {
-public:
-    void Init(const os::TempFile& file, page::Id page_begin, page::Id page_end)
-    {
-        this->file_       = &file;
-        this->page_begin_ = page_begin;
-        this->page_end_   = page_end;
-
-        page_id_  = page_begin;
-        entry_id_ = page::EntryId{};
-    }
-
-    const U8* Next(page::Offset& size)
+    if (prefix_l != prefix_r)
     {
-        for (;;)
-        {
-            if (entry_id_ == 0)
-            {
-                if (page_id_ == page_end_)
-                {
-                    return nullptr;
-                }
-                file_->Read(page_id_, page_.Get());
-            }
-            if (entry_id_ == page_->GetEntryCount())
-            {
-                page_id_++;
-                entry_id_ = page::EntryId{};
-                continue;
-            }
-            const U8* const entry = page_->GetEntry(entry_id_++, size);
-            if (entry == nullptr)
-            {
-                continue;
-            }
-            return entry;
-        }
+        return prefix_l < prefix_r;
     }
+    const int result = std::memcmp(key_l, key_r, std::min(size_l, size_r));
+    return result < 0 || (result == 0 && size_l < size_r);
+}
 
-private:
-    buffer::Buffer<page::Slotted<>> page_;
-
-    const os::TempFile* file_;
-    page::Id            page_begin_, page_end_;
-
-    page::Id      page_id_;
-    page::EntryId entry_id_;
-};
-
-class Output
+void SortKey::Encode(const Type& type, const OrderBy& order_by, const U8* row)
 {
-public:
-    explicit Output(const os::TempFile& file) : file_{file}, page_id_{}, page_id_begin_{}
-    {
-        page_->Init({});
-    }
-
-    void Append(const U8* row, page::Offset align, page::Offset size)
-    {
-        for (;;)
-        {
-            U8* const entry = page_->Insert(align, size, {});
-            if (entry == nullptr)
-            {
-                Write();
-                continue;
-            }
-            std::memcpy(entry, row, size);
-            break;
-        }
-    }
-
-    std::pair<page::Id, page::Id> EndSection()
-    {
-        Write();
-        const page::Id begin = page_id_begin_;
-        const page::Id end   = page_id_;
-        page_id_begin_       = page_id_;
-        return {begin, end};
-    }
-
-private:
-    void Write()
-    {
-        if (page_->GetEntryCount() > 0)
-        {
-            file_.Write(page_id_++, page_.Get());
-        }
-        page_->Init({});
-    }
+    bytes.clear();
+    EncodeKey(type, order_by, row, bytes);
+    prefix = GetKeyPrefix(bytes.data(), bytes.size());
+}
 
-    const os::TempFile& file_; // NOLINT(cppcoreguidelines-avoid-const-or-ref-data-members)
-    page::Id            page_id_, page_id_begin_;
-    buffer::Buffer<page::Slotted<>> page_;
-};
+bool SortKey::operator<(const SortKey& other) const
+{
+    return IsLess(prefix, bytes.data(), bytes.size(), other.prefix, other.bytes.data(),
+                  other.bytes.size());
+}
 
-// stores sections of data file, which will be merged together
+// stores sections of temporary files, which will be merged together
 // needed because variable-length rows
 class SectionQueue
 {
 public:
-    struct Section
-    {
-        page::Id begin, end;
-    };
+    using Section = SortSection;
 
     [[nodiscard]] page::Id GetSize() const
     {
@@ -239,166 +141,643 @@ private:
     buffer::Buffer<Section> buffer_r_, buffer_w_;
 };
 
-static os::TempFile MergeSortedPages(const Type& type, const OrderBy& order_by, os::TempFile file,
-                                     page::Id& page_count_out)
+SortRun::SortRun(unsigned int page_count)
+    : pages_{buffer::FrameId{page_count}}, page_count_{page_count}
 {
-    os::TempFile file_src = std::move(file);
-    os::TempFile file_dst;
+    ASSERT(page_count_ > 0);
+    Clear();
+}
 
-    SectionQueue queue;
-    for (page::Id page_id{}; page_id < page_count_out; page_id++)
+bool SortRun::Insert(const Value& value, page::Offset align)
+{
+    const row::Prefix prefix = row::CalculateLayout(value);
+    for (;;)
     {
-        queue.Push({.begin = page_id, .end = page_id + 1});
+        U8* const entry = GetPage(page_index_)->Insert(align, prefix.size, {});
+        if (entry != nullptr)
+        {
+            row::Write(prefix, value, entry);
+            entries_.push_back({.row = entry, .size = prefix.size, .key_prefix = 0, .key_offset = 0,
+                                .key_size = 0});
+            return true;
+        }
+        if (page_index_ + 1 == page_count_)
+        {
+            return false;
+        }
+        GetPage(++page_index_)->Init({});
     }
-    queue.Flush();
+}
+
+void SortRun::Sort(const Type& type, const OrderBy& order_by)
+{
+    keys_.clear();
+    for (Entry& entry : entries_)
+    {
+        entry.key_offset = keys_.size();
+        EncodeKey(type, order_by, entry.row, keys_);
+        entry.key_size   = keys_.size() - entry.key_offset;
+        entry.key_prefix = GetKeyPrefix(keys_.data() + entry.key_offset, entry.key_size);
+    }
+    std::ranges::sort(entries_,
+                      [keys = keys_.data()](const Entry& entry_l, const Entry& entry_r)
+                      {
+                          return IsLess(entry_l.key_prefix, keys + entry_l.key_offset,
+                                        entry_l.key_size, entry_r.key_prefix,
+                                        keys + entry_r.key_offset, entry_r.key_size);
+                      });
+}
 
-    std::array<Input, kKWay>        inputs;
-    std::array<const U8*, kKWay>    rows;
-    std::array<page::Offset, kKWay> sizes;
+void SortRun::Clear()
+{
+    page_index_ = 0;
+    GetPage(page_index_)->Init({});
+    entries_.clear();
+    keys_.clear();
+}
 
-    const page::Offset align = type.GetAlign();
+page::Slotted<>* SortRun::GetPage(unsigned int page_index)
+{
+    return static_cast<page::Slotted<>*>(pages_.GetFrame(buffer::FrameId{page_index}));
+}
+
+// Rows are collected in runs of work memory, full runs are sorted and written to temporary files.
+// If there are more workers, work memory is split between two runs, so that one of them is filled
+// while the other is written by task. Temporary files are created only when the first run is full.
+class RunWriter
+{
+public:
+    RunWriter(const Type& type, const OrderBy& order_by, std::vector<os::TempFile>& files)
+        : type_{type}, order_by_{order_by}, align_{type.GetAlign()}, files_{files}
+    {
+        const unsigned int slot_count = scheduler::GetWorkerCount() > 1 ? 2 : 1;
+        const unsigned int page_count = temp::kWorkMemory / page::kSize / slot_count;
+        for (unsigned int i = 0; i < slot_count; i++)
+        {
+            slots_.push_back(std::make_unique<Slot>(page_count));
+        }
+    }
+
+    void Append(const Value& value)
+    {
+        if (slots_[slot_]->run.Insert(value, align_))
+        {
+            return;
+        }
+        Flush();
+        const bool inserted = slots_[slot_]->run.Insert(value, align_);
+        ASSERT(inserted);
+    }
 
-    while (queue.GetSize() > 1)
+    [[nodiscard]] bool IsInMemory() const
     {
+        return files_.empty();
+    }
 
-        Output output{file_dst};
+    // if all rows fit in memory
+    [[nodiscard]] SortRun TakeRun()
+    {
+        ASSERT(IsInMemory());
+        SortRun& run = slots_[slot_]->run;
+        run.Sort(type_, order_by_);
+        return std::move(run);
+    }
 
-        const page::Id merges    = queue.GetSize() / kKWay;
-        const page::Id remainder = queue.GetSize() % kKWay;
+    // returns written runs
+    [[nodiscard]] std::vector<SortSection> Finish()
+    {
+        if (!slots_[slot_]->run.GetEntries().empty())
+        {
+            Flush();
+        }
+        for (const std::unique_ptr<Slot>& slot : slots_)
+        {
+            Complete(*slot);
+        }
+        return std::move(sections_);
+    }
 
-        for (page::Id i{}; i < merges; i++)
+private:
+    struct Slot
+    {
+        explicit Slot(unsigned int page_count) : run{page_count}
         {
+        }
 
-            for (page::Id k{}; k < kKWay; k++)
-            {
-                const auto [begin, end] = queue.Pop();
-                inputs[k.Get()].Init(file_src, begin, end);
-                rows[k.Get()] = inputs[k.Get()].Next(sizes[k.Get()]);
-            }
+        SortRun                             run;
+        std::optional<temp::Output>         output;
+        std::optional<scheduler::TaskGroup> tasks;
+        SortSection                         section{};
+        bool                                pending = false; // section is not collected yet
+    };
 
-            std::optional<unsigned int> input_k = NextInput(type, order_by, rows);
-            while (input_k)
+    void Flush()
+    {
+        if (files_.empty())
+        {
+            files_.resize(slots_.size());
+            for (unsigned int i = 0; i < slots_.size(); i++)
             {
-                const unsigned int k = *input_k;
-                output.Append(rows[k], align, sizes[k]);
-                rows[k] = inputs[k].Next(sizes[k]);
-                input_k = NextInput(type, order_by, rows);
+                slots_[i]->output.emplace(files_[i]);
             }
+        }
+
+        Slot&              slot = *slots_[slot_];
+        const unsigned int file = slot_;
+        slot.pending            = true;
+        if (slots_.size() == 1)
+        {
+            Write(slot, file);
+        }
+        else
+        {
+            slot.tasks.emplace().Submit([this, &slot, file] { Write(slot, file); });
+        }
 
-            const auto [begin, end] = output.EndSection();
-            queue.Push({.begin = begin, .end = end});
+        // the next run is reused once it is written
+        slot_ = (slot_ + 1) % slots_.size();
+        Complete(*slots_[slot_]);
+    }
+
+    // may run in worker thread
+    void Write(Slot& slot, unsigned int file) const
+    {
+        slot.run.Sort(type_, order_by_);
+        for (const SortRun::Entry& entry : slot.run.GetEntries())
+        {
+            slot.output->Append(entry.row, align_, entry.size);
+        }
+        const auto [begin, end] = slot.output->EndSection();
+        slot.section            = {.file = file, .begin = begin, .end = end};
+        slot.run.Clear();
+    }
+
+    void Complete(Slot& slot)
+    {
+        if (slot.tasks)
+        {
+            slot.tasks->Wait();
+            slot.tasks.reset();
         }
+        if (slot.pending)
+        {
+            sections_.push_back(slot.section);
+            slot.pending = false;
+        }
+    }
+
+    const Type&        type_;     // NOLINT(cppcoreguidelines-avoid-const-or-ref-data-members)
+    const OrderBy&     order_by_; // NOLINT(cppcoreguidelines-avoid-const-or-ref-data-members)
+    const page::Offset align_;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-const-or-ref-data-members)
+    std::vector<os::TempFile>& files_;
+
+    std::vector<std::unique_ptr<Slot>> slots_;
+    unsigned int                       slot_ = 0; // being filled
+    std::vector<SortSection>           sections_;
+};
+
+// merges rows of inputs to output, returns the written section
+static SortSection Merge(const Type& type, const OrderBy& order_by,
+                         std::vector<temp::Input>& inputs, std::size_t input_count,
+                         temp::Output& output, unsigned int file)
+{
+    std::vector<const U8*>    rows(input_count);
+    std::vector<page::Offset> sizes(input_count);
+    std::vector<SortKey>      keys(input_count);
 
-        if (remainder > 0)
+    // key of each row is encoded once, when it becomes the current row of its input
+    const auto next = [&](std::size_t k)
+    {
+        rows[k] = inputs[k].Next(sizes[k]);
+        if (rows[k] != nullptr)
         {
+            keys[k].Encode(type, order_by, rows[k]);
+        }
+    };
+    for (std::size_t k = 0; k < input_count; k++)
+    {
+        next(k);
+    }
 
-            for (page::Id k{}; k < remainder; k++)
+    const page::Offset align = type.GetAlign();
+
+    // exhausted inputs are greater than all others
+    LoserTree tree{input_count, [&rows, &keys](std::size_t k_l, std::size_t k_r)
+                   {
+                       return rows[k_l] != nullptr &&
+                              (rows[k_r] == nullptr || keys[k_l] < keys[k_r]);
+                   }};
+    for (;;)
+    {
+        const std::size_t k = tree.GetWinner();
+        if (rows[k] == nullptr)
+        {
+            break;
+        }
+        output.Append(rows[k], align, sizes[k]);
+        next(k);
+        tree.Update();
+    }
+
+    const auto [begin, end] = output.EndSection();
+    return {.file = file, .begin = begin, .end = end};
+}
+
+// position of the first row of section which is not less than key
+static temp::Position LowerBound(const Type& type, const OrderBy& order_by,
+                                 const os::TempFile& file, const SortSection& section,
+                                 const SortKey& key, page::Slotted<>* page)
+{
+    SortKey row_key;
+
+    // last rows of pages are ordered, finds the first page whose last row is not less than key
+    page::Id begin = section.begin;
+    page::Id end   = section.end;
+    while (begin < end)
+    {
+        const page::Id middle = begin + ((end - begin).Get() / 2);
+        file.Read(middle, page);
+        row_key.Encode(type, order_by, page->GetEntry(page->GetEntryCount() - 1));
+        if (row_key < key)
+        {
+            begin = middle + 1;
+        }
+        else
+        {
+            end = middle;
+        }
+    }
+    if (begin == section.end)
+    {
+        return {.page_id = section.end, .entry_id = {}};
+    }
+    file.Read(begin, page);
+    page::EntryId entry_id{};
+    for (;; entry_id++)
+    {
+        row_key.Encode(type, order_by, page->GetEntry(entry_id));
+        if (!(row_key < key))
+        {
+            break;
+        }
+    }
+    return {.page_id = begin, .entry_id = entry_id};
+}
+
+// keys which split runs to parts of about the same size, sampled from evenly spaced pages
+static std::vector<SortKey> SampleSplitters(const Type& type, const OrderBy& order_by,
+                                            const std::vector<os::TempFile>& files,
+                                            const std::vector<SortSection>& runs,
+                                            unsigned int part_count)
+{
+    static constexpr unsigned int kSamplesPerPart = 8;
+
+    if (part_count == 1)
+    {
+        return {};
+    }
+
+    page::Id::Type page_count = 0;
+    for (const SortSection& run : runs)
+    {
+        page_count += (run.end - run.begin).Get();
+    }
+    const page::Id::Type stride = std::max(1U, page_count / (part_count * kSamplesPerPart));
+
+    const buffer::Buffer<page::Slotted<>> page;
+    std::vector<SortKey>                  samples;
+    for (const SortSection& run : runs)
+    {
+        for (page::Id page_id = run.begin; page_id < run.end; page_id = page_id + stride)
+        {
+            files[run.file].Read(page_id, page.Get());
+            samples.emplace_back().Encode(type, order_by, page->GetEntry(page::EntryId{}));
+        }
+    }
+    std::ranges::sort(samples, std::less{});
+
+    std::vector<SortKey> splitters;
+    for (unsigned int part = 1; part < part_count; part++)
+    {
+        splitters.push_back(samples[samples.size() * part / part_count]);
+    }
+    return splitters;
+}
+
+// Rows of the last merge are split between tasks by key. Each task merges rows between two
+// splitters, whose positions in runs are found by binary search, and writes them to its own file.
+static std::vector<SortSection> MergeLast(const Type& type, const OrderBy& order_by,
+                                          std::vector<os::TempFile>& files,
+                                          const std::vector<SortSection>& runs,
+                                          unsigned int part_count)
+{
+    const std::vector<SortKey> splitters = SampleSplitters(type, order_by, files, runs, part_count);
+
+    std::vector<os::TempFile> files_dst(part_count);
+    std::vector<SortSection>  sections(part_count);
+    scheduler::ParallelFor(
+        part_count,
+        [&type, &order_by, &files, &runs, part_count, &splitters, &files_dst,
+         &sections](unsigned int part)
+        {
+            const buffer::Buffer<page::Slotted<>> page;
+            std::vector<temp::Input>              inputs(runs.size());
+            for (std::size_t k = 0; k < runs.size(); k++)
             {
-                const auto [begin, end] = queue.Pop();
-                inputs[k.Get()].Init(file_src, begin, end);
-                rows[k.Get()] = inputs[k.Get()].Next(sizes[k.Get()]);
+                const SortSection&   run   = runs[k];
+                const os::TempFile&  file  = files[run.file];
+                const temp::Position begin = part == 0 ? temp::Position{run.begin, {}}
+                                                       : LowerBound(type, order_by, file, run,
+                                                                    splitters[part - 1],
+                                                                    page.Get());
+                const temp::Position end   = part == part_count - 1
+                                                 ? temp::Position{run.end, {}}
+                                                 : LowerBound(type, order_by, file, run,
+                                                              splitters[part], page.Get());
+                inputs[k].Init(file, begin, end);
             }
+            temp::Output output{files_dst[part]};
+            sections[part] = Merge(type, order_by, inputs, runs.size(), output, part);
+        });
+
+    files = std::move(files_dst);
+    return sections;
+}
+
+// Merges of one pass are independent, they are split between tasks, each of which writes to its
+// own file. Sections are popped in batches, because there may be too many to keep in memory.
+static std::vector<SortSection> MergeRuns(const Type& type, const OrderBy& order_by,
+                                          std::vector<os::TempFile>& files,
+                                          const std::vector<SortSection>& runs)
+{
+    static constexpr std::size_t kMergesPerTask = 64; // in one batch
+
+    page::Id     page_count{};
+    SectionQueue queue;
+    for (const SortSection& run : runs)
+    {
+        page_count = page_count + (run.end - run.begin);
+        queue.Push(run);
+    }
+    queue.Flush();
+
+    const unsigned int task_count = parallel::GetWorkerCount(page_count);
+    const std::size_t  fan_in     = GetFanIn(task_count);
 
-            std::optional<unsigned int> input_k = NextInput(type, order_by, rows);
-            while (input_k)
+    while (queue.GetSize() > fan_in)
+    {
+        std::vector<os::TempFile> files_dst(task_count);
+        std::vector<temp::Output> outputs;
+        outputs.reserve(task_count);
+        for (const os::TempFile& file : files_dst)
+        {
+            outputs.emplace_back(file);
+        }
+
+        page::Id remaining = queue.GetSize();
+        while (remaining > 0)
+        {
+            std::vector<std::vector<SortSection>> merges;
+            while (remaining > 0 && merges.size() < task_count * kMergesPerTask)
             {
-                const unsigned int k = *input_k;
-                ASSERT(k < remainder.Get()); // TODO: id / int
-                output.Append(rows[k], align, sizes[k]);
-                rows[k] = inputs[k].Next(sizes[k]);
-                input_k = NextInput(type, order_by, rows);
+                std::vector<SortSection>& merge = merges.emplace_back();
+                for (std::size_t k = 0; k < fan_in && remaining > 0; k++)
+                {
+                    merge.push_back(queue.Pop());
+                    remaining--;
+                }
             }
 
-            const auto [begin, end] = output.EndSection();
-            queue.Push({.begin = begin, .end = end});
+            std::vector<SortSection> sections(merges.size());
+            scheduler::ParallelFor(
+                task_count,
+                [&type, &order_by, &files, &merges, &sections, &outputs, task_count,
+                 fan_in](unsigned int task)
+                {
+                    std::vector<temp::Input> inputs(fan_in);
+                    for (std::size_t i = task; i < merges.size(); i += task_count)
+                    {
+                        const std::vector<SortSection>& merge = merges[i];
+                        for (std::size_t k = 0; k < merge.size(); k++)
+                        {
+                            inputs[k].Init(files[merge[k].file], merge[k].begin, merge[k].end);
+                        }
+                        sections[i] =
+                            Merge(type, order_by, inputs, merge.size(), outputs[task], task);
+                    }
+                });
+            for (const SortSection& section : sections)
+            {
+                queue.Push(section);
+            }
         }
 
         queue.Flush();
+        files = std::move(files_dst);
+        temp::OnMergePass();
+    }
 
-        std::swap(file_src, file_dst);
+    std::vector<SortSection> runs_last;
+    while (queue.GetSize() > 0)
+    {
+        runs_last.push_back(queue.Pop());
+    }
+    if (runs_last.size() <= 1)
+    {
+        return runs_last;
     }
+    temp::OnMergePass();
+    return MergeLast(type, order_by, files, runs_last, task_count);
+}
 
-    ASSERT(queue.GetSize() == 1);
-    const auto [begin, end] = queue.Pop();
-    ASSERT(begin == 0);
+void IterSort::Open()
+{
+    ASSERT(parent_);
 
-    page_count_out = end;
-    return file_src;
+    // TODO: if parent is materialized, simply copy and sort pages
+
+    parent_->Open();
+    Sort({});
 }
 
-static os::TempFile MergeSort(Iter iter, const OrderBy& order_by, page::Id& page_count_out)
+void IterSort::Sort(const std::vector<Value>& values)
 {
-    os::TempFile file;
+    RunWriter writer{type, columns_, files_};
+    for (const Value& value : values)
+    {
+        writer.Append(value);
+    }
+    for (;;)
+    {
+        std::optional<Value> value = parent_->Next();
+        if (!value)
+        {
+            break;
+        }
+        writer.Append(*value);
+    }
+    parent_->Close();
 
-    // TODO: if parent is materialized, simply copy and sort pages
+    if (writer.IsInMemory())
+    {
+        run_.emplace(writer.TakeRun());
+    }
+    else
+    {
+        sections_ = MergeRuns(type, columns_, files_, writer.Finish());
+    }
+    Restart();
+}
 
-    page::Id                              page_id = page::Id{};
-    const buffer::Buffer<page::Slotted<>> page;
-    page->Init({});
+void IterSort::Restart()
+{
+    entry_index_   = 0;
+    section_index_ = 0;
+    if (!sections_.empty())
+    {
+        const SortSection& section = sections_.front();
+        input_.Init(files_[section.file], section.begin, section.end);
+    }
+}
 
-    const Type&        type  = iter->type;
-    const page::Offset align = type.GetAlign();
+void IterSort::Close()
+{
+    // released, since plan may be opened again
+    run_.reset();
+    sections_.clear();
+    files_.clear();
+}
 
-    iter->Open();
-    for (;;)
+std::optional<Value> IterSort::Next()
+{
+    if (run_)
     {
-        std::optional<Value> value = iter->Next();
+        const std::vector<SortRun::Entry>& entries = run_->GetEntries();
+        if (entry_index_ == entries.size())
+        {
+            return std::nullopt;
+        }
+        return row::Read(type, entries[entry_index_++].row);
+    }
+    while (section_index_ < sections_.size())
+    {
+        page::Offset    size = 0;
+        const U8* const row  = input_.Next(size);
+        if (row != nullptr)
+        {
+            return row::Read(type, row);
+        }
+        if (++section_index_ < sections_.size())
+        {
+            const SortSection& section = sections_[section_index_];
+            input_.Init(files_[section.file], section.begin, section.end);
+        }
+    }
+    return std::nullopt;
+}
+
+std::string IterSort::GetName() const
+{
+    return "Sort";
+}
+
+std::vector<Iter*> IterSort::GetInputs()
+{
+    return {&parent_};
+}
+
+void IterTopN::Open()
+{
+    ASSERT(parent_);
+    parent_->Open();
+
+    const auto less = [](const Entry& entry_l, const Entry& entry_r)
+    { return entry_l.key < entry_r.key; };
+
+    // buffers of dropped rows are reused
+    Entry       entry;
+    std::size_t size = 0; // of rows and keys in heap
+    while (limit_ > 0)
+    {
+        std::optional<Value> value = parent_->Next();
         if (!value)
         {
             break;
         }
         const row::Prefix prefix = row::CalculateLayout(*value);
+        entry.row.resize(prefix.size);
+        row::Write(prefix, *value, entry.row.data());
+        entry.key.Encode(type, columns_, entry.row.data());
 
-        for (;;)
+        if (heap_.size() < limit_)
         {
-            U8* const entry = page->Insert(align, prefix.size, {});
-            if (entry == nullptr)
+            size += entry.row.size() + entry.key.bytes.size();
+            heap_.push_back(std::exchange(entry, {}));
+            std::ranges::push_heap(heap_, less);
+        }
+        else if (entry.key < heap_.front().key)
+        {
+            std::ranges::pop_heap(heap_, less);
+            size -= heap_.back().row.size() + heap_.back().key.bytes.size();
+            size += entry.row.size() + entry.key.bytes.size();
+            std::swap(heap_.back(), entry);
+            std::ranges::push_heap(heap_, less);
+        }
+
+        if (size > temp::kWorkMemory)
+        {
+            std::vector<Value> values;
+            values.reserve(heap_.size());
+            for (const Entry& heap_entry : heap_)
             {
-                SortPage(type, order_by, page.Get());
-                file.Write(page_id++, page.Get());
-                page->Init({});
-                continue;
+                values.push_back(row::Read(type, heap_entry.row.data()));
             }
-            row::Write(prefix, *value, entry);
-            break;
+            heap_.clear();
+            sorted_all_ = true;
+            Sort(values);
+            return;
         }
     }
-    iter->Close();
-
-    if (page->GetEntryCount() > 0)
-    {
-        SortPage(type, order_by, page.Get());
-        file.Write(page_id++, page.Get());
-    }
+    parent_->Close();
 
-    page_count_out = page_id;
-    return MergeSortedPages(type, order_by, std::move(file), page_count_out);
+    std::ranges::sort_heap(heap_, less);
+    Restart();
 }
 
-void IterSort::Open()
+void IterTopN::Restart()
 {
-    // puts("SORTING");
-    ASSERT(!sorted_iter_);
-    page::Id     page_count;
-    os::TempFile file       = MergeSort(std::move(parent_), columns_, page_count);
-    Type         type_clone = type; // TODO
-    sorted_iter_ =
-        std::make_unique<IterScanTemp>(std::move(file), page_count, std::move(type_clone));
-    sorted_iter_->Open();
+    row_index_ = 0;
+    IterSort::Restart();
 }
 
-void IterSort::Restart()
+void IterTopN::Close()
 {
-    ASSERT(sorted_iter_);
-    sorted_iter_->Restart();
+    heap_.clear();
+    sorted_all_ = false;
+    IterSort::Close();
 }
 
-void IterSort::Close()
+std::optional<Value> IterTopN::Next()
 {
-    sorted_iter_->Close();
+    if (row_index_ == limit_)
+    {
+        return std::nullopt;
+    }
+    if (sorted_all_)
+    {
+        row_index_++;
+        return IterSort::Next();
+    }
+    if (row_index_ == heap_.size())
+    {
+        return std::nullopt;
+    }
+    return row::Read(type, heap_[row_index_++].row.data());
 }
 
-std::optional<Value> IterSort::Next()
+std::string IterTopN::GetName() const
 {
-    return sorted_iter_->Next();
+    return "Top-N Sort (limit " + std::to_string(limit_) + ")";
 }
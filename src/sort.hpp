@@ -1,10 +1,18 @@
 #pragma once
 
+#include "buffer.hpp"
 #include "common.hpp"
 #include "iter.hpp"
+#include "os.hpp"
+#include "page.hpp"
+#include "temp.hpp"
+#include "type.hpp"
+#include "value.hpp"
 
+#include <cstddef>
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -18,6 +26,63 @@ struct OrderBy
     std::vector<Column> columns;
 };
 
+// Key of row encoded so that keys compare by memcmp in sort order, its first bytes are also kept as
+// integer. Used for rows which are compared many times.
+struct SortKey
+{
+    U64             prefix = 0;
+    std::vector<U8> bytes;
+
+    void Encode(const Type& type, const OrderBy& order_by, const U8* row);
+
+    [[nodiscard]] bool operator<(const SortKey& other) const;
+};
+
+// range of pages in one of temporary files of sort
+struct SortSection
+{
+    unsigned int file;
+    page::Id     begin, end;
+};
+
+// Rows of one run are kept in pages in memory, they are sorted through an array of pointers, so
+// that rows are not moved. Keys of rows are encoded once before sorting, entries keep their first
+// bytes as integer, so that most comparisons don't read the keys.
+class SortRun
+{
+public:
+    struct Entry
+    {
+        const U8*    row;
+        page::Offset size;
+        U64          key_prefix;
+        std::size_t  key_offset;
+        std::size_t  key_size;
+    };
+
+    explicit SortRun(unsigned int page_count);
+
+    [[nodiscard]] bool Insert(const Value& value, page::Offset align); // false if run is full
+    void               Sort(const Type& type, const OrderBy& order_by);
+    void               Clear();
+
+    [[nodiscard]] const std::vector<Entry>& GetEntries() const
+    {
+        return entries_;
+    }
+
+private:
+    page::Slotted<>* GetPage(unsigned int page_index);
+
+    buffer::Buffer<>   pages_;
+    const unsigned int page_count_;
+    unsigned int       page_index_ = 0; // page being filled
+    std::vector<Entry> entries_;
+    std::vector<U8>    keys_;
+};
+
+// Rows are sorted in runs which fit in work memory. If all rows fit in one run, they are read from
+// memory, otherwise runs are written to temporary files and merged.
 class IterSort : public IterBase
 {
 public:
@@ -31,10 +96,55 @@ public:
     void                 Restart() override;
     void                 Close() override;
     std::optional<Value> Next() override;
+    std::string          GetName() const override;
+    std::vector<Iter*>   GetInputs() override;
+
+protected:
+    // sorts given rows and the remaining rows of opened parent
+    void Sort(const std::vector<Value>& values);
 
-private:
     Iter          parent_;
     const OrderBy columns_;
 
-    Iter sorted_iter_;
+private:
+    std::optional<SortRun> run_; // if all rows fit in memory
+    std::size_t            entry_index_ = 0;
+
+    // otherwise sorted rows are read from sections in order
+    std::vector<os::TempFile> files_;
+    std::vector<SortSection>  sections_;
+    std::size_t               section_index_ = 0;
+    temp::Input               input_;
+};
+
+// First rows of sort order. They are kept in a heap, whose greatest row is replaced by each lower
+// row, so that other rows are dropped without sorting. If the heap does not fit in work memory,
+// all rows are sorted instead.
+class IterTopN : public IterSort
+{
+public:
+    IterTopN(Iter parent, OrderBy columns, unsigned int limit)
+        : IterSort{std::move(parent), std::move(columns)}, limit_{limit}
+    {
+    }
+    ~IterTopN() override = default;
+
+    void                 Open() override;
+    void                 Restart() override;
+    void                 Close() override;
+    std::optional<Value> Next() override;
+    std::string          GetName() const override;
+
+private:
+    struct Entry
+    {
+        SortKey         key;
+        std::vector<U8> row;
+    };
+
+    const unsigned int limit_;
+
+    std::vector<Entry> heap_; // sorted once parent is read
+    bool               sorted_all_ = false;
+    std::size_t        row_index_  = 0;
 };
@@ -0,0 +1,337 @@
+#include "statistics.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace statistics
+{
+static constexpr U64 kRandomSeed = 0x2545F4914F6CDD1DULL; // results do not change between runs
+
+// spreads bits of hash (finalizer of MurmurHash3), registers are selected by its high bits
+static U64 MixBits(U64 bits)
+{
+    static constexpr U64 kMultiplier1 = 0xFF51AFD7ED558CCDULL;
+    static constexpr U64 kMultiplier2 = 0xC4CEB9FE1A85EC53ULL;
+    static constexpr U64 kShift       = 33;
+    bits ^= bits >> kShift;
+    bits *= kMultiplier1;
+    bits ^= bits >> kShift;
+    bits *= kMultiplier2;
+    bits ^= bits >> kShift;
+    return bits;
+}
+
+void HyperLogLog::Add(std::size_t hash)
+{
+    static constexpr int kRankMax = 64 - kPrecision + 1;
+
+    // register is selected by high bits, it keeps the maximum position of the first one bit
+    // of the other bits
+    const U64         bits  = MixBits(hash);
+    const std::size_t index = bits >> (64 - kPrecision);
+    const int         rank  = std::min(std::countl_zero(bits << kPrecision) + 1, kRankMax);
+    registers_[index]       = std::max(registers_[index], static_cast<U8>(rank));
+}
+
+double HyperLogLog::Estimate() const
+{
+    static constexpr auto   kRegisterCount = static_cast<double>(std::size_t{1} << kPrecision);
+    static constexpr double kAlpha         = 0.7213 / (1 + (1.079 / kRegisterCount));
+    static constexpr double kSmallRange    = 2.5 * kRegisterCount;
+
+    double      sum        = 0;
+    std::size_t zero_count = 0;
+    for (const U8 rank : registers_)
+    {
+        sum += std::ldexp(1.0, -rank);
+        zero_count += rank == 0 ? 1 : 0;
+    }
+    const double estimate = kAlpha * kRegisterCount * kRegisterCount / sum;
+    if (estimate <= kSmallRange && zero_count > 0)
+    {
+        // linear counting is more precise for small counts
+        return kRegisterCount * std::log(kRegisterCount / static_cast<double>(zero_count));
+    }
+    return estimate;
+}
+
+std::vector<page::Id> SamplePages(page::Id page_count)
+{
+    const std::size_t     count = std::min<std::size_t>(page_count.Get(), kSamplePageCountMax);
+    std::vector<page::Id> pages;
+    std::mt19937_64       random{kRandomSeed};
+    // selection sampling, pages are selected in the order of file
+    for (U32 page_id = 0; pages.size() < count; page_id++)
+    {
+        const U64 left   = page_count.Get() - page_id;
+        const U64 needed = count - pages.size();
+        if (std::uniform_int_distribution<U64>{0, left - 1}(random) < needed)
+        {
+            pages.emplace_back(page_id);
+        }
+    }
+    return pages;
+}
+
+// bytes taken by value which is not NULL in rows, not counting alignment
+[[nodiscard]] static std::size_t GetStoredSize(const ColumnValue& value)
+{
+    if (const auto* string = std::get_if<ColumnValueVarchar>(&value))
+    {
+        return string->size();
+    }
+    return std::visit([](const auto& column_value) { return sizeof(column_value); }, value);
+}
+
+Builder::Builder(std::size_t column_count, page::Id page_count, std::size_t sample_page_count)
+    : page_count_{page_count}, sample_page_count_{sample_page_count}, columns_(column_count),
+      random_{kRandomSeed}
+{
+}
+
+void Builder::Add(Value&& value)
+{
+    ASSERT(value.size() == columns_.size());
+    row_count_++;
+    for (std::size_t i = 0; i < columns_.size(); i++)
+    {
+        const ColumnValue& column_value = value[i];
+        ColumnState&       column       = columns_[i];
+        if (column_value.index() == 0)
+        {
+            column.null_count++;
+            continue;
+        }
+        column.size_sum += GetStoredSize(column_value);
+        column.distinct.Add(ColumnValueHash(column_value));
+        if (column.min.index() == 0 || column_value < column.min)
+        {
+            column.min = column_value;
+        }
+        if (column.max.index() == 0 || column.max < column_value)
+        {
+            column.max = column_value;
+        }
+    }
+
+    // reservoir sampling, each row read is kept with the same probability
+    if (sample_.size() < kSampleRowCountMax)
+    {
+        sample_.push_back(std::move(value));
+        return;
+    }
+    std::uniform_int_distribution<U64> distribution{0, row_count_ - 1};
+    const U64                          index = distribution(random_);
+    if (index < kSampleRowCountMax)
+    {
+        sample_[index] = std::move(value);
+    }
+}
+
+Table Builder::Build()
+{
+    Table table{.row_count = 0, .page_count = page_count_.Get(), .columns = {}};
+    if (sample_page_count_ > 0)
+    {
+        table.row_count = static_cast<U64>(
+            std::llround(static_cast<double>(row_count_) * static_cast<double>(page_count_.Get()) /
+                         static_cast<double>(sample_page_count_)));
+    }
+    for (std::size_t i = 0; i < columns_.size(); i++)
+    {
+        table.columns.push_back(BuildColumn(i, table.row_count));
+    }
+    return table;
+}
+
+Column Builder::BuildColumn(std::size_t column, U64 row_count)
+{
+    ColumnState& state = columns_[column];
+
+    std::vector<ColumnValue> values;
+    for (Value& row : sample_)
+    {
+        if (row[column].index() != 0)
+        {
+            values.push_back(std::move(row[column]));
+        }
+    }
+    std::ranges::sort(values);
+
+    const auto   read_count    = static_cast<double>(row_count_ - state.null_count);
+    const double null_fraction = row_count_ == 0 ? 0
+                                                 : static_cast<double>(state.null_count) /
+                                                       static_cast<double>(row_count_);
+    const double average_size = row_count_ == 0 ? 0
+                                                : static_cast<double>(state.size_sum) /
+                                                      static_cast<double>(row_count_);
+    const double seen = std::min(state.distinct.Estimate(), read_count);
+
+    double distinct_count = seen;
+    if (sample_page_count_ < page_count_.Get() && !values.empty())
+    {
+        // Duj1 estimator of Haas and Stokes extrapolates distinct values of sample to the
+        // table, by how many of them occur only once
+        double sample_distinct = 0;
+        double sample_single   = 0;
+        for (std::size_t i = 0; i < values.size();)
+        {
+            std::size_t j = i + 1;
+            while (j < values.size() && values[j] == values[i])
+            {
+                j++;
+            }
+            sample_distinct += 1;
+            sample_single += j - i == 1 ? 1 : 0;
+            i = j;
+        }
+        const auto   sample_count = static_cast<double>(values.size());
+        const double total_count =
+            std::max(static_cast<double>(row_count) * (1 - null_fraction), sample_count);
+        const double estimate =
+            sample_count * sample_distinct /
+            (sample_count - sample_single + (sample_single * sample_count / total_count));
+        distinct_count = std::min(std::max(estimate, seen), total_count);
+    }
+
+    std::vector<ColumnValue> bounds;
+    if (!values.empty())
+    {
+        for (std::size_t i = 1; i < kBucketCount; i++)
+        {
+            bounds.push_back(values[i * values.size() / kBucketCount]);
+        }
+    }
+    return {.null_fraction  = null_fraction,
+            .distinct_count = distinct_count,
+            .average_size   = average_size,
+            .min            = std::move(state.min),
+            .max            = std::move(state.max),
+            .bounds         = std::move(bounds)};
+}
+
+[[nodiscard]] static bool IsArithmetic(const ColumnValue& value)
+{
+    return std::holds_alternative<ColumnValueInteger>(value) ||
+           std::holds_alternative<ColumnValueReal>(value);
+}
+
+[[nodiscard]] static double GetReal(const ColumnValue& value)
+{
+    if (const auto* integer = std::get_if<ColumnValueInteger>(&value))
+    {
+        return static_cast<double>(*integer);
+    }
+    return std::get<ColumnValueReal>(value);
+}
+
+// integers and reals compare by their values
+[[nodiscard]] static int Compare(const ColumnValue& value_l, const ColumnValue& value_r)
+{
+    if (IsArithmetic(value_l) && IsArithmetic(value_r))
+    {
+        const double real_l = GetReal(value_l);
+        const double real_r = GetReal(value_r);
+        return real_l < real_r ? -1 : (real_r < real_l ? 1 : 0);
+    }
+    return value_l < value_r ? -1 : (value_r < value_l ? 1 : 0);
+}
+
+// fraction of values which are not NULL and are less than value
+[[nodiscard]] static double EstimateFractionLess(const Column& column, const ColumnValue& value)
+{
+    if (Compare(value, column.min) <= 0)
+    {
+        return 0;
+    }
+    if (Compare(value, column.max) > 0)
+    {
+        return 1;
+    }
+    const std::size_t bucket_count = column.bounds.size() + 1;
+    const auto        get_bound    = [&column, bucket_count](std::size_t i) -> const ColumnValue&
+    {
+        if (i == 0)
+        {
+            return column.min;
+        }
+        return i == bucket_count ? column.max : column.bounds[i - 1];
+    };
+    for (std::size_t i = 0; i < bucket_count; i++)
+    {
+        const ColumnValue& low  = get_bound(i);
+        const ColumnValue& high = get_bound(i + 1);
+        if (Compare(value, high) > 0)
+        {
+            continue;
+        }
+        // values are assumed to be spread evenly in bucket
+        double fraction = 0.5;
+        if (IsArithmetic(value) && IsArithmetic(low) && GetReal(low) < GetReal(high))
+        {
+            fraction = (GetReal(value) - GetReal(low)) / (GetReal(high) - GetReal(low));
+        }
+        return (static_cast<double>(i) + std::clamp(fraction, 0.0, 1.0)) /
+               static_cast<double>(bucket_count);
+    }
+    return 1;
+}
+
+double EstimateSelectivity(const Column& column, Op2 op, const ColumnValue& value)
+{
+    if (value.index() == 0 || column.min.index() == 0)
+    {
+        return 0; // comparison with NULL is never true
+    }
+    const double not_null = 1 - column.null_fraction;
+    double       equal    = not_null / std::max(column.distinct_count, 1.0);
+    if (Compare(value, column.min) < 0 || Compare(value, column.max) > 0)
+    {
+        equal = 0;
+    }
+    const double less = not_null * EstimateFractionLess(column, value);
+    double       selectivity{};
+    switch (op)
+    {
+    case Op2::kCompEq:
+        selectivity = equal;
+        break;
+    case Op2::kCompNe:
+        selectivity = not_null - equal;
+        break;
+    case Op2::kCompL:
+        selectivity = less;
+        break;
+    case Op2::kCompLe:
+        selectivity = less + equal;
+        break;
+    case Op2::kCompG:
+        selectivity = not_null - less - equal;
+        break;
+    case Op2::kCompGe:
+        selectivity = not_null - less;
+        break;
+    case Op2::kArithMul:
+    case Op2::kArithDiv:
+    case Op2::kArithMod:
+    case Op2::kArithAdd:
+    case Op2::kArithSub:
+    case Op2::kLogicAnd:
+    case Op2::kLogicOr:
+        UNREACHABLE();
+    }
+    return std::clamp(selectivity, 0.0, 1.0);
+}
+
+double EstimateJoinSelectivity(const Column& column_l, const Column& column_r)
+{
+    // each value of the column with fewer distinct values has a match
+    const double distinct_count = std::max({column_l.distinct_count, column_r.distinct_count, 1.0});
+    return (1 - column_l.null_fraction) * (1 - column_r.null_fraction) / distinct_count;
+}
+} // namespace statistics
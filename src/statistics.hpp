@@ -0,0 +1,90 @@
+#pragma once
+
+#include "common.hpp"
+#include "op.hpp"
+#include "page.hpp"
+#include "value.hpp"
+
+#include <array>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+// Statistics of tables collected by ANALYZE, used to estimate sizes of results. Only a bounded
+// number of pages is read, so that large tables are analyzed in about the same time as small
+// ones. Distinct values of all rows read are counted by HyperLogLog, histograms are built from a
+// bounded random sample of them.
+namespace statistics
+{
+constexpr std::size_t kSamplePageCountMax = 1024;
+constexpr std::size_t kSampleRowCountMax  = 30000;
+constexpr std::size_t kBucketCount        = 8; // of histogram, power of two
+
+class HyperLogLog
+{
+public:
+    void                 Add(std::size_t hash);
+    [[nodiscard]] double Estimate() const;
+
+private:
+    static constexpr unsigned int kPrecision = 12; // 4096 registers, standard error about 1.6%
+
+    std::array<U8, std::size_t{1} << kPrecision> registers_{};
+};
+
+struct Column
+{
+    double      null_fraction;
+    double      distinct_count; // of values which are not NULL
+    double      average_size;   // in bytes of rows, NULL takes none
+    ColumnValue min, max;       // NULL if there are no other values
+    // Ascending values between buckets of histogram, which hold the same number of rows. Lowest
+    // bucket starts at min, highest one ends at max, so there is one bucket more than bounds.
+    std::vector<ColumnValue> bounds;
+};
+
+struct Table
+{
+    U64                 row_count;
+    U64                 page_count;
+    std::vector<Column> columns;
+};
+
+// returns ascending ids of pages to be read, all of them if there are few
+[[nodiscard]] std::vector<page::Id> SamplePages(page::Id page_count);
+
+// collects statistics from rows of sampled pages
+class Builder
+{
+public:
+    Builder(std::size_t column_count, page::Id page_count, std::size_t sample_page_count);
+
+    void                Add(Value&& value);
+    [[nodiscard]] Table Build();
+
+private:
+    struct ColumnState
+    {
+        U64         null_count = 0;
+        U64         size_sum   = 0;
+        HyperLogLog distinct;
+        ColumnValue min, max;
+    };
+
+    [[nodiscard]] Column BuildColumn(std::size_t column, U64 row_count);
+
+    const page::Id    page_count_;
+    const std::size_t sample_page_count_;
+
+    U64                      row_count_ = 0; // of sampled pages
+    std::vector<ColumnState> columns_;
+    std::vector<Value>       sample_; // reservoir of rows
+    std::mt19937_64          random_;
+};
+
+// fraction of rows for which comparison of column with constant on the right side is true
+[[nodiscard]] double EstimateSelectivity(const Column& column, Op2 op, const ColumnValue& value);
+
+// fraction of pairs of rows with equal values of columns
+[[nodiscard]] double EstimateJoinSelectivity(const Column& column_l, const Column& column_r);
+} // namespace statistics
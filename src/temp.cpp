@@ -0,0 +1,140 @@
+#include "temp.hpp"
+#include "common.hpp"
+#include "os.hpp"
+#include "page.hpp"
+#include "row.hpp"
+#include "value.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+namespace temp
+{
+// updated by worker threads too
+static std::atomic<unsigned int> merge_passes  = 0;
+static std::atomic<U64>          bytes_spilled = 0;
+
+void OnMergePass()
+{
+    merge_passes++;
+}
+
+void ResetStats()
+{
+    merge_passes  = 0;
+    bytes_spilled = 0;
+}
+
+Stats GetStats()
+{
+    return {.merge_passes = merge_passes, .bytes_spilled = bytes_spilled};
+}
+
+unsigned int GetPartition(const Value& key, unsigned int level)
+{
+    static constexpr unsigned int kHashBits = sizeof(std::size_t) * 8;
+    const std::size_t             hash      = ValueHash(key);
+    return static_cast<unsigned int>(hash >> (kHashBits - (kPartitionBits * (level + 1)))) &
+           (kPartitionCount - 1);
+}
+
+void Input::Init(const os::TempFile& file, page::Id page_begin, page::Id page_end)
+{
+    Init(file, {.page_id = page_begin, .entry_id = {}}, {.page_id = page_end, .entry_id = {}});
+}
+
+void Input::Init(const os::TempFile& file, Position begin, Position end)
+{
+    file_     = &file;
+    end_      = end;
+    page_id_  = begin.page_id;
+    entry_id_ = begin.entry_id;
+    loaded_   = false;
+}
+
+const U8* Input::Next(page::Offset& size)
+{
+    for (;;)
+    {
+        if (page_id_ == end_.page_id && entry_id_ == end_.entry_id)
+        {
+            return nullptr;
+        }
+        if (!loaded_)
+        {
+            file_->Read(page_id_, page_.Get());
+            loaded_ = true;
+        }
+        if (entry_id_ == page_->GetEntryCount())
+        {
+            page_id_++;
+            entry_id_ = page::EntryId{};
+            loaded_   = false;
+            continue;
+        }
+        const U8* const entry = page_->GetEntry(entry_id_++, size);
+        if (entry == nullptr)
+        {
+            continue;
+        }
+        return entry;
+    }
+}
+
+Output::Output(const os::TempFile& file) : file_{file}, page_id_{}, page_id_begin_{}
+{
+    page_->Init({});
+}
+
+void Output::Append(const U8* row, page::Offset align, page::Offset size)
+{
+    for (;;)
+    {
+        U8* const entry = page_->Insert(align, size, {});
+        if (entry == nullptr)
+        {
+            Write();
+            continue;
+        }
+        std::memcpy(entry, row, size);
+        break;
+    }
+}
+
+void Output::Append(const Value& value, page::Offset align)
+{
+    const row::Prefix prefix = row::CalculateLayout(value);
+    for (;;)
+    {
+        U8* const entry = page_->Insert(align, prefix.size, {});
+        if (entry == nullptr)
+        {
+            Write();
+            continue;
+        }
+        row::Write(prefix, value, entry);
+        break;
+    }
+}
+
+std::pair<page::Id, page::Id> Output::EndSection()
+{
+    Write();
+    const page::Id begin = page_id_begin_;
+    const page::Id end   = page_id_;
+    page_id_begin_       = page_id_;
+    return {begin, end};
+}
+
+void Output::Write()
+{
+    if (page_->GetEntryCount() > 0)
+    {
+        file_.Write(page_id_++, page_.Get());
+        bytes_spilled += page::kSize;
+    }
+    page_->Init({});
+}
+} // namespace temp
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "common.hpp"
+#include "os.hpp"
+#include "page.hpp"
+#include "row.hpp"
+#include "value.hpp"
+
+#include <cstddef>
+#include <utility>
+
+// rows stored in temporary files, used by operators which don't fit in memory
+namespace temp
+{
+// memory an operator may use before it spills to temporary files
+constexpr std::size_t kWorkMemory = std::size_t{page::kSize} * 256; // TODO: configurable
+
+// operators which don't fit in memory partition their input by key hash
+constexpr unsigned int kPartitionBits     = 4;
+constexpr unsigned int kPartitionCount    = 1U << kPartitionBits;
+constexpr unsigned int kPartitionLevelMax = 4; // then process in memory regardless of size
+
+// each level uses different bits of hash
+unsigned int GetPartition(const Value& key, unsigned int level);
+
+// usage of temporary files by the current query
+struct Stats
+{
+    unsigned int merge_passes  = 0; // of sorts
+    U64          bytes_spilled = 0;
+};
+
+void                OnMergePass();
+void                ResetStats();
+[[nodiscard]] Stats GetStats();
+
+// position of row in temporary file
+struct Position
+{
+    page::Id      page_id;
+    page::EntryId entry_id;
+};
+
+// reads rows from a range of pages
+class Input
+{
+public:
+    void Init(const os::TempFile& file, page::Id page_begin, page::Id page_end);
+    void Init(const os::TempFile& file, Position begin, Position end); // end is not included
+
+    const U8* Next(page::Offset& size);
+
+private:
+    buffer::Buffer<page::Slotted<>> page_;
+
+    const os::TempFile* file_;
+    Position            end_;
+
+    page::Id      page_id_;
+    page::EntryId entry_id_;
+    bool          loaded_ = false;
+};
+
+// appends rows to pages, sections are ranges of pages written between calls to EndSection
+class Output
+{
+public:
+    explicit Output(const os::TempFile& file);
+
+    void Append(const U8* row, page::Offset align, page::Offset size);
+    void Append(const Value& value, page::Offset align);
+
+    std::pair<page::Id, page::Id> EndSection();
+
+private:
+    void Write();
+
+    const os::TempFile& file_; // NOLINT(cppcoreguidelines-avoid-const-or-ref-data-members)
+    page::Id            page_id_, page_id_begin_;
+    buffer::Buffer<page::Slotted<>> page_;
+};
+} // namespace temp
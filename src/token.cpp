@@ -9,6 +9,8 @@ const char* Token::TagToCstr(Tag tag)
         return "CREATE";
     case Tag::kKeywordTable:
         return "TABLE";
+    case Tag::kKeywordIndex:
+        return "INDEX";
     case Tag::kKeywordDefault:
         return "DEFAULT";
     case Tag::kKeywordConstraint:
@@ -103,6 +105,18 @@ const char* Token::TagToCstr(Tag tag)
         return "UPDATE";
     case Tag::kKeywordSet:
         return "SET";
+    case Tag::kKeywordAnalyze:
+        return "ANALYZE";
+    case Tag::kKeywordExplain:
+        return "EXPLAIN";
+    case Tag::kKeywordPrepare:
+        return "PREPARE";
+    case Tag::kKeywordExecute:
+        return "EXECUTE";
+    case Tag::kKeywordDeallocate:
+        return "DEALLOCATE";
+    case Tag::kKeywordCopy:
+        return "COPY";
     case Tag::kLParen:
         return "(";
     case Tag::kRParen:
@@ -123,6 +137,8 @@ const char* Token::TagToCstr(Tag tag)
         return "an identifier";
     case Tag::kConstant:
         return "a constant";
+    case Tag::kParameter:
+        return "a parameter";
     case Tag::kEnd:
         return "end of source";
     }
@@ -16,6 +16,7 @@ public:
     {
         kKeywordCreate,
         kKeywordTable,
+        kKeywordIndex,
         kKeywordDefault,
         kKeywordConstraint,
         kKeywordNot,
@@ -63,6 +64,12 @@ public:
         kKeywordDelete,
         kKeywordUpdate,
         kKeywordSet,
+        kKeywordAnalyze,
+        kKeywordExplain,
+        kKeywordPrepare,
+        kKeywordExecute,
+        kKeywordDeallocate,
+        kKeywordCopy,
 
         kLParen,
         kRParen,
@@ -76,15 +83,17 @@ public:
         kIdentifier,
 
         kConstant,
+        kParameter,
 
         kEnd,
     };
 
-    using DataOp2      = ::Op2;
-    using DataFunction = ::Function;
-    using DataConstant = ColumnValue;
+    using DataOp2       = ::Op2;
+    using DataFunction  = ::Function;
+    using DataConstant  = ColumnValue;
+    using DataParameter = unsigned int; // index, counted from zero
 
-    using Data = std::variant<DataOp2, DataFunction, DataConstant>;
+    using Data = std::variant<DataOp2, DataFunction, DataConstant, DataParameter>;
 
     Token(Tag tag, SourceText text) : tag_{tag}, text_{std::move(text)}
     {
@@ -2,7 +2,10 @@
 #include "common.hpp"
 #include "type.hpp"
 
+#include <bit>
+#include <cstddef>
 #include <cstdio>
+#include <functional>
 #include <optional>
 #include <string>
 #include <variant>
@@ -169,3 +172,47 @@ bool ValueEqual(const Value& a, const Value& b)
     }
     return true;
 }
+
+std::size_t ColumnValueHash(const ColumnValue& value)
+{
+    return std::visit(
+        Overload{
+            [](const ColumnValueNull&) -> std::size_t { return 0; },
+            [](const ColumnValueBoolean& value) -> std::size_t
+            { return HashMix(static_cast<U64>(value) + 1); },
+            [](const ColumnValueInteger& value) -> std::size_t
+            { return HashMix(static_cast<U64>(value)); },
+            [](const ColumnValueReal& value) -> std::size_t
+            {
+                // -0.0 and 0.0 are equal, so they must have the same hash
+                return HashMix(std::bit_cast<U64>(value == 0 ? ColumnValueReal{0} : value));
+            },
+            [](const ColumnValueVarchar& value) -> std::size_t
+            { return HashMix(std::hash<ColumnValueVarchar>{}(value)); },
+        },
+        value);
+}
+
+std::size_t ValueHash(const Value& value)
+{
+    static constexpr U64 kPrime = 0x100000001B3ULL;
+    std::size_t          hash   = 0;
+    for (const ColumnValue& column_value : value)
+    {
+        hash = (hash * kPrime) ^ ColumnValueHash(column_value);
+    }
+    return hash;
+}
+
+std::size_t ValueMemorySize(const Value& value)
+{
+    std::size_t size = sizeof(Value) + (value.capacity() * sizeof(ColumnValue));
+    for (const ColumnValue& column_value : value)
+    {
+        if (const auto* string = std::get_if<ColumnValueVarchar>(&column_value))
+        {
+            size += string->capacity();
+        }
+    }
+    return size;
+}
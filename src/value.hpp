@@ -3,6 +3,7 @@
 #include "common.hpp"
 #include "type.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -48,9 +49,38 @@ using ColumnValue = std::variant<ColumnValueNull, ColumnValueBoolean, ColumnValu
 std::optional<ColumnType> ColumnValueToType(const ColumnValue& value);
 std::string               ColumnValueToString(const ColumnValue& value, bool quote);
 ColumnValue               ColumnValueEvalCast(const ColumnValue& value, ColumnType to);
+std::size_t               ColumnValueHash(const ColumnValue& value);
+
+// spreads bits of hash or of fixed size value to the high bits too (Fibonacci hashing), so that
+// hash tables can use either end of it
+inline std::size_t HashMix(U64 bits)
+{
+    static constexpr U64 kMultiplier = 0x9E3779B97F4A7C15ULL;
+    static constexpr U64 kShift      = 32;
+    bits *= kMultiplier;
+    return static_cast<std::size_t>(bits ^ (bits >> kShift));
+}
 
 using Value = std::vector<ColumnValue>;
 
 void        ValuePrint(const Value& value);
 std::string ValueToList(const Value& value);
 bool        ValueEqual(const Value& a, const Value& b);
+std::size_t ValueHash(const Value& value);
+std::size_t ValueMemorySize(const Value& value); // estimated size of in-memory representation
+
+// allows values as keys of unordered containers
+struct ValueHasher
+{
+    std::size_t operator()(const Value& value) const
+    {
+        return ValueHash(value);
+    }
+};
+struct ValueEqualTo
+{
+    bool operator()(const Value& a, const Value& b) const
+    {
+        return ValueEqual(a, b);
+    }
+};
@@ -0,0 +1,195 @@
+#include "aggregate.hpp"
+#include "database.hpp"
+#include "expr.hpp"
+#include "iter.hpp"
+#include "iter_values.hpp"
+#include "op.hpp"
+#include "temp.hpp"
+#include "value.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
+
+static constexpr std::array<Function, 5> kFunctions = {
+    Function::kAvg, Function::kMax, Function::kMin, Function::kSum, Function::kCount,
+};
+
+// splits values between two aggregators, merge must match aggregating all of them at once
+static void ExpectMergeEqual(const std::vector<ColumnValue>& values, std::size_t split)
+{
+    Aggregator all;
+    Aggregator left;
+    Aggregator right;
+    all.Init();
+    left.Init();
+    right.Init();
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        all.Feed(values[i]);
+        (i < split ? left : right).Feed(values[i]);
+    }
+    for (const Function function : kFunctions)
+    {
+        if (function == Function::kSum || function == Function::kAvg)
+        {
+            if (std::holds_alternative<ColumnValueVarchar>(values.front()))
+            {
+                continue;
+            }
+        }
+        Value state;
+        left.Save(function, state);
+        right.Save(function, state);
+        ASSERT_EQ(state.size(), Aggregator::GetStateSize(function) * 2);
+
+        Aggregator merged;
+        Aggregator partial;
+        merged.Init();
+        partial.Load(function, state, 0);
+        merged.Merge(partial);
+        partial.Load(function, state, Aggregator::GetStateSize(function));
+        merged.Merge(partial);
+        EXPECT_EQ(merged.Get(function), all.Get(function));
+    }
+}
+
+TEST(AggregateUnitTest, MergeInteger)
+{
+    const std::vector<ColumnValue> values = {
+        ColumnValueInteger{4}, ColumnValueNull{},     ColumnValueInteger{-2},
+        ColumnValueInteger{9}, ColumnValueInteger{1}, ColumnValueNull{},
+    };
+    for (std::size_t split = 0; split <= values.size(); split++)
+    {
+        ExpectMergeEqual(values, split);
+    }
+}
+
+TEST(AggregateUnitTest, MergeReal)
+{
+    const std::vector<ColumnValue> values = {
+        ColumnValueReal{0.5},
+        ColumnValueReal{-1.5},
+        ColumnValueNull{},
+        ColumnValueReal{2.0},
+    };
+    for (std::size_t split = 0; split <= values.size(); split++)
+    {
+        ExpectMergeEqual(values, split);
+    }
+}
+
+TEST(AggregateUnitTest, MergeVarchar)
+{
+    const std::vector<ColumnValue> values = {
+        ColumnValueVarchar{"b"},
+        ColumnValueNull{},
+        ColumnValueVarchar{"c"},
+        ColumnValueVarchar{"a"},
+    };
+    for (std::size_t split = 0; split <= values.size(); split++)
+    {
+        ExpectMergeEqual(values, split);
+    }
+}
+
+TEST(AggregateUnitTest, MergeEmpty)
+{
+    ExpectMergeEqual({ColumnValueNull{}, ColumnValueNull{}}, 1);
+}
+
+class AggregateHashUnitTest : public DatabaseUnitTest
+{
+protected:
+    // rows (key, value), with group_count groups
+    [[nodiscard]] static std::vector<Value> MakeRows(ColumnValueInteger count,
+                                                     ColumnValueInteger group_count)
+    {
+        std::vector<Value> rows;
+        for (ColumnValueInteger i = 0; i < count; i++)
+        {
+            rows.push_back({ColumnValueInteger{i % group_count}, ColumnValueInteger{i}});
+        }
+        return rows;
+    }
+
+    // rows (key, SUM(value), COUNT(*)) in order of key
+    [[nodiscard]] static std::vector<Value> AggregateExpected(const std::vector<Value>& rows)
+    {
+        std::map<ColumnValueInteger, std::pair<ColumnValueInteger, ColumnValueInteger>> groups;
+        for (const Value& row : rows)
+        {
+            auto& [sum, count] = groups[std::get<ColumnValueInteger>(row[0])];
+            sum += std::get<ColumnValueInteger>(row[1]);
+            count++;
+        }
+        std::vector<Value> result;
+        for (const auto& [key, group] : groups)
+        {
+            result.push_back({key, group.first, group.second});
+        }
+        return result;
+    }
+
+    [[nodiscard]] static IterAggregateHash MakeAggregate(Iter&& parent)
+    {
+        Aggregates aggregates;
+        aggregates.exprs.push_back(
+            {.function = Function::kSum,
+             .arg = std::make_unique<Expr>(Expr::DataColumn{ColumnId{1}}, ColumnType::kInteger)});
+        aggregates.exprs.push_back({.function = Function::kCount, .arg = nullptr});
+        aggregates.group_by = {ColumnId{0}};
+        return IterAggregateHash{std::move(parent), std::move(aggregates)};
+    }
+
+    [[nodiscard]] static std::vector<Value> ReadSorted(IterBase& iter)
+    {
+        std::vector<Value> rows = ReadAll(iter);
+        std::ranges::sort(rows);
+        return rows;
+    }
+};
+
+TEST_F(AggregateHashUnitTest, RestartInMemory)
+{
+    const std::vector<Value> rows     = MakeRows(100, 7);
+    const std::vector<Value> expected = AggregateExpected(rows);
+
+    auto        values = std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows});
+    IterValues* parent = values.get();
+
+    IterAggregateHash aggregate = MakeAggregate(std::move(values));
+    aggregate.Open();
+    EXPECT_EQ(ReadSorted(aggregate), expected);
+    aggregate.Restart();
+    EXPECT_EQ(ReadSorted(aggregate), expected);
+    EXPECT_EQ(parent->restart_count, 0); // groups were kept
+    aggregate.Close();
+}
+
+TEST_F(AggregateHashUnitTest, Spilled)
+{
+    // groups take many times more than work memory, so they are partitioned
+    const auto               count    = static_cast<ColumnValueInteger>(temp::kWorkMemory / 8);
+    const std::vector<Value> rows     = MakeRows(count, count / 2);
+    const std::vector<Value> expected = AggregateExpected(rows);
+
+    auto        values = std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows});
+    IterValues* parent = values.get();
+
+    IterAggregateHash aggregate = MakeAggregate(std::move(values));
+    aggregate.Open();
+    EXPECT_EQ(ReadSorted(aggregate), expected);
+    aggregate.Restart();
+    EXPECT_EQ(ReadSorted(aggregate), expected);
+    EXPECT_EQ(parent->restart_count, 1); // partitions were built again
+    aggregate.Close();
+}
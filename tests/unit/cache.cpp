@@ -3,7 +3,9 @@
 #include <gtest/gtest.h>
 
 #include <cstddef>
+#include <functional>
 #include <string>
+#include <utility>
 
 using Key   = int;
 using Value = std::string;
@@ -26,6 +28,27 @@ private:
     std::size_t call_count_ = 0;
 };
 
+// Loads the same key again while loading it, once
+class ReentrantLoader
+{
+public:
+    explicit ReentrantLoader(std::function<void(Key)>& reenter) : reenter_{&reenter}
+    {
+    }
+
+    [[nodiscard]] Value operator()(Key key)
+    {
+        if (*reenter_)
+        {
+            std::exchange(*reenter_, nullptr)(key);
+        }
+        return "value_" + std::to_string(key);
+    }
+
+private:
+    std::function<void(Key)>* reenter_;
+};
+
 TEST(CacheUnitTest, OldestIsEvicted)
 {
     static constexpr std::size_t  kCapacity = 4UL;
@@ -211,3 +234,23 @@ TEST(CacheUnitTest, ClearAll)
     EXPECT_EQ(cache.GetSize(), 0);
     EXPECT_EQ(cache.GetLoader().GetCallCount(), 5);
 }
+
+TEST(CacheUnitTest, ReentrantLoad)
+{
+    static constexpr std::size_t       kCapacity = 4UL;
+    std::function<void(Key)>           reenter;
+    Cache<Key, Value, ReentrantLoader> cache{kCapacity, ReentrantLoader{reenter}};
+    reenter = [&cache](Key key) { EXPECT_EQ(cache.Get(key), "value_" + std::to_string(key)); };
+
+    // Key is cached by nested load first
+    EXPECT_EQ(cache.Get(0), "value_0");
+    EXPECT_EQ(cache.GetSize(), 1);
+
+    // Cache is full
+    for (Key key = 1; key <= 5; key++)
+    {
+        EXPECT_EQ(cache.Get(key), "value_" + std::to_string(key));
+        EXPECT_LE(cache.GetSize(), kCapacity);
+    }
+    EXPECT_EQ(cache.GetSize(), kCapacity);
+}
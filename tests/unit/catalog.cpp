@@ -0,0 +1,96 @@
+#include "catalog.hpp"
+#include "database.hpp"
+#include "error.hpp"
+#include "execute.hpp"
+#include "statistics.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+using CatalogUnitTest = DatabaseUnitTest;
+
+// each change is visible at once and increments version, names are stored in upper case
+TEST_F(CatalogUnitTest, ChangeIncrementsVersion)
+{
+    const unsigned int version = catalog::GetVersion();
+    EXPECT_FALSE(catalog::FindTable("CHANGED"));
+
+    catalog::CreateTable("CHANGED", {{"ID", ColumnType::kInteger}, {"NAME", ColumnType::kVarchar}});
+    EXPECT_EQ(catalog::GetVersion(), version + 1);
+    const std::optional<std::pair<catalog::TableId, Type>> table = catalog::FindTable("CHANGED");
+    ASSERT_TRUE(table);
+    EXPECT_EQ(table->second.Size(), 2);
+    EXPECT_EQ(catalog::GetTableNames(), std::vector<std::string>{"CHANGED"});
+    const catalog::TableId table_id = table->first;
+
+    const catalog::FileId file_id = catalog::CreateIndex("CHANGED_ID", table_id, ColumnId{0});
+    EXPECT_EQ(catalog::GetVersion(), version + 2);
+    const std::vector<catalog::Index> indexes = catalog::GetTableIndexes(table_id);
+    ASSERT_EQ(indexes.size(), 1);
+    EXPECT_EQ(indexes[0].name, "CHANGED_ID");
+    EXPECT_EQ(indexes[0].file_id, file_id);
+    ASSERT_TRUE(catalog::FindIndex("CHANGED_ID"));
+
+    const statistics::Column column = {.null_fraction  = 0,
+                                       .distinct_count = 3,
+                                       .average_size   = 8,
+                                       .min            = ColumnValueInteger{1},
+                                       .max            = ColumnValueInteger{3},
+                                       .bounds         = {}};
+    EXPECT_FALSE(catalog::FindStatistics(table_id));
+    catalog::SetStatistics(table_id,
+                           {.row_count = 3, .page_count = 1, .columns = {column, column}});
+    EXPECT_EQ(catalog::GetVersion(), version + 3);
+    const std::optional<statistics::Table> statistics = catalog::FindStatistics(table_id);
+    ASSERT_TRUE(statistics);
+    EXPECT_EQ(statistics->row_count, 3);
+    ASSERT_EQ(statistics->columns.size(), 2);
+    EXPECT_EQ(statistics->columns[0].max, ColumnValue{ColumnValueInteger{3}});
+
+    catalog::DropTable(table_id);
+    EXPECT_EQ(catalog::GetVersion(), version + 4);
+    EXPECT_FALSE(catalog::FindTable("CHANGED"));
+    EXPECT_FALSE(catalog::FindIndex("CHANGED_ID"));
+    EXPECT_FALSE(catalog::FindStatistics(table_id));
+    EXPECT_TRUE(catalog::GetTableNames().empty());
+}
+
+TEST_F(CatalogUnitTest, FailedStatementKeepsVersion)
+{
+    (void)ExecuteIinternalStatement("CREATE TABLE kept (id INTEGER)");
+    const unsigned int version = catalog::GetVersion();
+    EXPECT_THROW((void)ExecuteIinternalStatement("CREATE TABLE kept (id INTEGER)"), ServerError);
+    EXPECT_THROW((void)ExecuteIinternalStatement("CREATE INDEX kept_id ON kept (missing)"),
+                 ServerError);
+    EXPECT_EQ(catalog::GetVersion(), version);
+    (void)ExecuteIinternalStatement("DROP TABLE kept");
+}
+
+// cached plans of statement are compiled again after table is dropped and created again
+TEST_F(CatalogUnitTest, CachedPlanNotUsedAfterChange)
+{
+    const std::string select = "SELECT * FROM recreated";
+    (void)ExecuteIinternalStatement("CREATE TABLE recreated (id INTEGER)");
+    (void)ExecuteIinternalStatement("INSERT INTO recreated VALUES (1)");
+    EXPECT_EQ(ExecuteIinternalStatement(select), std::vector<Value>{{ColumnValueInteger{1}}});
+
+    (void)ExecuteIinternalStatement("DROP TABLE recreated");
+    EXPECT_THROW((void)ExecuteIinternalStatement(select), ServerError);
+
+    (void)ExecuteIinternalStatement("CREATE TABLE recreated (id INTEGER, name VARCHAR)");
+    (void)ExecuteIinternalStatement("INSERT INTO recreated VALUES (2, 'two')");
+    const std::vector<Value> expected = {{ColumnValueInteger{2}, ColumnValueVarchar{"two"}}};
+    EXPECT_EQ(ExecuteIinternalStatement(select), expected);
+
+    // plan of INSERT as well, it would insert into file of dropped table
+    (void)ExecuteIinternalStatement("DROP TABLE recreated");
+    (void)ExecuteIinternalStatement("CREATE TABLE recreated (id INTEGER, name VARCHAR)");
+    (void)ExecuteIinternalStatement("INSERT INTO recreated VALUES (2, 'two')");
+    EXPECT_EQ(ExecuteIinternalStatement(select), expected);
+    (void)ExecuteIinternalStatement("DROP TABLE recreated");
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "catalog.hpp"
+#include "scheduler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+
+#include <unistd.h>
+
+// Tests which execute statements. Catalog creates data directory in the current one, each test
+// process has its own, since tests are run by ctest in parallel processes.
+class DatabaseUnitTest : public testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        std::filesystem::create_directories(GetPath());
+        std::filesystem::current_path(GetPath());
+        buffer::Init();
+        catalog::Init();
+        scheduler::Init({});
+    }
+
+    static void TearDownTestSuite()
+    {
+        scheduler::Destroy();
+        buffer::Destroy();
+        std::filesystem::current_path(std::filesystem::temp_directory_path());
+        std::filesystem::remove_all(GetPath());
+    }
+
+private:
+    [[nodiscard]] static std::filesystem::path GetPath()
+    {
+        return std::filesystem::temp_directory_path() /
+               ("database_unit_test_" + std::to_string(getpid()));
+    }
+};
@@ -0,0 +1,104 @@
+#include "explain.hpp"
+#include "iter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// returns integers from zero to count
+class IterRange : public IterBase
+{
+public:
+    explicit IterRange(ColumnValueInteger count) : IterBase{MakeType()}, count_{count}
+    {
+    }
+
+    void Open() override
+    {
+        next_ = 0;
+    }
+    void Restart() override
+    {
+        next_ = 0;
+    }
+    void Close() override
+    {
+    }
+    std::optional<Value> Next() override
+    {
+        if (next_ == count_)
+        {
+            return std::nullopt;
+        }
+        return Value{ColumnValueInteger{next_++}};
+    }
+    [[nodiscard]] std::string GetName() const override
+    {
+        return "Range";
+    }
+
+private:
+    static Type MakeType()
+    {
+        Type type;
+        type.Push(ColumnType::kInteger);
+        return type;
+    }
+
+    const ColumnValueInteger count_;
+    ColumnValueInteger       next_ = 0;
+};
+
+[[nodiscard]] static Iter CreatePlan()
+{
+    Iter range      = std::make_unique<IterRange>(10);
+    range->estimate = optimizer::Estimate{.rows = 10, .cost = 2};
+    return std::make_unique<IterProject>(std::move(range), std::vector<ColumnId>{ColumnId{0}});
+}
+
+TEST(ExplainUnitTest, Describe)
+{
+    Iter                           iter  = CreatePlan();
+    const IterBase*                root  = iter.get();
+    const explain::Node            plan  = explain::Describe(iter, false);
+    const std::vector<std::string> lines = explain::Format(plan);
+    EXPECT_EQ(iter.get(), root); // not wrapped
+    EXPECT_EQ(plan.counters, nullptr);
+    ASSERT_EQ(lines.size(), 2);
+    EXPECT_EQ(lines[0], "Project");
+    EXPECT_EQ(lines[1], "  Range  (estimated rows=10 cost=2.0)");
+}
+
+TEST(ExplainUnitTest, Analyze)
+{
+    Iter                iter = CreatePlan();
+    const explain::Node plan = explain::Describe(iter, true);
+    ASSERT_EQ(plan.inputs.size(), 1);
+    ASSERT_NE(plan.counters, nullptr);
+    ASSERT_NE(plan.inputs[0].counters, nullptr);
+
+    // all rows are read once, then first three of them again
+    iter->Open();
+    while (iter->Next())
+    {
+    }
+    iter->Restart();
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_TRUE(iter->Next());
+    }
+    iter->Close();
+
+    for (const explain::Node* node : {&plan, &plan.inputs[0]})
+    {
+        EXPECT_EQ(node->counters->rows, 13);
+        EXPECT_EQ(node->counters->loops, 2);
+        EXPECT_EQ(node->counters->pins, 0);
+        EXPECT_EQ(node->counters->temp_pages, 0);
+    }
+    const std::string line = explain::Format(plan)[1];
+    EXPECT_TRUE(line.starts_with("  Range  (estimated rows=10 cost=2.0)  (actual rows=13 loops=2 "));
+}
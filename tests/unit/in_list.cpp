@@ -0,0 +1,62 @@
+#include "in_list.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+TEST(InListUnitTest, ShortList)
+{
+    const InList list{{ColumnValueInteger{3}, ColumnValueInteger{1}, ColumnValueInteger{2}}};
+
+    EXPECT_EQ(list.Find(ColumnValueInteger{1}), Bool::kTrue);
+    EXPECT_EQ(list.Find(ColumnValueInteger{3}), Bool::kTrue);
+    EXPECT_EQ(list.Find(ColumnValueInteger{4}), Bool::kFalse);
+    EXPECT_EQ(list.Find(ColumnValueNull{}), Bool::kUnknown);
+}
+
+TEST(InListUnitTest, LongList)
+{
+    static constexpr std::size_t kSize = 1000;
+
+    std::vector<ColumnValue> values;
+    for (std::size_t i = 0; i < kSize; i++)
+    {
+        values.emplace_back("value_" + std::to_string(i * 2));
+    }
+    const InList list{std::move(values)};
+
+    for (std::size_t i = 0; i < kSize * 2; i++)
+    {
+        const Bool expected = i % 2 == 0 ? Bool::kTrue : Bool::kFalse;
+        EXPECT_EQ(list.Find(ColumnValueVarchar{"value_" + std::to_string(i)}), expected);
+    }
+}
+
+TEST(InListUnitTest, Duplicates)
+{
+    static constexpr std::size_t kSize = 100;
+
+    std::vector<ColumnValue> values;
+    for (std::size_t i = 0; i < kSize; i++)
+    {
+        values.emplace_back(ColumnValueInteger{7});
+    }
+    const InList list{std::move(values)};
+
+    EXPECT_EQ(list.Find(ColumnValueInteger{7}), Bool::kTrue);
+    EXPECT_EQ(list.Find(ColumnValueInteger{8}), Bool::kFalse);
+}
+
+TEST(InListUnitTest, Null)
+{
+    const InList list{{ColumnValueReal{1.5}, ColumnValueNull{}, ColumnValueReal{-0.0}}};
+
+    EXPECT_EQ(list.Find(ColumnValueReal{1.5}), Bool::kTrue);
+    EXPECT_EQ(list.Find(ColumnValueReal{0.0}), Bool::kTrue);
+    EXPECT_EQ(list.Find(ColumnValueReal{2.5}), Bool::kUnknown);
+
+    const InList nulls{{ColumnValueNull{}}};
+    EXPECT_EQ(nulls.Find(ColumnValueInteger{1}), Bool::kUnknown);
+}
@@ -0,0 +1,72 @@
+#include "compile.hpp"
+#include "database.hpp"
+#include "execute.hpp"
+#include "explain.hpp"
+#include "prepare.hpp"
+#include "value.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+// rows with equal indexed column are found by searching index
+class IndexScanUnitTest : public DatabaseUnitTest
+{
+protected:
+    // table has many pages, so that index is used
+    static void CreateTable(const std::string& table)
+    {
+        (void)ExecuteIinternalStatement("CREATE TABLE " + table + " (id INTEGER, name VARCHAR)");
+        (void)ExecuteIinternalStatement("CREATE INDEX " + table + "_id ON " + table + " (id)");
+        for (int i = 1; i <= 100; i++)
+        {
+            (void)ExecuteIinternalStatement("INSERT INTO " + table + " VALUES ($1, $2)",
+                                            {ColumnValueInteger{i}, "name" + std::to_string(i)});
+        }
+    }
+};
+
+TEST_F(IndexScanUnitTest, Lookup)
+{
+    CreateTable("looked");
+    // each statement has constant key, so that each is compiled
+    const auto find = [](int id)
+    {
+        return ExecuteIinternalStatement("SELECT name FROM looked WHERE id = " +
+                                         std::to_string(id));
+    };
+    const std::shared_ptr<prepare::Plan> plan =
+        prepare::GetPlan("SELECT name FROM looked WHERE id = 77", {});
+    const std::vector<std::string> lines =
+        explain::Format(explain::Describe(std::get<Query>(plan->statement).iter, false));
+    EXPECT_TRUE(std::ranges::any_of(lines, [](const std::string& line)
+                                    { return line.find("Index Scan") != std::string::npos; }));
+
+    EXPECT_EQ(find(77), (std::vector<Value>{{"name77"}}));
+    EXPECT_EQ(find(3), (std::vector<Value>{{"name3"}}));
+    EXPECT_TRUE(find(101).empty());
+    (void)ExecuteIinternalStatement("DELETE FROM looked WHERE id = 77");
+    EXPECT_TRUE(find(77).empty());
+    (void)ExecuteIinternalStatement("INSERT INTO looked VALUES (77, 'again')");
+    EXPECT_EQ(find(77), (std::vector<Value>{{"again"}}));
+}
+
+TEST_F(IndexScanUnitTest, ExecutedAgain)
+{
+    CreateTable("idx");
+    // statement has parameter, so that its cached plan is executed again
+    const auto find = [](ColumnValueInteger id)
+    { return ExecuteIinternalStatement("SELECT name FROM idx WHERE id = $1", {id}); };
+    EXPECT_EQ(find(77), (std::vector<Value>{{"name77"}}));
+    EXPECT_EQ(find(3), (std::vector<Value>{{"name3"}}));
+    EXPECT_TRUE(find(101).empty());
+    (void)ExecuteIinternalStatement("DELETE FROM idx WHERE id = $1", {ColumnValueInteger{77}});
+    EXPECT_TRUE(find(77).empty());
+    (void)ExecuteIinternalStatement("INSERT INTO idx VALUES ($1, $2)",
+                                    {ColumnValueInteger{77}, "again"});
+    EXPECT_EQ(find(77), (std::vector<Value>{{"again"}}));
+}
@@ -0,0 +1,109 @@
+#include "catalog.hpp"
+#include "database.hpp"
+#include "error.hpp"
+#include "execute.hpp"
+#include "fst.hpp"
+#include "page.hpp"
+#include "temp.hpp"
+#include "value.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+class InsertUnitTest : public DatabaseUnitTest
+{
+protected:
+    [[nodiscard]] static std::vector<Value> Select(const std::string& table)
+    {
+        return ExecuteIinternalStatement("SELECT * FROM " + table + " ORDER BY id");
+    }
+};
+
+TEST_F(InsertUnitTest, ValuesWithInvalidKeyInsertNothing)
+{
+    (void)ExecuteIinternalStatement("CREATE TABLE keyed (id INTEGER, name VARCHAR)");
+    (void)ExecuteIinternalStatement("CREATE INDEX keyed_name ON keyed (name)");
+    const std::string long_name(200, 'x');
+    // errors of internal statements are reported as server errors
+    EXPECT_THROW((void)ExecuteIinternalStatement("INSERT INTO keyed VALUES ($1, $2), ($3, $4)",
+                                                 {ColumnValueInteger{7}, "ok",
+                                                  ColumnValueInteger{8}, long_name}),
+                 ServerError);
+    EXPECT_TRUE(Select("keyed").empty());
+}
+
+TEST_F(InsertUnitTest, ValuesWithManyRows)
+{
+    (void)ExecuteIinternalStatement("CREATE TABLE multiple (id INTEGER, name VARCHAR)");
+    (void)ExecuteIinternalStatement(
+        "INSERT INTO multiple VALUES (1, 'one'), ($1, $2), (1 + 2, NULL)",
+        {ColumnValueInteger{2}, "two"});
+    const std::vector<Value> expected = {
+        {ColumnValueInteger{1}, ColumnValueVarchar{"one"}},
+        {ColumnValueInteger{2}, ColumnValueVarchar{"two"}},
+        {ColumnValueInteger{3}, ColumnValueNull{}},
+    };
+    EXPECT_EQ(Select("multiple"), expected);
+}
+
+// rows of query are stored before any is inserted, so that inserted rows are not read again
+TEST_F(InsertUnitTest, QueryFromSameTable)
+{
+    // more rows than fit in work memory
+    const auto count = static_cast<ColumnValueInteger>(temp::kWorkMemory / 64);
+    (void)ExecuteIinternalStatement("CREATE TABLE doubled (id INTEGER, name VARCHAR)");
+    for (ColumnValueInteger i = 0; i < count; i++)
+    {
+        (void)ExecuteIinternalStatement("INSERT INTO doubled VALUES ($1, $2)",
+                                        {ColumnValueInteger{i}, "name_" + std::to_string(i)});
+    }
+    (void)ExecuteIinternalStatement("INSERT INTO doubled SELECT id + $1, name FROM doubled",
+                                    {ColumnValueInteger{count}});
+    const std::vector<Value> rows = Select("doubled");
+    ASSERT_EQ(rows.size(), count * 2);
+    for (ColumnValueInteger i = 0; i < count * 2; i++)
+    {
+        const Value expected = {ColumnValueInteger{i}, "name_" + std::to_string(i % count)};
+        EXPECT_EQ(rows[i], expected);
+    }
+}
+
+// rows inserted by one statement or by many fill pages of table the same way, and are found by
+// index on any page
+TEST_F(InsertUnitTest, RowsFillPages)
+{
+    const ColumnValueInteger count = 200;
+    std::string              insert = "INSERT INTO filled_once VALUES ";
+    for (ColumnValueInteger i = 0; i < count; i++)
+    {
+        insert += (i == 0 ? "(" : ", (") + std::to_string(i) + ", 'name_" + std::to_string(i) +
+                  "')";
+    }
+    (void)ExecuteIinternalStatement("CREATE TABLE filled_once (id INTEGER, name VARCHAR)");
+    (void)ExecuteIinternalStatement(insert);
+    (void)ExecuteIinternalStatement("CREATE TABLE filled (id INTEGER, name VARCHAR)");
+    (void)ExecuteIinternalStatement("CREATE INDEX filled_id ON filled (id)");
+    for (ColumnValueInteger i = 0; i < count; i++)
+    {
+        (void)ExecuteIinternalStatement("INSERT INTO filled VALUES ($1, $2)",
+                                        {ColumnValueInteger{i}, "name_" + std::to_string(i)});
+    }
+
+    // names are stored in upper case
+    const auto get_page_count = [](const std::string& name)
+    { return fst::GetPageCount(catalog::GetTableFileIds(catalog::FindTable(name)->first).fst); };
+    const page::Id page_count = get_page_count("FILLED");
+    EXPECT_GT(page_count, 1);
+    EXPECT_EQ(page_count, get_page_count("FILLED_ONCE"));
+
+    EXPECT_EQ(Select("filled"), Select("filled_once"));
+    for (ColumnValueInteger i = 0; i < count; i++)
+    {
+        const std::vector<Value> expected = {{"name_" + std::to_string(i)}};
+        EXPECT_EQ(ExecuteIinternalStatement("SELECT name FROM filled WHERE id = $1",
+                                            {ColumnValueInteger{i}}),
+                  expected);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "iter.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// returns given rows, counts restarts so that tests can check whether input was read again
+class IterValues : public IterBase
+{
+public:
+    IterValues(Type&& type, std::vector<Value>&& values)
+        : IterBase{std::move(type)}, values_{std::move(values)}
+    {
+    }
+
+    void Open() override
+    {
+        next_ = 0;
+    }
+    void Restart() override
+    {
+        next_ = 0;
+        restart_count++;
+    }
+    void Close() override
+    {
+    }
+    std::optional<Value> Next() override
+    {
+        if (next_ == values_.size())
+        {
+            return std::nullopt;
+        }
+        return values_[next_++];
+    }
+    [[nodiscard]] std::string GetName() const override
+    {
+        return "Values";
+    }
+
+    unsigned int restart_count = 0;
+
+private:
+    const std::vector<Value> values_;
+    std::size_t              next_ = 0;
+};
+
+[[nodiscard]] inline Type MakeIntegerType(std::size_t column_count)
+{
+    Type type;
+    for (std::size_t i = 0; i < column_count; i++)
+    {
+        type.Push(ColumnType::kInteger);
+    }
+    return type;
+}
+
+// reads remaining rows of open iterator
+[[nodiscard]] inline std::vector<Value> ReadAll(IterBase& iter)
+{
+    std::vector<Value> values;
+    while (std::optional<Value> value = iter.Next())
+    {
+        values.push_back(std::move(*value));
+    }
+    return values;
+}
@@ -0,0 +1,261 @@
+#include "join.hpp"
+#include "catalog.hpp"
+#include "database.hpp"
+#include "execute.hpp"
+#include "expr.hpp"
+#include "iter.hpp"
+#include "iter_values.hpp"
+#include "op.hpp"
+#include "temp.hpp"
+#include "value.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+class JoinUnitTest : public DatabaseUnitTest
+{
+protected:
+    [[nodiscard]] static ExprPtr Column(unsigned int index)
+    {
+        return std::make_unique<Expr>(Expr::DataColumn{ColumnId{index}}, ColumnType::kInteger);
+    }
+
+    // join on first column of both inputs
+    [[nodiscard]] static JoinKeys MakeKeys()
+    {
+        JoinKeys keys;
+        keys.exprs_l.push_back(Column(0));
+        keys.exprs_r.push_back(Column(0));
+        return keys;
+    }
+
+    // second column of left row is less than second column of right row
+    [[nodiscard]] static ExprPtr MakeResidual(std::size_t column_count_l)
+    {
+        return std::make_unique<Expr>(
+            Expr::DataOp2{.expr_l = Column(1),
+                          .expr_r = Column(static_cast<unsigned int>(column_count_l) + 1),
+                          .op     = std::make_pair(Op2::kCompL, SourceText{})},
+            ColumnType::kBoolean);
+    }
+
+    // rows (key, value), key is NULL for every tenth row
+    [[nodiscard]] static std::vector<Value> MakeRows(ColumnValueInteger count,
+                                                     ColumnValueInteger key_count)
+    {
+        std::vector<Value> rows;
+        for (ColumnValueInteger i = 0; i < count; i++)
+        {
+            const ColumnValue key = i % 10 == 9 ? ColumnValue{} : ColumnValue{i % key_count};
+            rows.push_back({key, ColumnValueInteger{i}});
+        }
+        return rows;
+    }
+
+    // joined rows in order, computed by comparing all pairs
+    [[nodiscard]] static std::vector<Value>
+    JoinExpected(const std::vector<Value>& rows_l, const std::vector<Value>& rows_r,
+                 const std::function<bool(const Value&, const Value&)>& residual)
+    {
+        std::vector<Value> rows;
+        for (const Value& row_l : rows_l)
+        {
+            for (const Value& row_r : rows_r)
+            {
+                if (std::holds_alternative<ColumnValueNull>(row_l[0]) || row_l[0] != row_r[0] ||
+                    (residual && !residual(row_l, row_r)))
+                {
+                    continue;
+                }
+                Value row = row_l;
+                row.insert(row.end(), row_r.begin(), row_r.end());
+                rows.push_back(std::move(row));
+            }
+        }
+        std::ranges::sort(rows);
+        return rows;
+    }
+
+    [[nodiscard]] static std::vector<Value> ReadSorted(IterBase& iter)
+    {
+        std::vector<Value> rows = ReadAll(iter);
+        std::ranges::sort(rows);
+        return rows;
+    }
+};
+
+TEST_F(JoinUnitTest, HashRestartInMemory)
+{
+    const std::vector<Value> rows_l   = MakeRows(100, 30);
+    const std::vector<Value> rows_r   = MakeRows(50, 40);
+    const std::vector<Value> expected = JoinExpected(rows_l, rows_r, nullptr);
+    ASSERT_FALSE(expected.empty());
+
+    auto        iter_l = std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_l});
+    auto        iter_r = std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_r});
+    IterValues* build  = iter_r.get();
+    IterJoinHash join{std::move(iter_l), std::move(iter_r), MakeKeys(), nullptr, false,
+                      MakeIntegerType(4)};
+    join.Open();
+    EXPECT_EQ(ReadSorted(join), expected);
+    join.Restart();
+    EXPECT_EQ(ReadSorted(join), expected);
+    EXPECT_EQ(build->restart_count, 0); // hash table was kept
+    join.Close();
+}
+
+TEST_F(JoinUnitTest, HashResidual)
+{
+    const std::vector<Value> rows_l = MakeRows(200, 20);
+    const std::vector<Value> rows_r = MakeRows(100, 20);
+    const auto               residual = [](const Value& row_l, const Value& row_r)
+    { return std::get<ColumnValueInteger>(row_l[1]) < std::get<ColumnValueInteger>(row_r[1]); };
+    const std::vector<Value> expected = JoinExpected(rows_l, rows_r, residual);
+    ASSERT_FALSE(expected.empty());
+
+    for (const bool build_left : {false, true})
+    {
+        IterJoinHash join{std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_l}),
+                          std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_r}),
+                          MakeKeys(), MakeResidual(2), build_left, MakeIntegerType(4)};
+        join.Open();
+        EXPECT_EQ(ReadSorted(join), expected);
+        join.Close();
+    }
+}
+
+TEST_F(JoinUnitTest, HashSpilled)
+{
+    // build input is many times larger than work memory, so it is partitioned
+    const auto               count  = static_cast<ColumnValueInteger>(temp::kWorkMemory / 16);
+    const std::vector<Value> rows_l = MakeRows(count, count);
+    const std::vector<Value> rows_r = MakeRows(count / 2, count / 4);
+    const std::vector<Value> expected = JoinExpected(rows_l, rows_r, nullptr);
+    ASSERT_FALSE(expected.empty());
+
+    auto         iter_l = std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_l});
+    IterValues*  build  = iter_l.get();
+    IterJoinHash join{std::move(iter_l),
+                      std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_r}),
+                      MakeKeys(), nullptr, true, MakeIntegerType(4)};
+    join.Open();
+    EXPECT_EQ(ReadSorted(join), expected);
+    join.Restart();
+    EXPECT_EQ(ReadSorted(join), expected);
+    EXPECT_EQ(build->restart_count, 1); // partitions were built again
+    join.Close();
+}
+
+TEST_F(JoinUnitTest, MergeDuplicatesAndNulls)
+{
+    // both inputs have groups of rows with equal key and rows with NULL key
+    const std::vector<Value> rows_l   = MakeRows(120, 15);
+    const std::vector<Value> rows_r   = MakeRows(90, 20);
+    const std::vector<Value> expected = JoinExpected(rows_l, rows_r, nullptr);
+    ASSERT_FALSE(expected.empty());
+
+    IterJoinMerge join{std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_l}),
+                       std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_r}),
+                       MakeKeys(), nullptr, MakeIntegerType(4)};
+    join.Open();
+    const std::vector<Value> rows = ReadAll(join);
+    EXPECT_TRUE(std::ranges::is_sorted(rows, {}, [](const Value& row) { return row[0]; }));
+    std::vector<Value> sorted = rows;
+    std::ranges::sort(sorted);
+    EXPECT_EQ(sorted, expected);
+    join.Close();
+}
+
+TEST_F(JoinUnitTest, MergeResidual)
+{
+    const std::vector<Value> rows_l = MakeRows(200, 20);
+    const std::vector<Value> rows_r = MakeRows(100, 20);
+    const auto               residual = [](const Value& row_l, const Value& row_r)
+    { return std::get<ColumnValueInteger>(row_l[1]) < std::get<ColumnValueInteger>(row_r[1]); };
+    const std::vector<Value> expected = JoinExpected(rows_l, rows_r, residual);
+    ASSERT_FALSE(expected.empty());
+
+    IterJoinMerge join{std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_l}),
+                       std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_r}),
+                       MakeKeys(), MakeResidual(2), MakeIntegerType(4)};
+    join.Open();
+    EXPECT_EQ(ReadSorted(join), expected);
+    join.Close();
+}
+
+TEST_F(JoinUnitTest, MergeSpilledGroup)
+{
+    // rows of right input with the same key take more than work memory, so some are spilled and
+    // read again for each left row with that key
+    const auto               count  = static_cast<ColumnValueInteger>(temp::kWorkMemory / 16);
+    const std::vector<Value> rows_l = MakeRows(30, 3);
+    const std::vector<Value> rows_r = MakeRows(count, 1);
+    const std::vector<Value> expected = JoinExpected(rows_l, rows_r, nullptr);
+    ASSERT_FALSE(expected.empty());
+
+    IterJoinMerge join{std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_l}),
+                       std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_r}),
+                       MakeKeys(), nullptr, MakeIntegerType(4)};
+    join.Open();
+    EXPECT_EQ(ReadSorted(join), expected);
+    join.Restart();
+    EXPECT_EQ(ReadSorted(join), expected);
+    join.Close();
+}
+
+TEST_F(JoinUnitTest, Index)
+{
+    // inner table spans many pages and has deleted rows, whose index entries stay
+    std::vector<Value> rows_inner = MakeRows(1000, 300);
+    std::string        insert     = "INSERT INTO indexed VALUES ";
+    for (const Value& row : rows_inner)
+    {
+        const std::string key = std::holds_alternative<ColumnValueNull>(row[0])
+                                  ? "NULL"
+                                  : std::to_string(std::get<ColumnValueInteger>(row[0]));
+        insert += (&row == rows_inner.data() ? "(" : ", (") + key + ", " +
+                  std::to_string(std::get<ColumnValueInteger>(row[1])) + ")";
+    }
+    (void)ExecuteIinternalStatement("CREATE TABLE indexed (id INTEGER, value INTEGER)");
+    (void)ExecuteIinternalStatement("CREATE INDEX indexed_id ON indexed (id)");
+    (void)ExecuteIinternalStatement(insert);
+    (void)ExecuteIinternalStatement("DELETE FROM indexed WHERE value % 7 = 0");
+    std::erase_if(rows_inner, [](const Value& row)
+                  { return std::get<ColumnValueInteger>(row[1]) % 7 == 0; });
+
+    // names are stored in upper case
+    const catalog::TableId table_id   = catalog::FindTable("INDEXED")->first;
+    const catalog::FileId  file_inner = catalog::GetTableFileIds(table_id).dat;
+    const catalog::FileId  file_index = catalog::FindIndex("INDEXED_ID")->file_id;
+
+    // outer rows are read in several batches
+    const auto               count      = static_cast<ColumnValueInteger>(temp::kWorkMemory / 16);
+    const std::vector<Value> rows_outer = MakeRows(count, 400);
+    const auto               residual   = [](const Value& row_l, const Value& row_r)
+    { return std::get<ColumnValueInteger>(row_l[1]) < std::get<ColumnValueInteger>(row_r[1]); };
+
+    for (const bool outer_left : {false, true})
+    {
+        const std::vector<Value>& rows_l   = outer_left ? rows_outer : rows_inner;
+        const std::vector<Value>& rows_r   = outer_left ? rows_inner : rows_outer;
+        const std::vector<Value>  expected = JoinExpected(rows_l, rows_r, residual);
+        ASSERT_FALSE(expected.empty());
+
+        auto iter_outer = std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows_outer});
+        IterJoinIndex join{std::move(iter_outer), file_inner, MakeIntegerType(2), {}, file_index,
+                           MakeKeys(), 0, MakeResidual(2), outer_left, MakeIntegerType(4)};
+        join.Open();
+        EXPECT_EQ(ReadSorted(join), expected);
+        join.Restart();
+        EXPECT_EQ(ReadSorted(join), expected);
+        join.Close();
+    }
+}
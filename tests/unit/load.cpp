@@ -0,0 +1,56 @@
+#include "database.hpp"
+#include "error.hpp"
+#include "execute.hpp"
+#include "value.hpp"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+class LoadUnitTest : public DatabaseUnitTest
+{
+protected:
+    // rows from one to count, row with the given number has invalid integer
+    static void WriteCsv(const std::string& file_name, int count, int invalid_row)
+    {
+        std::ofstream file{file_name};
+        for (int i = 1; i <= count; i++)
+        {
+            file << (i == invalid_row ? "x" : std::to_string(i)) << ",name" << i << '\n';
+        }
+    }
+
+    [[nodiscard]] static ColumnValueInteger Count()
+    {
+        const std::vector<Value> values = ExecuteIinternalStatement("SELECT COUNT(*) FROM loaded");
+        EXPECT_EQ(values.size(), 1);
+        return std::get<ColumnValueInteger>(values.at(0).at(0));
+    }
+
+    [[nodiscard]] static std::vector<Value> Find(ColumnValueInteger id)
+    {
+        return ExecuteIinternalStatement("SELECT name FROM loaded WHERE id = $1", {id});
+    }
+};
+
+TEST_F(LoadUnitTest, NoRowsLoadedOnError)
+{
+    static constexpr int kRowCount = 10000; // pages are written in several batches
+
+    (void)ExecuteIinternalStatement("CREATE TABLE loaded (id INTEGER, name VARCHAR)");
+    (void)ExecuteIinternalStatement("CREATE INDEX loaded_id ON loaded (id)");
+    WriteCsv("invalid.csv", kRowCount, kRowCount - 1);
+    // errors of internal statements are reported as server errors
+    EXPECT_THROW((void)ExecuteIinternalStatement("COPY loaded FROM 'invalid.csv'"), ServerError);
+    EXPECT_EQ(Count(), 0);
+    EXPECT_TRUE(Find(1).empty());
+
+    // pages of failed load are overwritten, its entries are not in index
+    WriteCsv("valid.csv", kRowCount, 0);
+    (void)ExecuteIinternalStatement("COPY loaded FROM 'valid.csv'");
+    EXPECT_EQ(Count(), kRowCount);
+    EXPECT_EQ(Find(1), (std::vector<Value>{{"name1"}}));
+    EXPECT_EQ(Find(kRowCount), (std::vector<Value>{{"name" + std::to_string(kRowCount)}}));
+}
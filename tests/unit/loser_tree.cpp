@@ -0,0 +1,92 @@
+#include "loser_tree.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+// merges sorted inputs, counts comparisons
+static std::vector<int> Merge(const std::vector<std::vector<int>>& inputs,
+                              std::size_t&                         compare_count_out)
+{
+    std::vector<std::size_t> positions(inputs.size());
+
+    const auto less = [&inputs, &positions, &compare_count_out](std::size_t k_l, std::size_t k_r)
+    {
+        compare_count_out++;
+        const bool done_l = positions[k_l] == inputs[k_l].size();
+        const bool done_r = positions[k_r] == inputs[k_r].size();
+        return !done_l && (done_r || inputs[k_l][positions[k_l]] < inputs[k_r][positions[k_r]]);
+    };
+
+    std::vector<int> output;
+    LoserTree        tree{inputs.size(), less};
+    for (;;)
+    {
+        const std::size_t k = tree.GetWinner();
+        if (positions[k] == inputs[k].size())
+        {
+            break;
+        }
+        output.push_back(inputs[k][positions[k]++]);
+        tree.Update();
+    }
+    return output;
+}
+
+static void ExpectMerged(std::size_t input_count, std::size_t input_size)
+{
+    std::mt19937                       random{static_cast<unsigned int>(input_count)};
+    std::vector<std::vector<int>>      inputs(input_count);
+    std::uniform_int_distribution<int> values{0, 100};
+    std::vector<int>                   expected;
+    for (std::vector<int>& input : inputs)
+    {
+        input.resize(input_size);
+        for (int& value : input)
+        {
+            value = values(random);
+        }
+        std::ranges::sort(input);
+        expected.insert(expected.end(), input.begin(), input.end());
+    }
+    std::ranges::sort(expected);
+
+    std::size_t compare_count = 0;
+    EXPECT_EQ(Merge(inputs, compare_count), expected);
+
+    // one match per level for each output row
+    std::size_t depth = 0;
+    while ((std::size_t{1} << depth) < input_count)
+    {
+        depth++;
+    }
+    EXPECT_LE(compare_count, (input_count - 1) + ((expected.size() + 1) * depth));
+}
+
+TEST(LoserTreeUnitTest, SingleInput)
+{
+    ExpectMerged(1, 10);
+}
+
+TEST(LoserTreeUnitTest, TwoInputs)
+{
+    ExpectMerged(2, 100);
+}
+
+TEST(LoserTreeUnitTest, ManyInputs)
+{
+    for (const std::size_t input_count : {3, 5, 8, 13, 255})
+    {
+        ExpectMerged(input_count, 50);
+    }
+}
+
+TEST(LoserTreeUnitTest, EmptyInputs)
+{
+    std::size_t compare_count = 0;
+    EXPECT_TRUE(Merge({{}, {}, {}}, compare_count).empty());
+    EXPECT_EQ(Merge({{}, {1, 2}, {}}, compare_count), (std::vector<int>{1, 2}));
+}
@@ -0,0 +1,65 @@
+#include "database.hpp"
+#include "iter.hpp"
+#include "iter_values.hpp"
+#include "temp.hpp"
+#include "value.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+class MaterializeUnitTest : public DatabaseUnitTest
+{
+protected:
+    [[nodiscard]] static std::vector<Value> MakeRows(ColumnValueInteger count)
+    {
+        std::vector<Value> rows;
+        for (ColumnValueInteger i = 0; i < count; i++)
+        {
+            rows.push_back({ColumnValueInteger{i}, ColumnValueInteger{-i}});
+        }
+        return rows;
+    }
+
+    // rows are read once partly and then twice completely, parent is read only once
+    static void ExpectRestartKeepsRows(const std::vector<Value>& rows)
+    {
+        auto        values = std::make_unique<IterValues>(MakeIntegerType(2), std::vector{rows});
+        IterValues* parent = values.get();
+
+        IterMaterialize materialize{std::move(values)};
+        materialize.Open();
+        for (std::size_t i = 0; i < rows.size() / 2; i++)
+        {
+            const std::optional<Value> value = materialize.Next();
+            ASSERT_TRUE(value);
+            EXPECT_EQ(*value, rows[i]);
+        }
+        materialize.Restart();
+        EXPECT_EQ(ReadAll(materialize), rows);
+        materialize.Restart();
+        EXPECT_EQ(ReadAll(materialize), rows);
+        EXPECT_EQ(parent->restart_count, 0);
+        materialize.Close();
+    }
+};
+
+TEST_F(MaterializeUnitTest, InMemory)
+{
+    ExpectRestartKeepsRows(MakeRows(100));
+}
+
+TEST_F(MaterializeUnitTest, Spilled)
+{
+    // rows take many times more than work memory, the rest is read from temporary file
+    ExpectRestartKeepsRows(MakeRows(static_cast<ColumnValueInteger>(temp::kWorkMemory / 16)));
+}
+
+TEST_F(MaterializeUnitTest, Empty)
+{
+    ExpectRestartKeepsRows({});
+}
@@ -0,0 +1,151 @@
+#include "optimizer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <bit>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+class OptimizerUnitTest : public ::testing::Test
+{
+protected:
+    using RelationSet = optimizer::RelationSet;
+
+    struct Edge
+    {
+        std::size_t relation_l, relation_r;
+        double      selectivity;
+    };
+
+    // cost of join is the sum of sizes of intermediate results
+    [[nodiscard]] std::vector<optimizer::Plan> OrderJoins(const std::vector<double>& rows) const
+    {
+        std::vector<optimizer::Estimate> relations;
+        for (const double relation_rows : rows)
+        {
+            relations.push_back({.rows = relation_rows, .cost = 0});
+        }
+        return optimizer::OrderJoins(
+            relations,
+            [this](const optimizer::Plan& left, const optimizer::Plan& right)
+            {
+                double result_rows = left.estimate.rows * right.estimate.rows;
+                for (const Edge& edge : edges_)
+                {
+                    if (IsConnecting(edge, left.relations, right.relations))
+                    {
+                        result_rows *= edge.selectivity;
+                    }
+                }
+                return optimizer::Estimate{.rows = result_rows,
+                                           .cost = left.estimate.cost + right.estimate.cost +
+                                                   result_rows};
+            });
+    }
+
+    // each plan is either leaf or join of preceding plans of disjoint sets of relations
+    static void ExpectValid(const std::vector<optimizer::Plan>& plans, std::size_t relation_count)
+    {
+        ASSERT_EQ(plans.size(), (relation_count * 2) - 1);
+        for (std::size_t i = 0; i < plans.size(); i++)
+        {
+            const optimizer::Plan& plan = plans[i];
+            if (i < relation_count)
+            {
+                EXPECT_EQ(plan.relations, RelationSet{1} << i);
+                EXPECT_TRUE(plan.IsLeaf());
+                continue;
+            }
+            ASSERT_LT(plan.left, i);
+            ASSERT_LT(plan.right, i);
+            const RelationSet left  = plans[plan.left].relations;
+            const RelationSet right = plans[plan.right].relations;
+            EXPECT_EQ(left & right, 0);
+            EXPECT_EQ(left | right, plan.relations);
+        }
+        EXPECT_EQ(std::popcount(plans.back().relations), relation_count);
+    }
+
+    // no plan joins inputs without an edge between them
+    void ExpectNoCrossProduct(const std::vector<optimizer::Plan>& plans) const
+    {
+        for (const optimizer::Plan& plan : plans)
+        {
+            if (plan.IsLeaf())
+            {
+                continue;
+            }
+            bool connected = false;
+            for (const Edge& edge : edges_)
+            {
+                connected = connected || IsConnecting(edge, plans[plan.left].relations,
+                                                      plans[plan.right].relations);
+            }
+            EXPECT_TRUE(connected) << plan.relations;
+        }
+    }
+
+    std::vector<Edge> edges_;
+
+private:
+    static bool IsConnecting(const Edge& edge, RelationSet left, RelationSet right)
+    {
+        const RelationSet relation_l = RelationSet{1} << edge.relation_l;
+        const RelationSet relation_r = RelationSet{1} << edge.relation_r;
+        return ((left & relation_l) != 0 && (right & relation_r) != 0) ||
+               ((left & relation_r) != 0 && (right & relation_l) != 0);
+    }
+};
+
+TEST_F(OptimizerUnitTest, SingleRelation)
+{
+    const std::vector<optimizer::Plan> plans = OrderJoins({100});
+    ExpectValid(plans, 1);
+}
+
+TEST_F(OptimizerUnitTest, SelectiveJoinFirst)
+{
+    // 0 - 1 - 2, join of 1 and 2 keeps few rows
+    edges_ = {{.relation_l = 0, .relation_r = 1, .selectivity = 0.01},
+              {.relation_l = 1, .relation_r = 2, .selectivity = 0.0001}};
+    const std::vector<optimizer::Plan> plans = OrderJoins({1000, 1000, 1000});
+    ExpectValid(plans, 3);
+    ExpectNoCrossProduct(plans);
+
+    const optimizer::Plan& root  = plans.back();
+    const std::size_t      first = plans[root.left].IsLeaf() ? root.right : root.left;
+    EXPECT_EQ(plans[first].relations, 0b110);
+    EXPECT_DOUBLE_EQ(root.estimate.cost, 100 + 1000);
+}
+
+TEST_F(OptimizerUnitTest, BushyTree)
+{
+    // two pairs of relations joined selectively, then the pairs
+    edges_ = {{.relation_l = 0, .relation_r = 1, .selectivity = 0.001},
+              {.relation_l = 1, .relation_r = 2, .selectivity = 0.1},
+              {.relation_l = 2, .relation_r = 3, .selectivity = 0.001}};
+    const std::vector<optimizer::Plan> plans = OrderJoins({1000, 1000, 1000, 1000});
+    ExpectValid(plans, 4);
+
+    const optimizer::Plan& root = plans.back();
+    EXPECT_FALSE(plans[root.left].IsLeaf());
+    EXPECT_FALSE(plans[root.right].IsLeaf());
+}
+
+TEST_F(OptimizerUnitTest, GreedyChain)
+{
+    const std::size_t   count = optimizer::kExhaustiveCountMax + 6;
+    std::vector<double> rows;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        rows.push_back(static_cast<double>((i % 4) + 1) * 1000);
+        if (i > 0)
+        {
+            edges_.push_back({.relation_l = i - 1, .relation_r = i, .selectivity = 0.001});
+        }
+    }
+    const std::vector<optimizer::Plan> plans = OrderJoins(rows);
+    ExpectValid(plans, count);
+    ExpectNoCrossProduct(plans);
+}
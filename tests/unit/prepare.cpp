@@ -0,0 +1,90 @@
+#include "database.hpp"
+#include "error.hpp"
+#include "execute.hpp"
+#include "prepare.hpp"
+#include "value.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+// cached plans are executed again after the tables they read are changed
+class PrepareUnitTest : public DatabaseUnitTest
+{
+protected:
+    [[nodiscard]] static ColumnValueInteger Count(const std::string& table)
+    {
+        const std::vector<Value> values = ExecuteIinternalStatement(
+            "SELECT COUNT(*) FROM " + table + " WHERE id > $1", {ColumnValueInteger{0}});
+        EXPECT_EQ(values.size(), 1);
+        return std::get<ColumnValueInteger>(values.at(0).at(0));
+    }
+
+    static void Insert(const std::string& table, int count)
+    {
+        for (int i = 1; i <= count; i++)
+        {
+            (void)ExecuteIinternalStatement("INSERT INTO " + table + " VALUES ($1)",
+                                            {ColumnValueInteger{i}});
+        }
+    }
+};
+
+TEST_F(PrepareUnitTest, ScanAfterInsertAndDelete)
+{
+    (void)ExecuteIinternalStatement("CREATE TABLE scan (id INTEGER)");
+    EXPECT_EQ(Count("scan"), 0);
+    Insert("scan", 28);
+    EXPECT_EQ(Count("scan"), 28);
+    (void)ExecuteIinternalStatement("DELETE FROM scan WHERE id > $1", {ColumnValueInteger{20}});
+    EXPECT_EQ(Count("scan"), 20);
+    (void)ExecuteIinternalStatement("DELETE FROM scan"); // truncates table
+    EXPECT_EQ(Count("scan"), 0);
+    Insert("scan", 3);
+    EXPECT_EQ(Count("scan"), 3);
+}
+
+TEST_F(PrepareUnitTest, SortAggregateExecutedAgain)
+{
+    (void)ExecuteIinternalStatement("CREATE TABLE grp (id INTEGER, k INTEGER)");
+    for (int i = 1; i <= 30; i++)
+    {
+        (void)ExecuteIinternalStatement("INSERT INTO grp VALUES ($1, $2)",
+                                        {ColumnValueInteger{i}, ColumnValueInteger{i % 3}});
+    }
+    // groups are read in order of keys, so that sort-based aggregation is used
+    const std::vector<std::string> sources = {
+        "SELECT k, COUNT(*) FROM grp WHERE id > $1 GROUP BY k ORDER BY k",
+        "SELECT k, COUNT(*) FROM grp WHERE id > $1 GROUP BY k ORDER BY k LIMIT 2"};
+    for (const std::string& source : sources)
+    {
+        const Value              parameters = {ColumnValueInteger{0}};
+        const std::vector<Value> first      = ExecuteIinternalStatement(source, parameters);
+        const std::vector<Value> second     = ExecuteIinternalStatement(source, parameters);
+        ASSERT_GE(first.size(), 2);
+        EXPECT_EQ(first[0], (Value{ColumnValueInteger{0}, ColumnValueInteger{10}}));
+        EXPECT_EQ(first[1], (Value{ColumnValueInteger{1}, ColumnValueInteger{10}}));
+        EXPECT_EQ(second, first);
+    }
+}
+
+TEST_F(PrepareUnitTest, ErrorShowsTextOfStatement)
+{
+    (void)ExecuteIinternalStatement("CREATE TABLE err (id INTEGER)");
+    const std::string source = "SELECT * FROM err WHERE id = $1";
+    try
+    {
+        (void)prepare::GetPlan(source, {ColumnValueVarchar{"2"}});
+        FAIL();
+    }
+    catch (const ClientError& error)
+    {
+        // statement executing prepared one does not contain its text
+        testing::internal::CaptureStderr();
+        error.PrintError("EXECUTE q ('2')");
+        const std::string output = testing::internal::GetCapturedStderr();
+        EXPECT_NE(output.find(source), std::string::npos);
+        EXPECT_NE(output.find(std::string(source.find('='), ' ') + '^'), std::string::npos);
+    }
+}
@@ -0,0 +1,156 @@
+#include "row.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <string>
+#include <vector>
+
+class RowKeyUnitTest : public ::testing::Test
+{
+protected:
+    std::vector<U8> MakeKey(const Type& type, const Value& value, const std::vector<bool>& asc)
+    {
+        const row::Prefix prefix = row::CalculateLayout(value);
+        std::vector<U64>& row    = rows_.emplace_back((prefix.size / sizeof(U64)) + 1);
+        row::Write(prefix, value, reinterpret_cast<U8*>(row.data()));
+
+        std::vector<U8> key;
+        for (ColumnId column_id{}; column_id < type.Size(); column_id++)
+        {
+            row::AppendKey(type, column_id, asc[column_id.Get()],
+                           reinterpret_cast<const U8*>(row.data()), key);
+        }
+        return key;
+    }
+
+    static int CompareKeys(const std::vector<U8>& key_l, const std::vector<U8>& key_r)
+    {
+        const std::size_t size_min = std::min(key_l.size(), key_r.size());
+        const int         result   = std::memcmp(key_l.data(), key_r.data(), size_min);
+        if (result != 0)
+        {
+            return result < 0 ? -1 : +1;
+        }
+        return key_l.size() < key_r.size() ? -1 : (key_l.size() > key_r.size() ? +1 : 0);
+    }
+
+    // values are in ascending order
+    void ExpectOrdered(const Type& type, const std::vector<Value>& values)
+    {
+        for (const bool asc : {true, false})
+        {
+            const std::vector<bool> order(type.Size(), asc);
+            for (std::size_t i = 0; i < values.size(); i++)
+            {
+                for (std::size_t j = 0; j < values.size(); j++)
+                {
+                    const int expected = i < j ? -1 : (i > j ? +1 : 0);
+                    EXPECT_EQ(CompareKeys(MakeKey(type, values[i], order),
+                                          MakeKey(type, values[j], order)),
+                              asc ? expected : -expected)
+                        << i << " " << j << " " << asc;
+                }
+            }
+        }
+    }
+
+    static Type MakeType(std::initializer_list<ColumnType> columns)
+    {
+        Type type;
+        for (const ColumnType column : columns)
+        {
+            type.Push(column);
+        }
+        return type;
+    }
+
+private:
+    std::vector<std::vector<U64>> rows_;
+};
+
+TEST_F(RowKeyUnitTest, Integer)
+{
+    using Limits = std::numeric_limits<ColumnValueInteger>;
+
+    ExpectOrdered(MakeType({ColumnType::kInteger}), {
+                                                        {ColumnValueInteger{Limits::min()}},
+                                                        {ColumnValueInteger{-256}},
+                                                        {ColumnValueInteger{-1}},
+                                                        {ColumnValueInteger{0}},
+                                                        {ColumnValueInteger{1}},
+                                                        {ColumnValueInteger{256}},
+                                                        {ColumnValueInteger{Limits::max()}},
+                                                        {ColumnValueNull{}},
+                                                    });
+}
+
+TEST_F(RowKeyUnitTest, Real)
+{
+    using Limits = std::numeric_limits<ColumnValueReal>;
+
+    ExpectOrdered(MakeType({ColumnType::kReal}), {
+                                                     {ColumnValueReal{-Limits::infinity()}},
+                                                     {ColumnValueReal{-1e300}},
+                                                     {ColumnValueReal{-1.5}},
+                                                     {ColumnValueReal{-Limits::denorm_min()}},
+                                                     {ColumnValueReal{0}},
+                                                     {ColumnValueReal{Limits::denorm_min()}},
+                                                     {ColumnValueReal{1.5}},
+                                                     {ColumnValueReal{1e300}},
+                                                     {ColumnValueReal{Limits::infinity()}},
+                                                     {ColumnValueNull{}},
+                                                 });
+}
+
+TEST_F(RowKeyUnitTest, NegativeZero)
+{
+    const Type type = MakeType({ColumnType::kReal});
+    EXPECT_EQ(MakeKey(type, {ColumnValueReal{-0.0}}, {true}),
+              MakeKey(type, {ColumnValueReal{0.0}}, {true}));
+}
+
+TEST_F(RowKeyUnitTest, Varchar)
+{
+    using namespace std::string_literals;
+
+    ExpectOrdered(MakeType({ColumnType::kVarchar}), {
+                                                        {ColumnValueVarchar{"a"}},
+                                                        {ColumnValueVarchar{"a\0"s}},
+                                                        {ColumnValueVarchar{"a\0\0"s}},
+                                                        {ColumnValueVarchar{"a\1"s}},
+                                                        {ColumnValueVarchar{"ab"}},
+                                                        {ColumnValueVarchar{"b"}},
+                                                        {ColumnValueVarchar{"\xFF"}},
+                                                        {ColumnValueNull{}},
+                                                    });
+}
+
+TEST_F(RowKeyUnitTest, MultipleColumns)
+{
+    using namespace std::string_literals;
+
+    ExpectOrdered(MakeType({ColumnType::kVarchar, ColumnType::kInteger}),
+                  {
+                      {ColumnValueVarchar{"a"}, ColumnValueInteger{2}},
+                      {ColumnValueVarchar{"a"}, ColumnValueNull{}},
+                      {ColumnValueVarchar{"a\0"s}, ColumnValueInteger{1}},
+                      {ColumnValueVarchar{"b"}, ColumnValueInteger{-1}},
+                      {ColumnValueNull{}, ColumnValueInteger{0}},
+                  });
+}
+
+TEST_F(RowKeyUnitTest, MixedOrder)
+{
+    const Type type = MakeType({ColumnType::kInteger, ColumnType::kInteger});
+    const auto key  = [this, &type](ColumnValueInteger a, ColumnValueInteger b)
+    { return MakeKey(type, {ColumnValue{a}, ColumnValue{b}}, {true, false}); };
+
+    EXPECT_LT(CompareKeys(key(1, 5), key(1, 4)), 0);
+    EXPECT_LT(CompareKeys(key(1, 0), key(2, 9)), 0);
+    EXPECT_EQ(CompareKeys(key(3, 3), key(3, 3)), 0);
+}
@@ -0,0 +1,99 @@
+#include "scheduler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+class SchedulerUnitTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        scheduler::Init({.worker_count = 4, .pin = false});
+    }
+
+    void TearDown() override
+    {
+        scheduler::Destroy();
+    }
+};
+
+TEST_F(SchedulerUnitTest, RunsAllTasks)
+{
+    std::atomic<int> sum = 0;
+    {
+        scheduler::TaskGroup tasks;
+        for (int i = 1; i <= 1000; i++)
+        {
+            tasks.Submit([&sum, i] { sum += i; });
+        }
+        tasks.Wait();
+    }
+    EXPECT_EQ(sum, 500500);
+
+    U64 task_count = 0;
+    for (const scheduler::WorkerStats& stats : scheduler::GetStats())
+    {
+        task_count += stats.tasks;
+    }
+    EXPECT_LE(task_count, 1000); // the rest was run by waiting thread
+}
+
+TEST_F(SchedulerUnitTest, NestedTasks)
+{
+    std::atomic<int> count = 0;
+    {
+        scheduler::TaskGroup outer;
+        for (int i = 0; i < 8; i++)
+        {
+            outer.Submit(
+                [&count]
+                {
+                    scheduler::TaskGroup inner;
+                    for (int j = 0; j < 8; j++)
+                    {
+                        inner.Submit([&count] { count++; });
+                    }
+                    inner.Wait();
+                });
+        }
+        outer.Wait();
+    }
+    EXPECT_EQ(count, 64);
+}
+
+TEST_F(SchedulerUnitTest, ExceptionCancelsGroup)
+{
+    std::atomic<int>     count = 0;
+    scheduler::TaskGroup tasks;
+    tasks.Submit([] { throw std::runtime_error{"task"}; });
+    tasks.Submit(
+        [&count, &tasks]
+        {
+            while (!tasks.IsCancelled())
+            {
+                // waits for the first task
+            }
+            count++;
+        });
+    EXPECT_THROW(tasks.Wait(), std::runtime_error);
+    EXPECT_TRUE(tasks.IsCancelled());
+    EXPECT_LE(count, 1);
+}
+
+TEST_F(SchedulerUnitTest, CancelSkipsTasks)
+{
+    std::atomic<int> count = 0;
+    {
+        scheduler::TaskGroup tasks;
+        tasks.Cancel();
+        for (int i = 0; i < 100; i++)
+        {
+            tasks.Submit([&count] { count++; });
+        }
+        tasks.Wait();
+    }
+    EXPECT_EQ(count, 0);
+}
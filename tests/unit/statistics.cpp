@@ -0,0 +1,134 @@
+#include "statistics.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <string>
+#include <variant>
+#include <vector>
+
+TEST(StatisticsUnitTest, HyperLogLog)
+{
+    for (const std::size_t count : {10, 1000, 100000})
+    {
+        statistics::HyperLogLog distinct;
+        for (std::size_t i = 0; i < count * 3; i++)
+        {
+            distinct.Add(ColumnValueHash(static_cast<ColumnValueInteger>(i % count)));
+        }
+        const auto expected = static_cast<double>(count);
+        EXPECT_NEAR(distinct.Estimate(), expected, expected * 0.05) << count;
+    }
+}
+
+TEST(StatisticsUnitTest, SamplePages)
+{
+    const std::vector<page::Id> few = statistics::SamplePages(page::Id{10});
+    ASSERT_EQ(few.size(), 10);
+    for (std::size_t i = 0; i < few.size(); i++)
+    {
+        EXPECT_EQ(few[i], page::Id{static_cast<U32>(i)});
+    }
+
+    const std::vector<page::Id> many = statistics::SamplePages(page::Id{1000000});
+    ASSERT_EQ(many.size(), statistics::kSamplePageCountMax);
+    for (std::size_t i = 1; i < many.size(); i++)
+    {
+        EXPECT_LT(many[i - 1], many[i]);
+    }
+    EXPECT_LT(many.back(), page::Id{1000000});
+}
+
+TEST(StatisticsUnitTest, AllPages)
+{
+    static constexpr std::size_t kRowCount = 1000;
+
+    // all pages are read, so counts are exact
+    statistics::Builder builder{2, page::Id{10}, 10};
+    for (std::size_t i = 0; i < kRowCount; i++)
+    {
+        const ColumnValue string =
+            i % 4 == 0 ? ColumnValue{} : ColumnValue{"s" + std::to_string(i % 10)};
+        builder.Add({static_cast<ColumnValueInteger>(i), string});
+    }
+    const statistics::Table table = builder.Build();
+    EXPECT_EQ(table.row_count, kRowCount);
+    EXPECT_EQ(table.page_count, 10);
+    ASSERT_EQ(table.columns.size(), 2);
+
+    const statistics::Column& integer = table.columns[0];
+    EXPECT_DOUBLE_EQ(integer.null_fraction, 0);
+    EXPECT_DOUBLE_EQ(integer.average_size, sizeof(ColumnValueInteger));
+    EXPECT_NEAR(integer.distinct_count, kRowCount, kRowCount * 0.05);
+    EXPECT_EQ(integer.min, ColumnValue{ColumnValueInteger{0}});
+    EXPECT_EQ(integer.max, ColumnValue{static_cast<ColumnValueInteger>(kRowCount - 1)});
+    ASSERT_EQ(integer.bounds.size(), statistics::kBucketCount - 1);
+    for (std::size_t i = 0; i < integer.bounds.size(); i++)
+    {
+        const auto expected =
+            static_cast<ColumnValueInteger>((i + 1) * kRowCount / statistics::kBucketCount);
+        EXPECT_EQ(integer.bounds[i], ColumnValue{expected});
+    }
+
+    const statistics::Column& varchar = table.columns[1];
+    EXPECT_DOUBLE_EQ(varchar.null_fraction, 0.25);
+    EXPECT_DOUBLE_EQ(varchar.average_size, 0.75 * 2); // strings of two characters
+    EXPECT_NEAR(varchar.distinct_count, 10, 0.5);
+    EXPECT_EQ(varchar.min, ColumnValue{"s0"});
+    EXPECT_EQ(varchar.max, ColumnValue{"s9"});
+}
+
+TEST(StatisticsUnitTest, SampledPages)
+{
+    static constexpr std::size_t kRowCount = 100000;
+
+    // tenth of pages is read, values repeat every 100 rows
+    statistics::Builder builder{2, page::Id{1000}, 100};
+    for (std::size_t i = 0; i < kRowCount; i++)
+    {
+        builder.Add(
+            {static_cast<ColumnValueInteger>(i), static_cast<ColumnValueInteger>(i % 100)});
+    }
+    const statistics::Table table = builder.Build();
+    EXPECT_EQ(table.row_count, kRowCount * 10);
+
+    // unique values are extrapolated, repeated ones are not
+    EXPECT_NEAR(table.columns[0].distinct_count, kRowCount * 10, kRowCount * 10 * 0.05);
+    EXPECT_NEAR(table.columns[1].distinct_count, 100, 5);
+}
+
+TEST(StatisticsUnitTest, Selectivity)
+{
+    // values 0 to 800 with the same number of rows in each bucket, fifth of rows is NULL
+    const statistics::Column column{
+        .null_fraction  = 0.2,
+        .distinct_count = 800,
+        .average_size   = 0.8 * sizeof(ColumnValueInteger),
+        .min            = ColumnValueInteger{0},
+        .max            = ColumnValueInteger{800},
+        .bounds         = {ColumnValueInteger{100}, ColumnValueInteger{200},
+                           ColumnValueInteger{300}, ColumnValueInteger{400},
+                           ColumnValueInteger{500}, ColumnValueInteger{600},
+                           ColumnValueInteger{700}},
+    };
+    const auto estimate = [&column](Op2 op, ColumnValue value)
+    { return statistics::EstimateSelectivity(column, op, value); };
+
+    EXPECT_NEAR(estimate(Op2::kCompEq, ColumnValueInteger{10}), 0.8 / 800, 1e-9);
+    EXPECT_DOUBLE_EQ(estimate(Op2::kCompEq, ColumnValueInteger{1000}), 0);
+    EXPECT_NEAR(estimate(Op2::kCompL, ColumnValueInteger{200}), 0.8 * 0.25, 1e-9);
+    EXPECT_NEAR(estimate(Op2::kCompL, ColumnValueInteger{250}), 0.8 * 0.3125, 1e-9);
+    EXPECT_NEAR(estimate(Op2::kCompGe, ColumnValueReal{250}), 0.8 * 0.6875, 1e-9);
+    EXPECT_DOUBLE_EQ(estimate(Op2::kCompL, ColumnValueInteger{-1}), 0);
+    EXPECT_DOUBLE_EQ(estimate(Op2::kCompGe, ColumnValueInteger{-1}), 0.8);
+    EXPECT_DOUBLE_EQ(estimate(Op2::kCompG, ColumnValueInteger{900}), 0);
+    EXPECT_DOUBLE_EQ(estimate(Op2::kCompEq, ColumnValue{}), 0);
+
+    const statistics::Column other{.null_fraction  = 0,
+                                   .distinct_count = 100,
+                                   .average_size   = sizeof(ColumnValueInteger),
+                                   .min            = ColumnValueInteger{0},
+                                   .max            = ColumnValueInteger{99},
+                                   .bounds         = {}};
+    EXPECT_NEAR(statistics::EstimateJoinSelectivity(column, other), 0.8 / 800, 1e-9);
+}